@@ -0,0 +1,7 @@
+// camera.c as the program builds it without MATHF_INLINE: every math helper
+// is a call into mathf_call.c
+#undef MATHF_INLINE
+#define CAMERA_BENCH_NAME(name) call_##name
+#include "camera_names.h"
+
+#include "camera.c"
@@ -0,0 +1,8 @@
+// camera.c with the math library inlined from mathf.h
+#ifndef MATHF_INLINE
+#define MATHF_INLINE
+#endif
+#define CAMERA_BENCH_NAME(name) inline_##name
+#include "camera_names.h"
+
+#include "camera.c"
@@ -0,0 +1,35 @@
+// renames camera.c's public symbols so the bench can link one copy built
+// against the out-of-line math and one built against the inline header.
+// define CAMERA_BENCH_NAME(name) before including
+
+#define camera_create_fps CAMERA_BENCH_NAME(camera_create_fps)
+#define camera_create_orbit CAMERA_BENCH_NAME(camera_create_orbit)
+#define camera_create_free CAMERA_BENCH_NAME(camera_create_free)
+#define camera_view_matrix CAMERA_BENCH_NAME(camera_view_matrix)
+#define camera_projection_matrix CAMERA_BENCH_NAME(camera_projection_matrix)
+#define camera_view_projection_matrix \
+    CAMERA_BENCH_NAME(camera_view_projection_matrix)
+#define camera_inverse_view_matrix CAMERA_BENCH_NAME(camera_inverse_view_matrix)
+#define camera_inverse_view_projection_matrix \
+    CAMERA_BENCH_NAME(camera_inverse_view_projection_matrix)
+#define camera_mvp_matrix CAMERA_BENCH_NAME(camera_mvp_matrix)
+#define camera_frustum CAMERA_BENCH_NAME(camera_frustum)
+#define camera_move_forward CAMERA_BENCH_NAME(camera_move_forward)
+#define camera_move_backward CAMERA_BENCH_NAME(camera_move_backward)
+#define camera_move_left CAMERA_BENCH_NAME(camera_move_left)
+#define camera_move_right CAMERA_BENCH_NAME(camera_move_right)
+#define camera_move_up CAMERA_BENCH_NAME(camera_move_up)
+#define camera_move_down CAMERA_BENCH_NAME(camera_move_down)
+#define camera_process_mouse CAMERA_BENCH_NAME(camera_process_mouse)
+#define camera_orbit CAMERA_BENCH_NAME(camera_orbit)
+#define camera_zoom CAMERA_BENCH_NAME(camera_zoom)
+#define camera_update CAMERA_BENCH_NAME(camera_update)
+#define camera_update_vectors CAMERA_BENCH_NAME(camera_update_vectors)
+#define camera_set_aspect_ratio CAMERA_BENCH_NAME(camera_set_aspect_ratio)
+#define camera_look_at CAMERA_BENCH_NAME(camera_look_at)
+#define camera_interpolate CAMERA_BENCH_NAME(camera_interpolate)
+#define camera_views_reset CAMERA_BENCH_NAME(camera_views_reset)
+#define camera_views_add_cascades CAMERA_BENCH_NAME(camera_views_add_cascades)
+#define camera_views_add_cube CAMERA_BENCH_NAME(camera_views_add_cube)
+#define camera_views_add_mirror CAMERA_BENCH_NAME(camera_views_add_mirror)
+#define camera_views_update CAMERA_BENCH_NAME(camera_views_update)
@@ -0,0 +1,167 @@
+// camera throughput with the math library called out of line (mathf.c) and
+// inlined from the header (MATHF_INLINE). camera.c is built twice under
+// different names, see camera_names.h
+//
+//   ./build release camerabench && ./bin/camerabench
+
+#include <stdio.h>
+
+#include "base.h"
+#include "camera.h"
+#include "mathf.h"
+#include "time_util.h"
+
+#define BENCH_OPS 10000000
+#define BENCH_DT (1.0f / 60.0f)
+#define BENCH_FRAMES 1000000
+#define BENCH_EVENTS 8  // mouse events per frame
+
+typedef void (*move_fn)(camera* cam, float delta_time);
+
+typedef struct {
+    const char* name;
+    camera (*create_fps)(vec3 position, float fov, float aspect, float near_plane,
+                         float far_plane);
+    camera (*create_orbit)(vec3 target, float distance, float fov, float aspect,
+                           float near_plane, float far_plane);
+    move_fn move[6];
+    void (*update_vectors)(camera* cam);
+    void (*process_mouse)(camera* cam, float x, float y, int constrain_pitch);
+    void (*update)(camera* cam);
+    mat4 (*mvp_matrix)(camera* cam, const mat4* model);
+} bench_mode;
+
+#define BENCH_DECLARE(prefix)                                                     \
+    camera prefix##camera_create_fps(vec3, float, float, float, float);          \
+    camera prefix##camera_create_orbit(vec3, float, float, float, float, float); \
+    void   prefix##camera_move_forward(camera*, float);                          \
+    void   prefix##camera_move_backward(camera*, float);                         \
+    void   prefix##camera_move_left(camera*, float);                             \
+    void   prefix##camera_move_right(camera*, float);                            \
+    void   prefix##camera_move_up(camera*, float);                               \
+    void   prefix##camera_move_down(camera*, float);                             \
+    void   prefix##camera_update_vectors(camera*);                               \
+    void   prefix##camera_process_mouse(camera*, float, float, int);             \
+    void   prefix##camera_update(camera*);                                       \
+    mat4   prefix##camera_mvp_matrix(camera*, const mat4*);
+
+#define BENCH_MODE(label, prefix)                                             \
+    {                                                                         \
+        label, prefix##camera_create_fps, prefix##camera_create_orbit,        \
+            {prefix##camera_move_forward, prefix##camera_move_backward,       \
+             prefix##camera_move_left, prefix##camera_move_right,             \
+             prefix##camera_move_up, prefix##camera_move_down},               \
+            prefix##camera_update_vectors, prefix##camera_process_mouse,      \
+            prefix##camera_update, prefix##camera_mvp_matrix,                 \
+    }
+
+BENCH_DECLARE(call_)
+BENCH_DECLARE(inline_)
+
+static const char* g_move_names[6] = {
+    "move_forward", "move_backward", "move_left",
+    "move_right",   "move_up",       "move_down",
+};
+
+static volatile float g_sink;
+
+// alternate directions so the camera stays near the origin and the orbit
+// camera's distance check keeps taking the same branch
+static double time_move(camera cam, move_fn fn, move_fn undo) {
+    time_p start = time_now();
+    for (uint32_t i = 0; i < BENCH_OPS; i += 2) {
+        fn(&cam, BENCH_DT);
+        undo(&cam, BENCH_DT);
+    }
+    time_p end = time_now();
+    g_sink = cam.position.x;
+    return time_diff_sec(start, end) * 1e9 / BENCH_OPS;
+}
+
+static double time_update(camera cam, void (*update)(camera* cam)) {
+    time_p start = time_now();
+    for (uint32_t i = 0; i < BENCH_OPS; i++) {
+        cam.yaw += 0.01f;
+        update(&cam);
+    }
+    time_p end = time_now();
+    g_sink = cam.front.x;
+    return time_diff_sec(start, end) * 1e9 / BENCH_OPS;
+}
+
+// a frame's worth of mouse events folded into one update
+static double time_mouse_frame(camera cam, const bench_mode* mode) {
+    time_p start = time_now();
+    for (uint32_t i = 0; i < BENCH_FRAMES; i++) {
+        for (uint32_t e = 0; e < BENCH_EVENTS; e++) {
+            float dx = (i + e) & 1 ? 0.5f : -0.25f;
+            mode->process_mouse(&cam, dx, 0.1f * dx, 1);
+        }
+        mode->update(&cam);
+    }
+    time_p end = time_now();
+    g_sink = cam.front.x;
+    return time_diff_sec(start, end) * 1e9 / BENCH_FRAMES;
+}
+
+// the per object cost once the frame's view projection is cached
+static double time_mvp(camera cam, const bench_mode* mode) {
+    mat4 model = mat4_translation((vec3){1.0f, 2.0f, 3.0f});
+    mode->update(&cam);
+    time_p start = time_now();
+    for (uint32_t i = 0; i < BENCH_OPS; i++) {
+        model.m[12] = (float)(i & 255);
+        mat4 mvp = mode->mvp_matrix(&cam, &model);
+        g_sink = mvp.m[12];
+    }
+    time_p end = time_now();
+    return time_diff_sec(start, end) * 1e9 / BENCH_OPS;
+}
+
+static void run_camera(const char* label, const bench_mode* modes, camera* cams) {
+    printf("%s camera\n", label);
+    printf("  %-16s %10s %10s %8s\n", "function", "call ns", "inline ns",
+           "speedup");
+    for (uint32_t f = 0; f < 6; f++) {
+        double ns[2];
+        for (uint32_t m = 0; m < 2; m++) {
+            ns[m] = time_move(cams[m], modes[m].move[f], modes[m].move[f ^ 1]);
+        }
+        printf("  %-16s %10.2f %10.2f %7.2fx\n", g_move_names[f], ns[0], ns[1],
+               ns[0] / ns[1]);
+    }
+    double ns[2];
+    for (uint32_t m = 0; m < 2; m++) {
+        ns[m] = time_update(cams[m], modes[m].update_vectors);
+    }
+    printf("  %-16s %10.2f %10.2f %7.2fx\n", "update_vectors", ns[0], ns[1],
+           ns[0] / ns[1]);
+    for (uint32_t m = 0; m < 2; m++) ns[m] = time_mouse_frame(cams[m], &modes[m]);
+    printf("  %-16s %10.2f %10.2f %7.2fx  (%d events + update)\n", "mouse_frame",
+           ns[0], ns[1], ns[0] / ns[1], BENCH_EVENTS);
+    for (uint32_t m = 0; m < 2; m++) ns[m] = time_mvp(cams[m], &modes[m]);
+    printf("  %-16s %10.2f %10.2f %7.2fx  (cached view projection)\n\n",
+           "mvp_matrix", ns[0], ns[1], ns[0] / ns[1]);
+}
+
+int main(void) {
+    const bench_mode modes[2] = {
+        BENCH_MODE("call", call_),
+        BENCH_MODE("inline", inline_),
+    };
+
+    camera fps[2], orbit[2];
+    for (uint32_t m = 0; m < 2; m++) {
+        fps[m] = modes[m].create_fps((vec3){0.0f, 1.0f, 5.0f}, 1.0f, 16.0f / 9.0f,
+                                     0.1f, 1000.0f);
+        orbit[m] = modes[m].create_orbit((vec3){0.0f, 0.0f, 0.0f}, 10.0f, 1.0f,
+                                         16.0f / 9.0f, 0.1f, 1000.0f);
+    }
+
+    printf("%d calls per function, math backend %s\n\n", BENCH_OPS, MATHF_BACKEND);
+    run_camera("fps", modes, fps);
+    run_camera("orbit", modes, orbit);
+    return 0;
+}
+
+#include "time_posix.c"
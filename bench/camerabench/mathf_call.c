@@ -0,0 +1,3 @@
+// the out-of-line math library for camera_call.c
+#undef MATHF_INLINE
+#include "mathf.c"
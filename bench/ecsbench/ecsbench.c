@@ -0,0 +1,226 @@
+// ecs throughput at 1M entities: spawning, a position += velocity query over
+// the chunks, the same update over a plain structure of arrays (the ceiling)
+// and over an array of fat game objects (what the query replaces), random
+// lookups by id, and the query again after despawning half the entities. the
+// query and the soa loop must agree on the result
+//
+//   ./build release ecsbench && ./bin/ecsbench
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "base.h"
+#include "core/ecs.h"
+#include "core/mem.h"
+#include "math_types.h"
+#include "time_util.h"
+
+#define BENCH_ENTITIES 1000000
+#define BENCH_REPS 10  // best of
+#define BENCH_DT (1.0f / 120.0f)
+
+// one entity in four carries health, one in four is frozen and skipped
+typedef struct {
+    ecs_component position;
+    ecs_component velocity;
+    ecs_component health;
+    ecs_component frozen;  // a tag, no data
+} bench_components;
+
+// a typical object-per-entity layout: everything the entity might need, in
+// one struct, with a flag instead of an archetype
+typedef struct {
+    vec3     position;
+    vec3     velocity;
+    float    health;
+    uint32_t flags;
+    float    transform[16];
+    uint32_t mesh;
+    uint32_t material;
+} game_object;
+
+#define GAME_OBJECT_FROZEN 0x1
+
+static vec3 start_velocity(uint32_t i) {
+    return (vec3){(float)(i % 7) - 3.0f, (float)(i % 5) * 0.5f, (float)(i % 3)};
+}
+
+static int frozen(uint32_t i) { return i % 4 == 3; }
+
+static double sum_x(const vec3* v, uint32_t count) {
+    double sum = 0.0;
+    for (uint32_t i = 0; i < count; i++) sum += v[i].x + v[i].y + v[i].z;
+    return sum;
+}
+
+static void ecs_integrate(ecs_world* world, const ecs_query* query) {
+    ecs_iter it = ecs_query_iter(world, query);
+    while (ecs_iter_next(&it)) {
+        vec3*       p = it.columns[0];
+        const vec3* v = it.columns[1];
+        for (uint32_t i = 0; i < it.count; i++) {
+            p[i].x += v[i].x * BENCH_DT;
+            p[i].y += v[i].y * BENCH_DT;
+            p[i].z += v[i].z * BENCH_DT;
+        }
+    }
+}
+
+static double ecs_checksum(ecs_world* world, const ecs_query* query) {
+    double   sum = 0.0;
+    ecs_iter it = ecs_query_iter(world, query);
+    while (ecs_iter_next(&it)) sum += sum_x(it.columns[0], it.count);
+    return sum;
+}
+
+static double time_ecs(ecs_world* world, const ecs_query* query, uint32_t reps) {
+    double best = 1e30;
+    for (uint32_t r = 0; r < reps; r++) {
+        time_p start = time_now();
+        ecs_integrate(world, query);
+        double ns = time_diff_sec(start, time_now()) * 1e9;
+        if (ns < best) best = ns;
+    }
+    return best;
+}
+
+int main(void) {
+    allocator* ator = allocator_create(ALLOCATOR_TYPE_TLSF, MEM_TAG_CORE,
+                                       mmega(128));
+    ecs_world  world;
+    if (ecs_init(&world, ator, BENCH_ENTITIES) != 0) return 1;
+    bench_components c = {
+        ecs_component_type(&world, vec3),
+        ecs_component_type(&world, vec3),
+        ecs_component_type(&world, float),
+        ecs_component_register(&world, 0, 1),
+    };
+    uint64_t moving = ecs_mask(c.position) | ecs_mask(c.velocity);
+    uint32_t failed = 0;
+
+    // spawned interleaved, the way a level would, so every archetype grows
+    // at once
+    ecs_entity* ids = malloc(sizeof(ecs_entity) * BENCH_ENTITIES);
+    time_p      start = time_now();
+    for (uint32_t i = 0; i < BENCH_ENTITIES; i++) {
+        uint64_t mask = moving;
+        if (i % 4 == 1) mask |= ecs_mask(c.health);
+        if (frozen(i)) mask |= ecs_mask(c.frozen);
+        ids[i] = ecs_spawn(&world, mask);
+        *ecs_get_type(&world, ids[i], vec3, c.velocity) = start_velocity(i);
+    }
+    double spawn_ns = time_diff_sec(start, time_now()) * 1e9 / BENCH_ENTITIES;
+    failed += world.alive != BENCH_ENTITIES;
+
+    ecs_query query = {{c.position, c.velocity}, 2, ecs_mask(c.frozen)};
+    uint32_t  active = ecs_query_count(&world, &query);
+    failed += active != BENCH_ENTITIES - BENCH_ENTITIES / 4;
+    double ecs_ns = time_ecs(&world, &query, BENCH_REPS);
+
+    // the ceiling: bare arrays holding exactly the active entities
+    vec3* soa_p = calloc(active, sizeof(vec3));
+    vec3* soa_v = malloc(sizeof(vec3) * active);
+    for (uint32_t i = 0, n = 0; i < BENCH_ENTITIES; i++) {
+        if (!frozen(i)) soa_v[n++] = start_velocity(i);
+    }
+    double soa_ns = 1e30;
+    for (uint32_t r = 0; r < BENCH_REPS; r++) {
+        start = time_now();
+        for (uint32_t i = 0; i < active; i++) {
+            soa_p[i].x += soa_v[i].x * BENCH_DT;
+            soa_p[i].y += soa_v[i].y * BENCH_DT;
+            soa_p[i].z += soa_v[i].z * BENCH_DT;
+        }
+        double ns = time_diff_sec(start, time_now()) * 1e9;
+        if (ns < soa_ns) soa_ns = ns;
+    }
+    double expected = sum_x(soa_p, active);
+    double got = ecs_checksum(&world, &query);
+    failed += fabs(got - expected) > 1e-6 * fabs(expected) + 1e-3;
+
+    game_object* objects = calloc(BENCH_ENTITIES, sizeof(game_object));
+    for (uint32_t i = 0; i < BENCH_ENTITIES; i++) {
+        objects[i].velocity = start_velocity(i);
+        objects[i].flags = frozen(i) ? GAME_OBJECT_FROZEN : 0;
+    }
+    double aos_ns = 1e30;
+    for (uint32_t r = 0; r < BENCH_REPS; r++) {
+        start = time_now();
+        for (uint32_t i = 0; i < BENCH_ENTITIES; i++) {
+            game_object* o = &objects[i];
+            if (o->flags & GAME_OBJECT_FROZEN) continue;
+            o->position.x += o->velocity.x * BENCH_DT;
+            o->position.y += o->velocity.y * BENCH_DT;
+            o->position.z += o->velocity.z * BENCH_DT;
+        }
+        double ns = time_diff_sec(start, time_now()) * 1e9;
+        if (ns < aos_ns) aos_ns = ns;
+    }
+
+    // lookups in a shuffled order, so each one is a cache miss or two
+    for (uint32_t i = BENCH_ENTITIES - 1; i > 0; i--) {
+        uint32_t   j = (uint32_t)rand() % (i + 1);
+        ecs_entity t = ids[i];
+        ids[i] = ids[j];
+        ids[j] = t;
+    }
+    float lookup = 0.0f;
+    start = time_now();
+    for (uint32_t i = 0; i < BENCH_ENTITIES; i++) {
+        const vec3* p = ecs_get(&world, ids[i], c.position);
+        lookup += p->x;
+    }
+    failed += lookup != lookup;  // keeps the loads
+    double get_ns = time_diff_sec(start, time_now()) * 1e9 / BENCH_ENTITIES;
+
+    // despawn every other id; swap removal keeps the chunks packed and stale
+    // ids stop resolving
+    start = time_now();
+    for (uint32_t i = 0; i < BENCH_ENTITIES; i += 2) ecs_despawn(&world, ids[i]);
+    double despawn_ns = time_diff_sec(start, time_now()) * 1e9 /
+                        (BENCH_ENTITIES / 2);
+    failed += world.alive != BENCH_ENTITIES / 2;
+    failed += ecs_alive(&world, ids[0]) || ecs_get(&world, ids[0], c.position);
+    uint32_t remaining = ecs_query_count(&world, &query);
+    double   half_ns = time_ecs(&world, &query, BENCH_REPS);
+
+    // refill the freed indices a whole batch at a time
+    start = time_now();
+    uint32_t refilled = ecs_spawn_n(&world, moving, BENCH_ENTITIES / 2, NULL);
+    double   batch_ns = time_diff_sec(start, time_now()) * 1e9 /
+                      (BENCH_ENTITIES / 2);
+    failed += refilled != BENCH_ENTITIES / 2 || world.alive != BENCH_ENTITIES;
+    failed += ecs_alive(&world, ids[0]);
+
+    printf("%d entities, %u moving, best of %d\n", BENCH_ENTITIES, active,
+           BENCH_REPS);
+    printf("  %-28s %8.2f ns/entity\n", "spawn + set velocity", spawn_ns);
+    printf("  %-28s %8.2f ns/entity %8.2f ms\n", "query, ecs chunks",
+           ecs_ns / active, ecs_ns / 1e6);
+    printf("  %-28s %8.2f ns/entity %8.2f ms\n", "plain soa arrays",
+           soa_ns / active, soa_ns / 1e6);
+    printf("  %-28s %8.2f ns/entity %8.2f ms\n", "game_object array",
+           aos_ns / active, aos_ns / 1e6);
+    printf("  %-28s %8.2f ns/entity\n", "ecs_get, random order", get_ns);
+    printf("  %-28s %8.2f ns/entity\n", "despawn half", despawn_ns);
+    printf("  %-28s %8.2f ns/entity %8.2f ms (%u left)\n", "query after despawn",
+           half_ns / remaining, half_ns / 1e6, remaining);
+    printf("  %-28s %8.2f ns/entity\n", "ecs_spawn_n, reused ids", batch_ns);
+    printf("%s\n", failed ? "FAILED" : "ok");
+
+    free(objects);
+    free(soa_p);
+    free(soa_v);
+    free(ids);
+    ecs_destroy(&world);
+    adestroy(ator);
+    return failed ? 1 : 0;
+}
+
+#include "base.c"
+#include "core/ecs.c"
+#include "core/mem.c"
+#include "core/os_linux.c"
+#include "time_posix.c"
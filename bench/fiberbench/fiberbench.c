@@ -0,0 +1,245 @@
+// fiber switch cost against swapcontext, the round trip of a job that waits
+// on a child, and a 1000 job frame graph run three ways: layer by layer on
+// the plain pool, layer by layer on fibers, and all at once on fibers with
+// every job waiting on its own dependencies. the graph run checks that no job
+// started before its dependencies were done
+//
+//   ./build release fiberbench && ./bin/fiberbench [threads]
+
+#include <math.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <ucontext.h>
+#include <unistd.h>
+
+#include "base.h"
+#include "core/fiber.h"
+#include "core/job.h"
+#include "core/mem.h"
+#include "time_util.h"
+
+#define BENCH_SWITCHES 10000000
+#define BENCH_UC_SWITCHES 1000000  // a system call each, fewer of them
+#define BENCH_WAITS 100000
+#define BENCH_LAYERS 10
+#define BENCH_WIDTH 100  // jobs per layer
+#define BENCH_NODES (BENCH_LAYERS * BENCH_WIDTH)
+#define BENCH_WORK 256  // iterations per graph job, around a microsecond
+#define BENCH_FRAMES 200
+#define BENCH_FIBERS (BENCH_NODES + JOB_MAX_THREADS)
+
+static fiber    g_main;
+static fiber    g_other;
+static uint64_t g_ping;
+
+static void ping_main(void* arg) {
+    unused(arg);
+    for (;;) {
+        g_ping++;
+        fiber_switch(&g_other, &g_main);
+    }
+}
+
+// one iteration is two switches, there and back
+static double time_fiber_switch(void) {
+    fiber_from_thread(&g_main);
+    if (fiber_create(&g_other, 0, ping_main, NULL) != 0) return 0.0;
+    time_p start = time_now();
+    for (uint32_t i = 0; i < BENCH_SWITCHES / 2; i++) fiber_switch(&g_main, &g_other);
+    double ns = time_diff_sec(start, time_now()) * 1e9 / BENCH_SWITCHES;
+    fiber_destroy(&g_other);
+    return g_ping == BENCH_SWITCHES / 2 ? ns : 0.0;
+}
+
+static ucontext_t g_uc_main;
+static ucontext_t g_uc_other;
+
+static void uc_main(void) {
+    for (;;) {
+        g_ping++;
+        swapcontext(&g_uc_other, &g_uc_main);
+    }
+}
+
+static double time_ucontext_switch(void) {
+    static char stack[FIBER_STACK_SIZE];
+    getcontext(&g_uc_other);
+    g_uc_other.uc_stack.ss_sp = stack;
+    g_uc_other.uc_stack.ss_size = sizeof(stack);
+    g_uc_other.uc_link = NULL;
+    makecontext(&g_uc_other, uc_main, 0);
+    time_p start = time_now();
+    for (uint32_t i = 0; i < BENCH_UC_SWITCHES / 2; i++) {
+        swapcontext(&g_uc_main, &g_uc_other);
+    }
+    return time_diff_sec(start, time_now()) * 1e9 / BENCH_UC_SWITCHES;
+}
+
+static void wait_child(void* data, uint32_t index) {
+    unused(index);
+    atomic_fetch_add_explicit((_Atomic uint32_t*)data, 1, memory_order_relaxed);
+}
+
+// queues a child and waits for it. the child sits on top of the deque, so
+// the wait parks the parent, the freed thread runs the child, and the drain
+// resumes the parent
+static void wait_parent(void* data, uint32_t index) {
+    unused(index);
+    job_counter counter;
+    job_counter_init(&counter, NULL);
+    job_run_n(wait_child, data, 1, &counter);
+    job_wait(&counter);
+}
+
+static double time_wait(uint32_t* failed) {
+    _Atomic uint32_t runs = 0;
+    job_counter      counter;
+    job_counter_init(&counter, NULL);
+    time_p start = time_now();
+    for (uint32_t i = 0; i < BENCH_WAITS; i++) {
+        job_run_n(wait_parent, (void*)&runs, 1, &counter);
+        job_wait(&counter);
+    }
+    double ns = time_diff_sec(start, time_now()) * 1e9 / BENCH_WAITS;
+    *failed += atomic_load(&runs) != BENCH_WAITS;
+    return ns;
+}
+
+// a layer's jobs each read two jobs of the layer before
+typedef struct {
+    job_counter      counters[BENCH_NODES];
+    uint32_t         deps[BENCH_NODES][2];
+    _Atomic uint32_t done[BENCH_NODES];
+    _Atomic uint32_t early;  // jobs that ran before a dependency finished
+    float            values[BENCH_NODES];
+    int              wait_deps;
+} bench_graph;
+
+static bench_graph g_graph;
+
+static void graph_node(void* data, uint32_t node) {
+    bench_graph* g = data;
+    float        x = (float)node;
+    if (node >= BENCH_WIDTH) {
+        for (uint32_t d = 0; d < 2; d++) {
+            uint32_t dep = g->deps[node][d];
+            if (g->wait_deps) job_wait(&g->counters[dep]);
+            if (!atomic_load_explicit(&g->done[dep], memory_order_acquire)) {
+                atomic_fetch_add_explicit(&g->early, 1, memory_order_relaxed);
+            }
+            x += g->values[dep];
+        }
+    }
+    for (uint32_t k = 0; k < BENCH_WORK; k++) x = x * 0.999f + sqrtf(x + 1.0f);
+    g->values[node] = x;
+    atomic_store_explicit(&g->done[node], 1, memory_order_release);
+}
+
+static void graph_reset(bench_graph* g, job_counter* frame) {
+    for (uint32_t i = 0; i < BENCH_NODES; i++) {
+        job_counter_init(&g->counters[i], frame);
+        atomic_store_explicit(&g->done[i], 0, memory_order_relaxed);
+    }
+    job_counter_init(frame, NULL);
+}
+
+// each layer queued once the one before has drained
+static double time_graph_layers(uint32_t* failed) {
+    bench_graph* g = &g_graph;
+    g->wait_deps = 0;
+    atomic_store(&g->early, 0);
+    double best = 1e30;
+    for (uint32_t f = 0; f < BENCH_FRAMES; f++) {
+        job_counter frame;
+        graph_reset(g, &frame);
+        time_p start = time_now();
+        for (uint32_t l = 0; l < BENCH_LAYERS; l++) {
+            job_desc jobs[BENCH_WIDTH];
+            for (uint32_t i = 0; i < BENCH_WIDTH; i++) {
+                jobs[i] = (job_desc){graph_node, g, l * BENCH_WIDTH + i};
+            }
+            job_run(jobs, BENCH_WIDTH, &frame);
+            job_wait(&frame);
+        }
+        double ns = time_diff_sec(start, time_now()) * 1e9;
+        if (ns < best) best = ns;
+    }
+    *failed += atomic_load(&g->early);
+    return best;
+}
+
+// every job queued up front and waiting on its own dependencies. they are
+// queued in order so a dependency's counter is already up by the time a job
+// that waits on it can be stolen; the owner pops the last layer first and
+// parks it, thieves take the oldest
+static double time_graph_waits(uint32_t* failed) {
+    bench_graph* g = &g_graph;
+    g->wait_deps = 1;
+    atomic_store(&g->early, 0);
+    double best = 1e30;
+    for (uint32_t f = 0; f < BENCH_FRAMES; f++) {
+        job_counter frame;
+        graph_reset(g, &frame);
+        time_p start = time_now();
+        for (uint32_t i = 0; i < BENCH_NODES; i++) {
+            job_desc job = {graph_node, g, i};
+            job_run(&job, 1, &g->counters[i]);
+        }
+        job_wait(&frame);
+        double ns = time_diff_sec(start, time_now()) * 1e9;
+        if (ns < best) best = ns;
+        for (uint32_t i = 0; i < BENCH_NODES; i++) *failed += !g->done[i];
+    }
+    *failed += atomic_load(&g->early);
+    return best;
+}
+
+int main(int argc, char** argv) {
+    long threads = argc > 1 ? atol(argv[1]) : sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads < 1) threads = 1;
+    if (threads > JOB_MAX_THREADS) threads = JOB_MAX_THREADS;
+
+    srand(1);
+    for (uint32_t i = BENCH_WIDTH; i < BENCH_NODES; i++) {
+        uint32_t layer = i / BENCH_WIDTH - 1;
+        g_graph.deps[i][0] = layer * BENCH_WIDTH + i % BENCH_WIDTH;
+        g_graph.deps[i][1] = layer * BENCH_WIDTH + (uint32_t)rand() % BENCH_WIDTH;
+    }
+
+    printf("fiber switch (%s) %8.2f ns\n", FIBER_BACKEND, time_fiber_switch());
+    printf("swapcontext        %8.2f ns\n\n", time_ucontext_switch());
+
+    allocator* ator = allocator_create(ALLOCATOR_TYPE_TLSF, MEM_TAG_CORE,
+                                       mmega(16));
+    uint32_t failed = 0;
+
+    if (job_init(ator, (uint32_t)threads) != 0) return 1;
+    double plain_layers = time_graph_layers(&failed);
+    job_shutdown();
+
+    if (job_init_ex(ator, (uint32_t)threads, BENCH_FIBERS, 0) != 0) return 1;
+    double wait_ns = time_wait(&failed);
+    double fiber_layers = time_graph_layers(&failed);
+    double fiber_waits = time_graph_waits(&failed);
+    job_shutdown();
+
+    printf("wait on a child job %8.2f ns round trip\n\n", wait_ns);
+    printf("frame graph: %d jobs in %d layers, %ld threads, best of %d\n",
+           BENCH_NODES, BENCH_LAYERS, threads, BENCH_FRAMES);
+    printf("  %-24s %10.1f us\n", "layers, plain pool", plain_layers / 1e3);
+    printf("  %-24s %10.1f us\n", "layers, fibers", fiber_layers / 1e3);
+    printf("  %-24s %10.1f us\n", "dependency waits, fibers", fiber_waits / 1e3);
+    printf("%s\n", failed ? "FAILED" : "ok");
+
+    adestroy(ator);
+    return failed ? 1 : 0;
+}
+
+#include "base.c"
+#include "core/fiber.c"
+#include "core/job.c"
+#include "core/mem.c"
+#include "core/os_linux.c"
+#include "core/os_thread_linux.c"
+#include "time_posix.c"
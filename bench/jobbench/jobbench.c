@@ -0,0 +1,180 @@
+// job system scaling: a compute bound parallel_for timed at 1, 2, 4 .. max
+// threads, the cost of a tiny job, and a nested parent/child counter check.
+// every run also checks that each index was visited exactly once
+//
+//   ./build release jobbench && ./bin/jobbench [max threads]
+
+#include <math.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "base.h"
+#include "core/job.h"
+#include "core/mem.h"
+#include "core/os_thread.h"
+#include "time_util.h"
+
+#define BENCH_COUNT (1 << 21)  // parallel_for elements
+#define BENCH_GRAIN 2048
+#define BENCH_ITERS 32  // work per element, enough to be compute bound
+#define BENCH_REPS 5    // best of
+#define BENCH_TINY_ROUNDS 1024
+#define BENCH_TINY_BATCH 1024  // jobs per job_run_n, below JOB_DEQUE_SIZE
+#define BENCH_PARENTS 64
+#define BENCH_CHILDREN 256
+
+typedef struct {
+    float*    values;
+    uint32_t* visits;
+} bench_for;
+
+// a short dependent chain per element, no memory traffic to speak of
+static void bench_for_range(void* data, uint32_t begin, uint32_t end) {
+    bench_for* b = data;
+    for (uint32_t i = begin; i < end; i++) {
+        float x = (float)i * 1e-6f;
+        for (uint32_t k = 0; k < BENCH_ITERS; k++) {
+            x = x * 0.999f + sqrtf(x + 1.0f);
+        }
+        b->values[i] = x;
+        b->visits[i]++;
+    }
+}
+
+static _Atomic uint32_t g_tiny_runs;
+
+static void bench_tiny(void* data, uint32_t index) {
+    unused(data);
+    unused(index);
+    atomic_fetch_add_explicit(&g_tiny_runs, 1, memory_order_relaxed);
+}
+
+typedef struct {
+    job_counter      counters[BENCH_PARENTS];
+    _Atomic uint32_t done[BENCH_PARENTS];
+    job_counter*     root;
+} bench_tree;
+
+static void bench_child(void* data, uint32_t index) {
+    bench_tree* t = data;
+    atomic_fetch_add_explicit(&t->done[index / BENCH_CHILDREN], 1,
+                              memory_order_relaxed);
+}
+
+static job_desc g_children[BENCH_PARENTS * BENCH_CHILDREN];
+
+// spawns its children under its own counter and returns without waiting; the
+// root counter stays pending until they finish
+static void bench_parent(void* data, uint32_t index) {
+    bench_tree* t = data;
+    job_counter_init(&t->counters[index], t->root);
+    job_run(&g_children[index * BENCH_CHILDREN], BENCH_CHILDREN,
+            &t->counters[index]);
+}
+
+// 0 when every child ran before the root drained
+static uint32_t run_tree(void) {
+    static bench_tree t;
+    job_counter       root;
+    job_counter_init(&root, NULL);
+    t.root = &root;
+    for (uint32_t i = 0; i < BENCH_PARENTS * BENCH_CHILDREN; i++) {
+        g_children[i] = (job_desc){bench_child, &t, i};
+    }
+    for (uint32_t i = 0; i < BENCH_PARENTS; i++) atomic_store(&t.done[i], 0);
+
+    job_run_n(bench_parent, &t, BENCH_PARENTS, &root);
+    job_wait(&root);
+    uint32_t missing = 0;
+    for (uint32_t i = 0; i < BENCH_PARENTS; i++) {
+        missing += BENCH_CHILDREN - atomic_load(&t.done[i]);
+    }
+    return missing;
+}
+
+static uint32_t run_threads(allocator* ator, uint32_t threads, bench_for* b,
+                            double* for_ns, double* tiny_ns) {
+    *for_ns = *tiny_ns = 0.0;
+    if (job_init(ator, threads) != 0) return 1;
+    uint32_t failed = 0;
+
+    *for_ns = 1e30;
+    for (uint32_t r = 0; r < BENCH_REPS; r++) {
+        memset(b->visits, 0, sizeof(uint32_t) * BENCH_COUNT);
+        time_p start = time_now();
+        job_parallel_for(BENCH_COUNT, BENCH_GRAIN, bench_for_range, b);
+        double ns = time_diff_sec(start, time_now()) * 1e9;
+        if (ns < *for_ns) *for_ns = ns;
+        for (uint32_t i = 0; i < BENCH_COUNT; i++) failed += b->visits[i] != 1;
+    }
+
+    atomic_store(&g_tiny_runs, 0);
+    job_counter counter;
+    job_counter_init(&counter, NULL);
+    time_p start = time_now();
+    for (uint32_t i = 0; i < BENCH_TINY_ROUNDS; i++) {
+        job_run_n(bench_tiny, NULL, BENCH_TINY_BATCH, &counter);
+        job_wait(&counter);
+    }
+    const uint32_t tiny_total = BENCH_TINY_ROUNDS * BENCH_TINY_BATCH;
+    *tiny_ns = time_diff_sec(start, time_now()) * 1e9 / tiny_total;
+    failed += atomic_load(&g_tiny_runs) != tiny_total;
+
+    failed += run_tree();
+    job_shutdown();
+    return failed;
+}
+
+int main(int argc, char** argv) {
+    long max_threads = argc > 1 ? atol(argv[1]) : sysconf(_SC_NPROCESSORS_ONLN);
+    if (max_threads < 1) max_threads = 1;
+    if (max_threads > JOB_MAX_THREADS) max_threads = JOB_MAX_THREADS;
+
+    // tlsf: the deques are cache line aligned
+    allocator* ator = allocator_create(ALLOCATOR_TYPE_TLSF, MEM_TAG_CORE,
+                                       mmega(16));
+    bench_for  b = {
+        malloc(sizeof(float) * BENCH_COUNT),
+        malloc(sizeof(uint32_t) * BENCH_COUNT),
+    };
+
+    os_cpu_info cpus;
+    os_cpu_topology(&cpus);
+    printf("%u logical cpus on %u cores, l1d %uK, l2 %uK, l3 %uK\n",
+           cpus.logical_count, cpus.core_count, cpus.l1d.size / 1024,
+           cpus.l2.size / 1024, cpus.l3.size / 1024);
+    printf("parallel_for: %d elements, grain %d, %d iterations each\n",
+           BENCH_COUNT, BENCH_GRAIN, BENCH_ITERS);
+    printf("  %-8s %10s %9s %10s %14s\n", "threads", "for ms", "speedup",
+           "efficiency", "tiny job ns");
+    double   base = 0.0;
+    uint32_t failed = 0;
+    for (uint32_t n = 1; n <= (uint32_t)max_threads; n *= 2) {
+        double for_ns, tiny_ns;
+        uint32_t f = run_threads(ator, n, &b, &for_ns, &tiny_ns);
+        if (n == 1) base = for_ns;
+        printf("  %-8u %10.2f %8.2fx %9.0f%% %14.1f%s\n", n, for_ns / 1e6,
+               base / for_ns, base / for_ns / n * 100.0, tiny_ns,
+               f ? "  FAILED" : "");
+        failed += f;
+        if (n < (uint32_t)max_threads && n * 2 > (uint32_t)max_threads) {
+            n = (uint32_t)max_threads / 2;
+        }
+    }
+
+    free(b.values);
+    free(b.visits);
+    adestroy(ator);
+    return failed ? 1 : 0;
+}
+
+#include "base.c"
+#include "core/fiber.c"
+#include "core/job.c"
+#include "core/mem.c"
+#include "core/os_linux.c"
+#include "core/os_thread_linux.c"
+#include "time_posix.c"
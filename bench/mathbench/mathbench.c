@@ -0,0 +1,1241 @@
+// math library benchmark and accuracy check: every mathf.h function timed per
+// call, its error taken in ulps against the double references in reference.c,
+// and the simd and batch paths checked bit for bit against the scalar ones.
+// exits non zero on any mismatch or a fast_* result outside its bound
+//
+//   ./build release mathbench && ./bin/mathbench [json]
+//   ./bin/mathbench exhaustive [sincos|rsqrt|atan2]
+//
+// json prints the results to stdout (the tables go to stderr) so two runs can
+// be diffed across a change to the math code. exhaustive walks every float in
+// the documented domain of the fast_* approximations and fails if any exceeds
+// its bound in mathf.h (several minutes on one core for all three)
+//
+// the backend follows the compiler flags (see mathf.h), add -mavx to the
+// module flags for the avx path or -DMATHF_SCALAR to time the reference alone
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "base.h"
+#include "reference.h"
+#include "time_util.h"
+
+// pulled in up front rather than at the bottom: the scalar references are
+// static to mathf.c
+#include "mathf.c"
+
+#define BENCH_INPUTS 4096  // power of two
+#define BENCH_OPS 20000000
+#define BENCH_BATCH 100000  // objects per batch kernel call
+#define BENCH_BATCH_REPS 50
+#define BENCH_MASK_VIEWS 8  // frusta per frustum_mask_* call
+#define BENCH_MASK_OVER (FRUSTUM_MASK_MAX + 8)  // past what a mask holds
+#define BENCH_MAX_OUT 24  // floats, frustum_from_mat4
+#define BENCH_MAX_RECORDS 128
+
+typedef struct {
+    vec2   u[2];
+    vec3   p[3];
+    vec4   v[2];
+    mat4   m[2];
+    quat   q[2];   // unit
+    trs    tr[2];  // scale in [0.5, 2]
+    affine a[2];   // tr as affine
+    mat4   am[2];  // tr as mat4, for the mat4 affine helpers
+    vec3   axis;   // unit
+    float  s;      // scale and divisor, [0.25, 4]
+    float  t;      // lerp parameter, [0, 1]
+    float  angle;  // [-2pi, 2pi]
+    float  f[4];   // perspective: fov, aspect, near, far
+} bench_input;
+
+// every function gets the same shape so one table drives the checks and the
+// timings. results are written out as floats (ints bit for bit)
+typedef void (*suite_call)(const bench_input* in, float* out);
+typedef void (*suite_ref)(const bench_input* in, double* out);
+
+typedef struct {
+    const char* name;
+    uint32_t    outputs;  // floats written
+    suite_call  api;      // through mathf.h, on the compiled backend
+    suite_call  scalar;   // the plain c reference, where the backend differs
+    suite_ref   ref;      // double precision, NULL for integer results
+} suite_fn;
+
+// one line of the report, and of the json
+typedef struct {
+    const char* name;
+    const char* variant;     // scalar, api, batch or libm
+    double      ns;          // per call, per element for the batch kernels
+    double      max_ulp;     // against the double reference, < 0 if not checked
+    uint32_t    mismatches;  // results differing in any bit from the api path
+} bench_record;
+
+static bench_input     g_inputs[BENCH_INPUTS];
+static frustum         g_frustum;
+static bench_record    g_records[BENCH_MAX_RECORDS];
+static uint32_t        g_record_count;
+static FILE*           g_log;  // stderr when stdout carries the json
+static volatile float  g_sink;
+static uint32_t        rng_state = 0x9e3779b9;
+
+static uint32_t rng_next(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+static float rng_float(float lo, float hi) {
+    return lo + (hi - lo) * (float)(rng_next() >> 8) / (float)(1 << 24);
+}
+
+static int g_edges = 1;
+
+// mostly ordinary values with the odd zero, negative zero and tiny one mixed
+// in, unless g_edges is off
+static float rng_input(void) {
+    switch (g_edges ? rng_next() % 64 : 63) {
+        case 0: return 0.0f;
+        case 1: return -0.0f;
+        case 2: return rng_float(-1e-30f, 1e-30f);
+        default: return rng_float(-100.0f, 100.0f);
+    }
+}
+
+static void fill_floats(void* dst, size_t size) {
+    float* raw = dst;
+    for (size_t i = 0; i < size / sizeof(float); i++) {
+        raw[i] = rng_input();
+    }
+}
+
+static vec3 rng_v3(float lo, float hi) {
+    return (vec3){rng_float(lo, hi), rng_float(lo, hi), rng_float(lo, hi)};
+}
+
+static void fill_inputs(int edges) {
+    g_edges = edges;
+    for (uint32_t i = 0; i < BENCH_INPUTS; i++) {
+        bench_input* in = &g_inputs[i];
+        fill_floats(in->u, sizeof(in->u));
+        fill_floats(in->p, sizeof(in->p));
+        fill_floats(in->v, sizeof(in->v));
+        fill_floats(in->m, sizeof(in->m));
+        for (uint32_t k = 0; k < 2; k++) {
+            vec3 axis = v3_normalize(rng_v3(-1.0f, 1.0f));
+            in->q[k] = quat_from_axis_angle(axis, rng_float(-3.14f, 3.14f));
+            in->tr[k] = (trs){rng_v3(-100.0f, 100.0f), in->q[k],
+                              rng_v3(0.5f, 2.0f)};
+            in->a[k] = trs_to_affine(in->tr[k]);
+            in->am[k] = affine_to_mat4(in->a[k]);
+        }
+        in->axis = v3_normalize(rng_v3(-1.0f, 1.0f));
+        in->s = rng_float(0.25f, 4.0f);
+        in->t = rng_float(0.0f, 1.0f);
+        in->angle = rng_float(-6.28f, 6.28f);
+        // perspective: fov, aspect, near, far in their usual ranges
+        in->f[0] = rng_float(0.1f, 3.0f);
+        in->f[1] = rng_float(0.25f, 4.0f);
+        in->f[2] = rng_float(0.01f, 1.0f);
+        in->f[3] = in->f[2] + rng_float(1.0f, 10000.0f);
+    }
+    g_edges = 1;
+}
+
+static void record(const char* name, const char* variant, double ns,
+                   double max_ulp, uint32_t mismatches) {
+    if (g_record_count == BENCH_MAX_RECORDS) return;
+    g_records[g_record_count++] =
+        (bench_record){name, variant, ns, max_ulp, mismatches};
+}
+
+// worst component error in ulps of the result's largest component, so a lane
+// that cancels to near zero is judged on the scale of its neighbours. a lone
+// float that cancels (the dots) has no neighbours and reads high
+static double ulp_error(const float* got, const double* ref, uint32_t n) {
+    double scale = 0.0, err = 0.0;
+    for (uint32_t i = 0; i < n; i++) {
+        scale = fmax(scale, fabs(ref[i]));
+        err = fmax(err, fabs((double)got[i] - ref[i]));
+        if (isnan(got[i]) != isnan(ref[i])) return INFINITY;
+    }
+    if (err == 0.0) return 0.0;
+    float fs = (float)scale;
+    return err / ((double)nextafterf(fs, INFINITY) - fs);
+}
+
+#define SUITE_CALL(fn, type, expr)                        \
+    static void fn(const bench_input* in, float* out) {   \
+        unused(in);                                       \
+        type r = expr;                                    \
+        memcpy(out, &r, sizeof(r));                       \
+    }
+
+#define SUITE_REF(fn, expr)                               \
+    static void fn(const bench_input* in, double* out) {  \
+        unused(in);                                       \
+        expr;                                             \
+    }
+
+#define F(v) (&(v).x)  // first component of a vec / quat
+#define T(t) (&(t).translation.x)
+#define Q(v) ((quat){(v).x, (v).y, (v).z, (v).w})  // any vec4, not unit
+
+static const float k_zero3[3] = {0.0f, 0.0f, 0.0f};
+
+static void ref_fill(double* out, const float* values, uint32_t n) {
+    for (uint32_t i = 0; i < n; i++) out[i] = values[i];
+}
+
+SUITE_CALL(api_deg2rad, float, deg2rad(in->v[0].x))
+SUITE_REF(ref_deg2rad, out[0] = in->v[0].x * (PI / 180.0))
+SUITE_CALL(api_rad2deg, float, rad2deg(in->v[0].x))
+SUITE_REF(ref_rad2deg, out[0] = in->v[0].x * (180.0 / PI))
+
+SUITE_CALL(api_v2_add, vec2, v2_add(in->u[0], in->u[1]))
+SUITE_REF(ref_v2_add, ref_add(F(in->u[0]), F(in->u[1]), 2, out))
+SUITE_CALL(api_v2_sub, vec2, v2_sub(in->u[0], in->u[1]))
+SUITE_REF(ref_v2_sub, ref_sub(F(in->u[0]), F(in->u[1]), 2, out))
+SUITE_CALL(api_v2_mul, vec2, v2_mul(in->u[0], in->u[1]))
+SUITE_REF(ref_v2_mul, ref_mul(F(in->u[0]), F(in->u[1]), 2, out))
+SUITE_CALL(api_v2_scale, vec2, v2_scale(in->u[0], in->s))
+SUITE_REF(ref_v2_scale, ref_scale(F(in->u[0]), in->s, 2, out))
+SUITE_CALL(api_v2_div, vec2, v2_div(in->u[0], in->s))
+SUITE_REF(ref_v2_div, ref_div(F(in->u[0]), in->s, 2, out))
+SUITE_CALL(api_v2_normalize, vec2, v2_normalize(in->u[0]))
+SUITE_REF(ref_v2_normalize, ref_normalize(F(in->u[0]), 2, out))
+SUITE_CALL(api_v2_lerp, vec2, v2_lerp(in->u[0], in->u[1], in->t))
+SUITE_REF(ref_v2_lerp, ref_lerp(F(in->u[0]), F(in->u[1]), in->t, 2, out))
+SUITE_CALL(api_v2_dot, float, v2_dot(in->u[0], in->u[1]))
+SUITE_REF(ref_v2_dot, ref_dot(F(in->u[0]), F(in->u[1]), 2, out))
+SUITE_CALL(api_v2_length, float, v2_length(in->u[0]))
+SUITE_REF(ref_v2_length, ref_length(F(in->u[0]), 2, out))
+
+SUITE_CALL(api_v3_zero, vec3, v3_zero())
+SUITE_REF(ref_v3_zero, ref_fill(out, k_zero3, 3))
+SUITE_CALL(api_v3_one, vec3, v3_one())
+SUITE_REF(ref_v3_one, out[0] = out[1] = out[2] = 1.0)
+SUITE_CALL(api_v3_left, vec3, v3_left())
+SUITE_REF(ref_v3_left, ref_fill(out, (float[3]){-1.0f, 0.0f, 0.0f}, 3))
+SUITE_CALL(api_v3_right, vec3, v3_right())
+SUITE_REF(ref_v3_right, ref_fill(out, (float[3]){1.0f, 0.0f, 0.0f}, 3))
+SUITE_CALL(api_v3_up, vec3, v3_up())
+SUITE_REF(ref_v3_up, ref_fill(out, (float[3]){0.0f, 1.0f, 0.0f}, 3))
+SUITE_CALL(api_v3_add, vec3, v3_add(in->p[0], in->p[1]))
+SUITE_REF(ref_v3_add, ref_add(F(in->p[0]), F(in->p[1]), 3, out))
+SUITE_CALL(api_v3_sub, vec3, v3_sub(in->p[0], in->p[1]))
+SUITE_REF(ref_v3_sub, ref_sub(F(in->p[0]), F(in->p[1]), 3, out))
+SUITE_CALL(api_v3_mul, vec3, v3_mul(in->p[0], in->p[1]))
+SUITE_REF(ref_v3_mul, ref_mul(F(in->p[0]), F(in->p[1]), 3, out))
+SUITE_CALL(api_v3_scale, vec3, v3_scale(in->p[0], in->s))
+SUITE_REF(ref_v3_scale, ref_scale(F(in->p[0]), in->s, 3, out))
+SUITE_CALL(api_v3_div, vec3, v3_div(in->p[0], in->s))
+SUITE_REF(ref_v3_div, ref_div(F(in->p[0]), in->s, 3, out))
+SUITE_CALL(api_v3_cross, vec3, v3_cross(in->p[0], in->p[1]))
+SUITE_REF(ref_v3_cross, ref_cross(F(in->p[0]), F(in->p[1]), out))
+SUITE_CALL(api_v3_normalize, vec3, v3_normalize(in->p[0]))
+SUITE_REF(ref_v3_normalize, ref_normalize(F(in->p[0]), 3, out))
+SUITE_CALL(api_v3_lerp, vec3, v3_lerp(in->p[0], in->p[1], in->t))
+SUITE_REF(ref_v3_lerp, ref_lerp(F(in->p[0]), F(in->p[1]), in->t, 3, out))
+SUITE_CALL(api_v3_length, float, v3_length(in->p[0]))
+SUITE_REF(ref_v3_length, ref_length(F(in->p[0]), 3, out))
+SUITE_CALL(api_v3_dot, float, v3_dot(in->p[0], in->p[1]))
+SUITE_REF(ref_v3_dot, ref_dot(F(in->p[0]), F(in->p[1]), 3, out))
+
+SUITE_CALL(api_v4_add, vec4, v4_add(in->v[0], in->v[1]))
+SUITE_CALL(scalar_v4_add, vec4, v4_add_scalar(in->v[0], in->v[1]))
+SUITE_REF(ref_v4_add, ref_add(F(in->v[0]), F(in->v[1]), 4, out))
+SUITE_CALL(api_v4_sub, vec4, v4_sub(in->v[0], in->v[1]))
+SUITE_CALL(scalar_v4_sub, vec4, v4_sub_scalar(in->v[0], in->v[1]))
+SUITE_REF(ref_v4_sub, ref_sub(F(in->v[0]), F(in->v[1]), 4, out))
+SUITE_CALL(api_v4_mul, vec4, v4_mul(in->v[0], in->v[1]))
+SUITE_CALL(scalar_v4_mul, vec4, v4_mul_scalar(in->v[0], in->v[1]))
+SUITE_REF(ref_v4_mul, ref_mul(F(in->v[0]), F(in->v[1]), 4, out))
+SUITE_CALL(api_v4_scale, vec4, v4_scale(in->v[0], in->s))
+SUITE_CALL(scalar_v4_scale, vec4, v4_scale_scalar(in->v[0], in->s))
+SUITE_REF(ref_v4_scale, ref_scale(F(in->v[0]), in->s, 4, out))
+SUITE_CALL(api_v4_div, vec4, v4_div(in->v[0], in->s))
+SUITE_CALL(scalar_v4_div, vec4, v4_div_scalar(in->v[0], in->s))
+SUITE_REF(ref_v4_div, ref_div(F(in->v[0]), in->s, 4, out))
+SUITE_CALL(api_v4_normalize, vec4, v4_normalize(in->v[0]))
+SUITE_CALL(scalar_v4_normalize, vec4, v4_normalize_scalar(in->v[0]))
+SUITE_REF(ref_v4_normalize, ref_normalize(F(in->v[0]), 4, out))
+SUITE_CALL(api_v4_lerp, vec4, v4_lerp(in->v[0], in->v[1], in->t))
+SUITE_CALL(scalar_v4_lerp, vec4, v4_lerp_scalar(in->v[0], in->v[1], in->t))
+SUITE_REF(ref_v4_lerp, ref_lerp(F(in->v[0]), F(in->v[1]), in->t, 4, out))
+SUITE_CALL(api_v4_dot, float, v4_dot(in->v[0], in->v[1]))
+SUITE_CALL(scalar_v4_dot, float, v4_dot_scalar(in->v[0], in->v[1]))
+SUITE_REF(ref_v4_dot, ref_dot(F(in->v[0]), F(in->v[1]), 4, out))
+SUITE_CALL(api_v4_length, float, v4_length(in->v[0]))
+SUITE_CALL(scalar_v4_length, float, v4_length_scalar(in->v[0]))
+SUITE_REF(ref_v4_length, ref_length(F(in->v[0]), 4, out))
+
+SUITE_CALL(api_mat4_identity, mat4, mat4_identity())
+SUITE_REF(ref_mat4_identity, ref_mat4_translation(k_zero3, out))
+SUITE_CALL(api_mat4_translation, mat4, mat4_translation(in->p[0]))
+SUITE_REF(ref_mat4_translation_in, ref_mat4_translation(F(in->p[0]), out))
+SUITE_CALL(api_mat4_rotation_x, mat4, mat4_rotation_x(in->angle))
+SUITE_REF(ref_mat4_rotation_x, ref_mat4_rotation(0, in->angle, out))
+SUITE_CALL(api_mat4_rotation_y, mat4, mat4_rotation_y(in->angle))
+SUITE_REF(ref_mat4_rotation_y, ref_mat4_rotation(1, in->angle, out))
+SUITE_CALL(api_mat4_rotation_z, mat4, mat4_rotation_z(in->angle))
+SUITE_REF(ref_mat4_rotation_z, ref_mat4_rotation(2, in->angle, out))
+SUITE_CALL(api_mat4_perspective, mat4,
+           mat4_perspective(in->f[0], in->f[1], in->f[2], in->f[3]))
+SUITE_CALL(scalar_mat4_perspective, mat4,
+           mat4_perspective_scalar(in->f[0], in->f[1], in->f[2], in->f[3]))
+SUITE_REF(ref_mat4_perspective_in,
+          ref_mat4_perspective(in->f[0], in->f[1], in->f[2], in->f[3], out))
+// orthographic bounds from the same draws, widths f[0] + f[1] > 0
+SUITE_CALL(api_mat4_orthographic, mat4,
+           mat4_orthographic(-in->f[1], in->f[0], -in->f[0], in->f[1], in->f[2],
+                             in->f[3]))
+SUITE_REF(ref_mat4_orthographic_in,
+          ref_mat4_orthographic(-in->f[1], in->f[0], -in->f[0], in->f[1],
+                                in->f[2], in->f[3], out))
+SUITE_CALL(api_mat4_look_at, mat4, mat4_look_at(in->p[0], in->p[1], in->p[2]))
+SUITE_CALL(scalar_mat4_look_at, mat4,
+           mat4_look_at_scalar(in->p[0], in->p[1], in->p[2]))
+SUITE_REF(ref_mat4_look_at_in,
+          ref_mat4_look_at(F(in->p[0]), F(in->p[1]), F(in->p[2]), out))
+SUITE_CALL(api_mat4_mul, mat4, mat4_mul(in->m[0], in->m[1]))
+SUITE_CALL(scalar_mat4_mul, mat4, mat4_mul_scalar(in->m[0], in->m[1]))
+SUITE_REF(ref_mat4_mul_in, ref_mat4_mul(in->m[0].m, in->m[1].m, out))
+SUITE_CALL(api_mat4_mul_affine, mat4, mat4_mul_affine(in->am[0], in->am[1]))
+SUITE_REF(ref_mat4_mul_affine_in,
+          ref_mat4_mul_affine(in->am[0].m, in->am[1].m, out))
+SUITE_CALL(api_mat4_inverse_affine, mat4, mat4_inverse_affine(in->am[0]))
+SUITE_REF(ref_mat4_inverse_affine_in, ref_mat4_inverse_affine(in->am[0].m, out))
+
+SUITE_CALL(api_quat_identity, quat, quat_identity())
+SUITE_REF(ref_quat_identity, ref_fill(out, (float[4]){0.0f, 0.0f, 0.0f, 1.0f}, 4))
+SUITE_CALL(api_quat_from_axis_angle, quat,
+           quat_from_axis_angle(in->axis, in->angle))
+SUITE_REF(ref_quat_from_axis_angle_in,
+          ref_quat_from_axis_angle(F(in->axis), in->angle, out))
+SUITE_CALL(api_quat_mul, quat, quat_mul(in->q[0], in->q[1]))
+SUITE_REF(ref_quat_mul_in, ref_quat_mul(F(in->q[0]), F(in->q[1]), out))
+SUITE_CALL(api_quat_conjugate, quat, quat_conjugate(Q(in->v[0])))
+SUITE_REF(ref_quat_conjugate,
+          ref_fill(out, (float[4]){-in->v[0].x, -in->v[0].y, -in->v[0].z,
+                                    in->v[0].w}, 4))
+SUITE_CALL(api_quat_normalize, quat, quat_normalize(Q(in->v[0])))
+SUITE_REF(ref_quat_normalize_in, ref_quat_normalize(F(in->v[0]), out))
+SUITE_CALL(api_quat_dot, float, quat_dot(in->q[0], in->q[1]))
+SUITE_REF(ref_quat_dot, ref_dot(F(in->q[0]), F(in->q[1]), 4, out))
+SUITE_CALL(api_quat_rotate, vec3, quat_rotate(in->q[0], in->p[0]))
+SUITE_REF(ref_quat_rotate_in, ref_quat_rotate(F(in->q[0]), F(in->p[0]), out))
+SUITE_CALL(api_quat_nlerp, quat, quat_nlerp(in->q[0], in->q[1], in->t))
+SUITE_REF(ref_quat_nlerp_in, ref_quat_nlerp(F(in->q[0]), F(in->q[1]), in->t, out))
+SUITE_CALL(api_quat_slerp, quat, quat_slerp(in->q[0], in->q[1], in->t))
+SUITE_REF(ref_quat_slerp_in, ref_quat_slerp(F(in->q[0]), F(in->q[1]), in->t, out))
+SUITE_CALL(api_quat_to_mat4, mat4, quat_to_mat4(in->q[0]))
+SUITE_REF(ref_quat_to_mat4_in, ref_quat_to_mat4(F(in->q[0]), out))
+
+SUITE_CALL(api_affine_identity, affine, affine_identity())
+SUITE_REF(ref_affine_identity,
+          ref_fill(out, (float[12]){1, 0, 0, 0, 1, 0, 0, 0, 1, 0, 0, 0}, 12))
+SUITE_CALL(api_affine_mul, affine, affine_mul(in->a[0], in->a[1]))
+SUITE_REF(ref_affine_mul_in, ref_affine_mul(in->a[0].m, in->a[1].m, out))
+SUITE_CALL(api_affine_inverse, affine, affine_inverse(in->a[0]))
+SUITE_REF(ref_affine_inverse_in, ref_affine_inverse(in->a[0].m, out))
+SUITE_CALL(api_affine_transform_point, vec3,
+           affine_transform_point(in->a[0], in->p[0]))
+SUITE_REF(ref_affine_transform_point_in,
+          ref_affine_transform_point(in->a[0].m, F(in->p[0]), out))
+SUITE_CALL(api_affine_transform_dir, vec3, affine_transform_dir(in->a[0], in->p[0]))
+SUITE_REF(ref_affine_transform_dir_in,
+          ref_affine_transform_dir(in->a[0].m, F(in->p[0]), out))
+SUITE_CALL(api_affine_to_mat4, mat4, affine_to_mat4(in->a[0]))
+SUITE_REF(ref_affine_to_mat4, ref_fill(out, in->am[0].m, 16))
+SUITE_CALL(api_mat4_to_affine, affine, mat4_to_affine(in->am[0]))
+SUITE_REF(ref_mat4_to_affine, ref_fill(out, in->a[0].m, 12))
+
+SUITE_CALL(api_trs_identity, trs, trs_identity())
+SUITE_REF(ref_trs_identity,
+          ref_fill(out, (float[10]){0, 0, 0, 0, 0, 0, 1, 1, 1, 1}, 10))
+SUITE_CALL(api_trs_to_affine, affine, trs_to_affine(in->tr[0]))
+SUITE_REF(ref_trs_to_affine_in, ref_trs_to_affine(T(in->tr[0]), out))
+SUITE_CALL(api_trs_to_mat4, mat4, trs_to_mat4(in->tr[0]))
+SUITE_REF(ref_trs_to_mat4_in, ref_trs_to_mat4(T(in->tr[0]), out))
+SUITE_CALL(api_trs_mul, trs, trs_mul(in->tr[0], in->tr[1]))
+SUITE_REF(ref_trs_mul_in, ref_trs_mul(T(in->tr[0]), T(in->tr[1]), out))
+SUITE_CALL(api_trs_lerp, trs, trs_lerp(in->tr[0], in->tr[1], in->t))
+SUITE_REF(ref_trs_lerp_in, ref_trs_lerp(T(in->tr[0]), T(in->tr[1]), in->t, out))
+
+SUITE_CALL(api_frustum_from_mat4, frustum, frustum_from_mat4(in->m[0]))
+SUITE_REF(ref_frustum_from_mat4_in, ref_frustum_from_mat4(in->m[0].m, out))
+SUITE_CALL(api_frustum_test_sphere, int,
+           frustum_test_sphere(&g_frustum, in->p[0], in->s))
+SUITE_CALL(api_frustum_test_aabb, int,
+           frustum_test_aabb(&g_frustum, in->p[0], in->tr[0].scale))
+
+SUITE_CALL(api_fast_sin, float, fast_sin(in->v[0].x))
+SUITE_REF(ref_fast_sin, out[0] = sin(in->v[0].x))
+SUITE_CALL(api_fast_cos, float, fast_cos(in->v[0].x))
+SUITE_REF(ref_fast_cos, out[0] = cos(in->v[0].x))
+static void api_fast_sincos(const bench_input* in, float* out) {
+    fast_sincos(in->v[0].x, &out[0], &out[1]);
+}
+SUITE_REF(ref_fast_sincos, out[0] = sin(in->v[0].x); out[1] = cos(in->v[0].x))
+SUITE_CALL(api_fast_rsqrt, float, fast_rsqrt(in->f[3]))
+SUITE_REF(ref_fast_rsqrt, out[0] = 1.0 / sqrt(in->f[3]))
+SUITE_CALL(api_fast_atan2, float, fast_atan2(in->v[0].x, in->v[0].y))
+SUITE_REF(ref_fast_atan2, out[0] = atan2(in->v[0].x, in->v[0].y))
+
+#undef SUITE_CALL
+#undef SUITE_REF
+#undef F
+#undef T
+#undef Q
+
+#define API(name, n) {#name, n, api_##name, NULL, ref_##name}
+#define API_REF(name, n) {#name, n, api_##name, NULL, ref_##name##_in}
+#define SIMD(name, n) {#name, n, api_##name, scalar_##name, ref_##name}
+#define SIMD_REF(name, n) {#name, n, api_##name, scalar_##name, ref_##name##_in}
+
+static const suite_fn g_suite[] = {
+    API(deg2rad, 1),
+    API(rad2deg, 1),
+    API(v2_add, 2),
+    API(v2_sub, 2),
+    API(v2_mul, 2),
+    API(v2_scale, 2),
+    API(v2_div, 2),
+    API(v2_normalize, 2),
+    API(v2_lerp, 2),
+    API(v2_dot, 1),
+    API(v2_length, 1),
+    API(v3_zero, 3),
+    API(v3_one, 3),
+    API(v3_left, 3),
+    API(v3_right, 3),
+    API(v3_up, 3),
+    API(v3_add, 3),
+    API(v3_sub, 3),
+    API(v3_mul, 3),
+    API(v3_scale, 3),
+    API(v3_div, 3),
+    API(v3_cross, 3),
+    API(v3_normalize, 3),
+    API(v3_lerp, 3),
+    API(v3_length, 1),
+    API(v3_dot, 1),
+    SIMD(v4_add, 4),
+    SIMD(v4_sub, 4),
+    SIMD(v4_mul, 4),
+    SIMD(v4_scale, 4),
+    SIMD(v4_div, 4),
+    SIMD(v4_normalize, 4),
+    SIMD(v4_lerp, 4),
+    SIMD(v4_dot, 1),
+    SIMD(v4_length, 1),
+    API(mat4_identity, 16),
+    API_REF(mat4_translation, 16),
+    API(mat4_rotation_x, 16),
+    API(mat4_rotation_y, 16),
+    API(mat4_rotation_z, 16),
+    SIMD_REF(mat4_perspective, 16),
+    SIMD_REF(mat4_look_at, 16),
+    API_REF(mat4_orthographic, 16),
+    SIMD_REF(mat4_mul, 16),
+    API_REF(mat4_mul_affine, 16),
+    API_REF(mat4_inverse_affine, 16),
+    API(quat_identity, 4),
+    API_REF(quat_from_axis_angle, 4),
+    API_REF(quat_mul, 4),
+    API(quat_conjugate, 4),
+    API_REF(quat_normalize, 4),
+    API(quat_dot, 1),
+    API_REF(quat_rotate, 3),
+    API_REF(quat_nlerp, 4),
+    API_REF(quat_slerp, 4),
+    API_REF(quat_to_mat4, 16),
+    API(affine_identity, 12),
+    API_REF(affine_mul, 12),
+    API_REF(affine_inverse, 12),
+    API_REF(affine_transform_point, 3),
+    API_REF(affine_transform_dir, 3),
+    API(affine_to_mat4, 16),
+    API(mat4_to_affine, 12),
+    API(trs_identity, 10),
+    API_REF(trs_to_affine, 12),
+    API_REF(trs_to_mat4, 16),
+    API_REF(trs_mul, 10),
+    API_REF(trs_lerp, 10),
+    API_REF(frustum_from_mat4, 24),
+    {"frustum_test_sphere", 1, api_frustum_test_sphere, NULL, NULL},
+    {"frustum_test_aabb", 1, api_frustum_test_aabb, NULL, NULL},
+    API(fast_sin, 1),
+    API(fast_cos, 1),
+    API(fast_sincos, 2),
+    API(fast_rsqrt, 1),
+    API(fast_atan2, 1),
+};
+
+#undef API
+#undef API_REF
+#undef SIMD
+#undef SIMD_REF
+
+static double suite_ulp(suite_call fn, suite_ref ref, uint32_t outputs) {
+    float  got[BENCH_MAX_OUT];
+    double want[BENCH_MAX_OUT];
+    double worst = 0.0;
+    for (uint32_t i = 0; i < BENCH_INPUTS; i++) {
+        fn(&g_inputs[i], got);
+        ref(&g_inputs[i], want);
+        worst = fmax(worst, ulp_error(got, want, outputs));
+    }
+    return worst;
+}
+
+static uint32_t suite_mismatches(const suite_fn* fn) {
+    float    a[BENCH_MAX_OUT], b[BENCH_MAX_OUT];
+    uint32_t mismatches = 0;
+    for (uint32_t i = 0; i < BENCH_INPUTS; i++) {
+        fn->api(&g_inputs[i], a);
+        fn->scalar(&g_inputs[i], b);
+        if (memcmp(a, b, sizeof(float) * fn->outputs) != 0) {
+            if (mismatches == 0) {
+                fprintf(g_log, "  %s: first mismatch at input %u\n", fn->name, i);
+            }
+            mismatches++;
+        }
+    }
+    return mismatches;
+}
+
+// through the wrapper, so every entry pays the same indirect call
+static double suite_time(suite_call fn) {
+    float  out[BENCH_MAX_OUT];
+    float  sink = 0.0f;
+    time_p start = time_now();
+    for (uint32_t i = 0; i < BENCH_OPS; i++) {
+        fn(&g_inputs[i & (BENCH_INPUTS - 1)], out);
+        sink += out[0];
+    }
+    time_p end = time_now();
+    g_sink = sink;
+    return time_diff_sec(start, end) * 1e9 / BENCH_OPS;
+}
+
+// ulps are taken over ordinary inputs first: the zeros and tiny values that
+// probe the simd paths bit for bit underflow in squared lengths and would
+// swamp the figure. the mismatch checks and timings then run with them in
+static uint32_t run_suite(void) {
+    const uint32_t count = sizeof(g_suite) / sizeof(g_suite[0]);
+    double         api_ulp[sizeof(g_suite) / sizeof(g_suite[0])];
+    double         scalar_ulp[sizeof(g_suite) / sizeof(g_suite[0])];
+    uint32_t       failed = 0;
+
+    fill_inputs(0);
+    for (uint32_t i = 0; i < count; i++) {
+        const suite_fn* fn = &g_suite[i];
+        api_ulp[i] = fn->ref ? suite_ulp(fn->api, fn->ref, fn->outputs) : -1.0;
+        scalar_ulp[i] = fn->ref && fn->scalar
+                            ? suite_ulp(fn->scalar, fn->ref, fn->outputs)
+                            : -1.0;
+    }
+    fill_inputs(1);
+
+    fprintf(g_log, "  %-24s %10s %10s %8s %10s\n", "function", "scalar ns",
+            "api ns", "speedup", "max ulp");
+    for (uint32_t i = 0; i < count; i++) {
+        const suite_fn* fn = &g_suite[i];
+        double          ulp = api_ulp[i];
+        double          api_ns = suite_time(fn->api);
+        if (fn->scalar) {
+            uint32_t mismatches = suite_mismatches(fn);
+            double   scalar_ns = suite_time(fn->scalar);
+            failed += mismatches != 0;
+            record(fn->name, "scalar", scalar_ns, scalar_ulp[i], 0);
+            record(fn->name, "api", api_ns, ulp, mismatches);
+            fprintf(g_log, "  %-24s %10.2f %10.2f %7.2fx %10.2f\n", fn->name,
+                    scalar_ns, api_ns, scalar_ns / api_ns, ulp);
+        } else {
+            record(fn->name, "api", api_ns, ulp, 0);
+            fprintf(g_log, "  %-24s %10s %10.2f %8s ", fn->name, "-", api_ns, "-");
+            if (ulp < 0.0) fprintf(g_log, "%10s\n", "-");
+            else fprintf(g_log, "%10.2f\n", ulp);
+        }
+    }
+    return failed;
+}
+
+// a negative ulp (not measured) and an infinite one (nan where the reference
+// had a number) come out as null
+static void print_json(uint32_t failed) {
+    printf("{\n");
+    printf("  \"backend\": \"%s\",\n", MATHF_BACKEND);
+#ifdef MATHF_INLINE
+    printf("  \"inline\": true,\n");
+#else
+    printf("  \"inline\": false,\n");
+#endif  // MATHF_INLINE
+    printf("  \"failed\": %u,\n", failed);
+    printf("  \"results\": [\n");
+    for (uint32_t i = 0; i < g_record_count; i++) {
+        const bench_record* r = &g_records[i];
+        printf("    {\"name\": \"%s\", \"variant\": \"%s\", \"ns\": %.3f, ",
+               r->name, r->variant, r->ns);
+        if (r->max_ulp < 0.0 || !isfinite(r->max_ulp)) {
+            printf("\"max_ulp\": null, ");
+        } else {
+            printf("\"max_ulp\": %.2f, ", r->max_ulp);
+        }
+        printf("\"mismatches\": %u}%s\n", r->mismatches,
+               i + 1 < g_record_count ? "," : "");
+    }
+    printf("  ]\n}\n");
+}
+
+// per element loop through the one-at-a-time api, in the order the kernels
+// promise to match
+static vec4 transform_point_scalar(const mat4* m, vec3 p) {
+    const float* c = m->m;
+    return (vec4){
+        c[0] * p.x + c[4] * p.y + c[8] * p.z + c[12],
+        c[1] * p.x + c[5] * p.y + c[9] * p.z + c[13],
+        c[2] * p.x + c[6] * p.y + c[10] * p.z + c[14],
+        c[3] * p.x + c[7] * p.y + c[11] * p.z + c[15],
+    };
+}
+
+typedef struct {
+    mat4*   models;
+    mat4*   mvps;
+    vec3*   points;
+    vec4*   clip;
+    vec3x8* packs;
+    vec4x8* clip_packs;
+    vec3x8* normal_packs;
+} bench_batch;
+
+static void batch_report(const char* name, double loop_ns, double batch_ns,
+                         double ulp, uint32_t mismatches) {
+    const double per = (double)BENCH_BATCH * BENCH_BATCH_REPS;
+    if (mismatches) fprintf(g_log, "  %s: %u objects differ\n", name, mismatches);
+    if (loop_ns > 0.0) {
+        fprintf(g_log, "  %-22s %10.2f %10.2f %7.2fx", name, loop_ns / per,
+                batch_ns / per, loop_ns / batch_ns);
+    } else {
+        fprintf(g_log, "  %-22s %10s %10.2f %8s", name, "-", batch_ns / per, "-");
+    }
+    fprintf(g_log, " %10.2f\n", ulp);
+    record(name, "batch", batch_ns / per, ulp, mismatches);
+}
+
+// each kernel against the one-at-a-time path bit for bit and the double
+// reference in ulps, then timed both ways
+static uint32_t run_batch(bench_batch* b, const mat4* vp) {
+    const uint32_t n = BENCH_BATCH;
+    const uint32_t packs = mathf_pack_count(n);
+    uint32_t       failed = 0, mismatches;
+    double         want[16], ulp, loop_ns, batch_ns;
+    time_p         start;
+
+    fprintf(g_log, "  %-22s %10s %10s %8s %10s\n", "kernel (ns/object)", "loop",
+            "batch", "speedup", "max ulp");
+
+    mat4_mul_batch(vp, b->models, b->mvps, n);
+    mismatches = 0;
+    ulp = 0.0;
+    for (uint32_t i = 0; i < n; i++) {
+        mat4 one = mat4_mul(*vp, b->models[i]);
+        mismatches += memcmp(&one, &b->mvps[i], sizeof(one)) != 0;
+        ref_mat4_mul(vp->m, b->models[i].m, want);
+        ulp = fmax(ulp, ulp_error(b->mvps[i].m, want, 16));
+    }
+    start = time_now();
+    for (uint32_t r = 0; r < BENCH_BATCH_REPS; r++) {
+        for (uint32_t i = 0; i < n; i++) b->mvps[i] = mat4_mul(*vp, b->models[i]);
+    }
+    loop_ns = time_diff_sec(start, time_now()) * 1e9;
+    start = time_now();
+    for (uint32_t r = 0; r < BENCH_BATCH_REPS; r++) {
+        mat4_mul_batch(vp, b->models, b->mvps, n);
+    }
+    batch_ns = time_diff_sec(start, time_now()) * 1e9;
+    batch_report("mat4_mul_batch", loop_ns, batch_ns, ulp, mismatches);
+    failed += mismatches != 0;
+
+    v3x8_transform_points(vp, b->packs, b->clip_packs, packs);
+    v4x8_unpack(b->clip_packs, n, b->clip);
+    mismatches = 0;
+    ulp = 0.0;
+    for (uint32_t i = 0; i < n; i++) {
+        vec4 one = transform_point_scalar(vp, b->points[i]);
+        mismatches += memcmp(&one, &b->clip[i], sizeof(one)) != 0;
+        ref_mat4_transform_point(vp->m, &b->points[i].x, want);
+        ulp = fmax(ulp, ulp_error(&b->clip[i].x, want, 4));
+    }
+    start = time_now();
+    for (uint32_t r = 0; r < BENCH_BATCH_REPS; r++) {
+        for (uint32_t i = 0; i < n; i++) {
+            b->clip[i] = transform_point_scalar(vp, b->points[i]);
+        }
+    }
+    loop_ns = time_diff_sec(start, time_now()) * 1e9;
+    start = time_now();
+    for (uint32_t r = 0; r < BENCH_BATCH_REPS; r++) {
+        v3x8_transform_points(vp, b->packs, b->clip_packs, packs);
+    }
+    batch_ns = time_diff_sec(start, time_now()) * 1e9;
+    batch_report("v3x8_transform_points", loop_ns, batch_ns, ulp, mismatches);
+    failed += mismatches != 0;
+
+    vec3* normals = (vec3*)b->clip;
+    v3x8_normalize(b->packs, b->normal_packs, packs);
+    v3x8_unpack(b->normal_packs, n, normals);
+    mismatches = 0;
+    ulp = 0.0;
+    for (uint32_t i = 0; i < n; i++) {
+        vec3 one = v3_normalize(b->points[i]);
+        mismatches += memcmp(&one, &normals[i], sizeof(one)) != 0;
+        // the suite's rule: squared lengths that underflow stay out of it
+        if (v3_dot(b->points[i], b->points[i]) < 1e-30f) continue;
+        ref_normalize(&b->points[i].x, 3, want);
+        ulp = fmax(ulp, ulp_error(&normals[i].x, want, 3));
+    }
+    start = time_now();
+    for (uint32_t r = 0; r < BENCH_BATCH_REPS; r++) {
+        for (uint32_t i = 0; i < n; i++) normals[i] = v3_normalize(b->points[i]);
+    }
+    loop_ns = time_diff_sec(start, time_now()) * 1e9;
+    start = time_now();
+    for (uint32_t r = 0; r < BENCH_BATCH_REPS; r++) {
+        v3x8_normalize(b->packs, b->normal_packs, packs);
+    }
+    batch_ns = time_diff_sec(start, time_now()) * 1e9;
+    batch_report("v3x8_normalize", loop_ns, batch_ns, ulp, mismatches);
+    failed += mismatches != 0;
+
+    // the pack conversions are plain copies: a round trip must give the
+    // input back
+    v3x8_unpack(b->packs, n, normals);
+    mismatches = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        mismatches += memcmp(&normals[i], &b->points[i], sizeof(vec3)) != 0;
+    }
+    start = time_now();
+    for (uint32_t r = 0; r < BENCH_BATCH_REPS; r++) {
+        v3x8_pack(b->points, n, b->packs);
+    }
+    batch_ns = time_diff_sec(start, time_now()) * 1e9;
+    batch_report("v3x8_pack", 0.0, batch_ns, 0.0, 0);
+    start = time_now();
+    for (uint32_t r = 0; r < BENCH_BATCH_REPS; r++) {
+        v3x8_unpack(b->packs, n, normals);
+    }
+    batch_ns = time_diff_sec(start, time_now()) * 1e9;
+    batch_report("v3x8_unpack", 0.0, batch_ns, 0.0, mismatches);
+    failed += mismatches != 0;
+
+    mismatches = 0;
+    v4x8_unpack(b->clip_packs, n, b->clip);
+    for (uint32_t i = 0; i < n; i++) {
+        const vec4x8* pack = &b->clip_packs[i / MATHF_LANES];
+        uint32_t      l = i % MATHF_LANES;
+        vec4          one = {pack->x[l], pack->y[l], pack->z[l], pack->w[l]};
+        mismatches += memcmp(&one, &b->clip[i], sizeof(one)) != 0;
+    }
+    start = time_now();
+    for (uint32_t r = 0; r < BENCH_BATCH_REPS; r++) {
+        v4x8_unpack(b->clip_packs, n, b->clip);
+    }
+    batch_ns = time_diff_sec(start, time_now()) * 1e9;
+    batch_report("v4x8_unpack", 0.0, batch_ns, 0.0, mismatches);
+    failed += mismatches != 0;
+    return failed;
+}
+
+typedef struct {
+    vec3*     centers;
+    vec3*     extents;
+    float*    radii;
+    vec3x8*   center_packs;
+    vec3x8*   extent_packs;
+    uint32_t* visible;
+    uint32_t* expected;
+} bench_cull;
+
+static uint32_t cull_scalar(const frustum* f, const bench_cull* c, int spheres) {
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < BENCH_BATCH; i++) {
+        int in = spheres ? frustum_test_sphere(f, c->centers[i], c->radii[i])
+                         : frustum_test_aabb(f, c->centers[i], c->extents[i]);
+        if (in) c->expected[n++] = i;
+    }
+    return n;
+}
+
+static uint32_t cull_kernel(const frustum* f, const bench_cull* c, int spheres) {
+    return spheres ? frustum_cull_spheres(f, c->center_packs, c->radii,
+                                          BENCH_BATCH, c->visible)
+                   : frustum_cull_aabbs(f, c->center_packs, c->extent_packs,
+                                        BENCH_BATCH, c->visible);
+}
+
+// the kernels must agree with the one-at-a-time tests index for index
+static uint32_t check_and_time_cull(bench_cull* c, const mat4* vp) {
+    frustum        f = frustum_from_mat4(*vp);
+    const char*    names[2] = {"frustum_cull_aabbs", "frustum_cull_spheres"};
+    uint32_t       failed = 0;
+
+    for (int spheres = 0; spheres < 2; spheres++) {
+        uint32_t expected = cull_scalar(&f, c, spheres);
+        uint32_t got = cull_kernel(&f, c, spheres);
+        uint32_t mismatches = got > expected ? got - expected : expected - got;
+        for (uint32_t i = 0; i < got && i < expected; i++) {
+            mismatches += c->visible[i] != c->expected[i];
+        }
+        if (mismatches) {
+            fprintf(g_log, "  %s: %u visible, expected %u\n", names[spheres], got,
+                    expected);
+            failed++;
+        }
+
+        time_p start = time_now();
+        for (uint32_t r = 0; r < BENCH_BATCH_REPS; r++) cull_scalar(&f, c, spheres);
+        double loop_ns = time_diff_sec(start, time_now()) * 1e9;
+        start = time_now();
+        for (uint32_t r = 0; r < BENCH_BATCH_REPS; r++) cull_kernel(&f, c, spheres);
+        double kernel_ns = time_diff_sec(start, time_now()) * 1e9;
+        double per = (double)BENCH_BATCH * BENCH_BATCH_REPS;
+        fprintf(g_log, "  %-22s %10.2f %10.2f %7.2fx %10s  (%u%% visible)\n",
+                names[spheres], loop_ns / per, kernel_ns / per,
+                loop_ns / kernel_ns, "-", expected * 100 / BENCH_BATCH);
+        record(names[spheres], "batch", kernel_ns / per, -1.0, mismatches);
+    }
+    return failed;
+}
+
+static void mask_kernel(const frustum* frusta, uint32_t views, const bench_cull* c,
+                        int spheres) {
+    if (spheres) {
+        frustum_mask_spheres(frusta, views, c->center_packs, c->radii,
+                             BENCH_BATCH, c->visible);
+    } else {
+        frustum_mask_aabbs(frusta, views, c->center_packs, c->extent_packs,
+                           BENCH_BATCH, c->visible);
+    }
+}
+
+// the view turned about y, so each object lands in a few of the frusta
+static void mask_frusta(const mat4* vp, frustum* frusta, uint32_t views) {
+    for (uint32_t v = 0; v < views; v++) {
+        mat4 turn = mat4_rotation_y((float)v * (TWO_PI / views));
+        frusta[v] = frustum_from_mat4(mat4_mul(*vp, turn));
+    }
+}
+
+// objects whose mask differs from the one-at-a-time tests against the first
+// views frusta
+static uint32_t mask_mismatches(const frustum* frusta, uint32_t views,
+                                const bench_cull* c, int spheres) {
+    uint32_t mismatches = 0;
+    for (uint32_t i = 0; i < BENCH_BATCH; i++) {
+        uint32_t want = 0;
+        for (uint32_t v = 0; v < views; v++) {
+            int in = spheres ? frustum_test_sphere(&frusta[v], c->centers[i],
+                                                   c->radii[i])
+                             : frustum_test_aabb(&frusta[v], c->centers[i],
+                                                 c->extents[i]);
+            want |= (uint32_t)in << v;
+        }
+        mismatches += c->visible[i] != want;
+    }
+    return mismatches;
+}
+
+// the masks must hold every frustum's one-at-a-time result bit for bit. the
+// loop column culls the same bounds once per frustum with frustum_cull_*,
+// which is what the mask kernels replace
+static uint32_t check_and_time_mask(bench_cull* c, const mat4* vp) {
+    frustum     frusta[BENCH_MASK_VIEWS];
+    const char* names[2] = {"frustum_mask_aabbs", "frustum_mask_spheres"};
+    uint32_t    failed = 0;
+
+    mask_frusta(vp, frusta, BENCH_MASK_VIEWS);
+    for (int spheres = 0; spheres < 2; spheres++) {
+        mask_kernel(frusta, BENCH_MASK_VIEWS, c, spheres);
+        uint32_t mismatches = mask_mismatches(frusta, BENCH_MASK_VIEWS, c,
+                                              spheres);
+        if (mismatches) {
+            fprintf(g_log, "  %s: %u objects differ\n", names[spheres],
+                    mismatches);
+            failed++;
+        }
+
+        time_p start = time_now();
+        for (uint32_t r = 0; r < BENCH_BATCH_REPS; r++) {
+            for (uint32_t v = 0; v < BENCH_MASK_VIEWS; v++) {
+                cull_kernel(&frusta[v], c, spheres);
+            }
+        }
+        double loop_ns = time_diff_sec(start, time_now()) * 1e9;
+        start = time_now();
+        for (uint32_t r = 0; r < BENCH_BATCH_REPS; r++) {
+            mask_kernel(frusta, BENCH_MASK_VIEWS, c, spheres);
+        }
+        double kernel_ns = time_diff_sec(start, time_now()) * 1e9;
+        double per = (double)BENCH_BATCH * BENCH_BATCH_REPS;
+        fprintf(g_log, "  %-22s %10.2f %10.2f %7.2fx %10s  (%d frusta)\n",
+                names[spheres], loop_ns / per, kernel_ns / per,
+                loop_ns / kernel_ns, "-", BENCH_MASK_VIEWS);
+        record(names[spheres], "batch", kernel_ns / per, -1.0, mismatches);
+    }
+    return failed;
+}
+
+// more frusta than a mask has bits: the ones past FRUSTUM_MASK_MAX are dropped
+// and the rest come out as if only those had been passed
+static uint32_t check_mask_overflow(bench_cull* c, const mat4* vp) {
+    frustum     frusta[BENCH_MASK_OVER];
+    const char* names[2] = {"frustum_mask_aabbs", "frustum_mask_spheres"};
+    uint32_t    failed = 0;
+
+    mask_frusta(vp, frusta, BENCH_MASK_OVER);
+    for (int spheres = 0; spheres < 2; spheres++) {
+        mask_kernel(frusta, BENCH_MASK_OVER, c, spheres);
+        uint32_t mismatches = mask_mismatches(frusta, FRUSTUM_MASK_MAX, c,
+                                              spheres);
+        if (mismatches) {
+            fprintf(g_log, "  %s: %u objects differ with %d frusta\n",
+                    names[spheres], mismatches, BENCH_MASK_OVER);
+            failed++;
+        }
+    }
+    return failed;
+}
+
+// error against a double reference: absolute, and in units of the float ulp
+// at the reference value
+typedef struct {
+    double abs;
+    double ulp;
+    float  worst;  // input with the largest abs error
+} fast_error;
+
+static void error_add(fast_error* e, float in, float got, double ref) {
+    double err = fabs((double)got - ref);
+    float  rf = fabsf((float)ref);
+    double ulp = (double)nextafterf(rf, INFINITY) - rf;
+    if (err > e->abs) {
+        e->abs = err;
+        e->worst = in;
+    }
+    if (ulp > 0.0 && err / ulp > e->ulp) e->ulp = err / ulp;
+}
+
+// relative error in the abs field, for rsqrt
+static void rel_add(fast_error* e, float in, float got, double ref) {
+    fast_error abs = {0};
+    error_add(&abs, in, got, ref);
+    if (abs.abs / ref > e->abs) {
+        e->abs = abs.abs / ref;
+        e->worst = in;
+    }
+    if (abs.ulp > e->ulp) e->ulp = abs.ulp;
+}
+
+static float bits_float(uint32_t bits) {
+    float f;
+    memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+#define FAST_CHUNK 4096
+#define FAST_SAMPLES 1000000
+
+static float g_fast_x[FAST_CHUNK], g_fast_y[FAST_CHUNK];
+static float g_fast_a[FAST_CHUNK], g_fast_b[FAST_CHUNK];
+
+static void sincos_chunk(uint32_t n, fast_error* es, fast_error* ec) {
+    fast_sincos_batch(g_fast_x, g_fast_a, g_fast_b, n);
+    for (uint32_t i = 0; i < n; i++) {
+        error_add(es, g_fast_x[i], g_fast_a[i], sin((double)g_fast_x[i]));
+        error_add(ec, g_fast_x[i], g_fast_b[i], cos((double)g_fast_x[i]));
+    }
+}
+
+static void rsqrt_chunk(uint32_t n, fast_error* e) {
+    fast_rsqrt_batch(g_fast_x, g_fast_a, n);
+    for (uint32_t i = 0; i < n; i++) {
+        rel_add(e, g_fast_x[i], g_fast_a[i], 1.0 / sqrt((double)g_fast_x[i]));
+    }
+}
+
+static void atan2_chunk(uint32_t n, fast_error* e) {
+    fast_atan2_batch(g_fast_y, g_fast_x, g_fast_a, n);
+    for (uint32_t i = 0; i < n; i++) {
+        double ref = atan2((double)g_fast_y[i], (double)g_fast_x[i]);
+        error_add(e, g_fast_y[i], g_fast_a[i], ref);
+    }
+}
+
+static int report_error(const char* name, fast_error e, float bound) {
+    int ok = e.abs <= bound;
+    fprintf(g_log, "  %-12s max err %.3g (bound %.3g) at %.9g, %.2f ulp  %s\n",
+            name, e.abs, bound, e.worst, e.ulp, ok ? "ok" : "FAILED");
+    return ok ? 0 : 1;
+}
+
+// every float in each domain, fed through the batch kernels in chunks. one
+// function at a time when named, each report printed as soon as it is done
+static uint32_t fast_exhaustive(const char* only) {
+    uint32_t failed = 0, n = 0;
+
+    if (!only || strcmp(only, "sincos") == 0) {
+        fast_error es = {0}, ec = {0};
+        for (uint64_t bits = 0; bits <= 0xffffffffu; bits++) {
+            float x = bits_float((uint32_t)bits);
+            if (!(fabsf(x) <= 8192.0f)) continue;
+            g_fast_x[n++] = x;
+            if (n == FAST_CHUNK) sincos_chunk(n, &es, &ec), n = 0;
+        }
+        sincos_chunk(n, &es, &ec), n = 0;
+        failed += report_error("fast_sin", es, FAST_SINCOS_MAX_ERR);
+        failed += report_error("fast_cos", ec, FAST_SINCOS_MAX_ERR);
+        fflush(stdout);
+    }
+
+    if (!only || strcmp(only, "rsqrt") == 0) {
+        fast_error er = {0};
+        for (uint32_t bits = 0x00800000u; bits < 0x7f800000u; bits++) {
+            g_fast_x[n++] = bits_float(bits);
+            if (n == FAST_CHUNK) rsqrt_chunk(n, &er), n = 0;
+        }
+        rsqrt_chunk(n, &er), n = 0;
+        failed += report_error("fast_rsqrt", er, FAST_RSQRT_MAX_REL_ERR);
+        fflush(stdout);
+    }
+
+    // every finite y against x = +-1 reaches each min/max ratio from both
+    // sides of the diagonal and in all four quadrants
+    if (!only || strcmp(only, "atan2") == 0) {
+        fast_error ea = {0};
+        for (uint64_t bits = 0; bits <= 0xffffffffu; bits++) {
+            float y = bits_float((uint32_t)bits);
+            if (!isfinite(y)) continue;
+            g_fast_y[n] = y, g_fast_x[n++] = 1.0f;
+            g_fast_y[n] = y, g_fast_x[n++] = -1.0f;
+            if (n == FAST_CHUNK) atan2_chunk(n, &ea), n = 0;
+        }
+        atan2_chunk(n, &ea);
+        failed += report_error("fast_atan2", ea, FAST_ATAN2_MAX_ERR);
+    }
+    return failed;
+}
+
+static double time_libm_sincos(const float* x, uint32_t n) {
+    float  acc = 0.0f;
+    time_p start = time_now();
+    for (uint32_t r = 0; r < BENCH_BATCH_REPS; r++) {
+        for (uint32_t i = 0; i < n; i++) acc += sinf(x[i]) + cosf(x[i]);
+    }
+    double ns = time_diff_sec(start, time_now()) * 1e9;
+    g_sink = acc;
+    return ns / ((double)n * BENCH_BATCH_REPS);
+}
+
+static double time_fast_sincos(const float* x, uint32_t n) {
+    float  acc = 0.0f;
+    time_p start = time_now();
+    for (uint32_t r = 0; r < BENCH_BATCH_REPS; r++) {
+        for (uint32_t i = 0; i < n; i++) {
+            float s, c;
+            fast_sincos(x[i], &s, &c);
+            acc += s + c;
+        }
+    }
+    double ns = time_diff_sec(start, time_now()) * 1e9;
+    g_sink = acc;
+    return ns / ((double)n * BENCH_BATCH_REPS);
+}
+
+// sampled errors, scalar/batch agreement and timings against libm
+static uint32_t fast_sampled(void) {
+    uint32_t n = FAST_SAMPLES;
+    float*   x = malloc(sizeof(float) * n);
+    float*   y = malloc(sizeof(float) * n);
+    float*   a = malloc(sizeof(float) * n);
+    float*   b = malloc(sizeof(float) * n);
+    uint32_t failed = 0, mismatched = 0;
+    uint32_t sc_mis = 0, rs_mis = 0, at_mis = 0;
+
+    fprintf(g_log, "\nfast approximations, %u samples\n", n);
+
+    fast_error es = {0}, ec = {0};
+    for (uint32_t i = 0; i < n; i++) x[i] = rng_float(-8192.0f, 8192.0f);
+    for (uint32_t i = 0; i < 64; i++) x[i] = (float)i * FAST_QUARTER_PI;
+    fast_sincos_batch(x, a, b, n);
+    for (uint32_t i = 0; i < n; i++) {
+        float s, c;
+        fast_sincos(x[i], &s, &c);
+        sc_mis += memcmp(&s, &a[i], 4) != 0 || memcmp(&c, &b[i], 4) != 0;
+        error_add(&es, x[i], a[i], sin((double)x[i]));
+        error_add(&ec, x[i], b[i], cos((double)x[i]));
+    }
+    failed += report_error("fast_sin", es, FAST_SINCOS_MAX_ERR);
+    failed += report_error("fast_cos", ec, FAST_SINCOS_MAX_ERR);
+    double libm_sc = time_libm_sincos(x, n);
+    double fast_sc = time_fast_sincos(x, n);
+    time_p start = time_now();
+    for (uint32_t r = 0; r < BENCH_BATCH_REPS; r++) fast_sincos_batch(x, a, b, n);
+    double batch_sc =
+        time_diff_sec(start, time_now()) * 1e9 / ((double)n * BENCH_BATCH_REPS);
+
+    fast_error er = {0};
+    for (uint32_t i = 0; i < n; i++) {
+        x[i] = bits_float(0x00800000u + rng_next() % (0x7f800000u - 0x00800000u));
+    }
+    fast_rsqrt_batch(x, a, n);
+    for (uint32_t i = 0; i < n; i++) {
+        float s = fast_rsqrt(x[i]);
+        rs_mis += memcmp(&s, &a[i], 4) != 0;
+        rel_add(&er, x[i], a[i], 1.0 / sqrt((double)x[i]));
+    }
+    failed += report_error("fast_rsqrt", er, FAST_RSQRT_MAX_REL_ERR);
+    float acc = 0.0f;
+    start = time_now();
+    for (uint32_t r = 0; r < BENCH_BATCH_REPS; r++) {
+        for (uint32_t i = 0; i < n; i++) acc += 1.0f / sqrtf(x[i]);
+    }
+    double libm_rs =
+        time_diff_sec(start, time_now()) * 1e9 / ((double)n * BENCH_BATCH_REPS);
+    start = time_now();
+    for (uint32_t r = 0; r < BENCH_BATCH_REPS; r++) {
+        for (uint32_t i = 0; i < n; i++) acc += fast_rsqrt(x[i]);
+    }
+    double fast_rs =
+        time_diff_sec(start, time_now()) * 1e9 / ((double)n * BENCH_BATCH_REPS);
+    start = time_now();
+    for (uint32_t r = 0; r < BENCH_BATCH_REPS; r++) fast_rsqrt_batch(x, a, n);
+    double batch_rs =
+        time_diff_sec(start, time_now()) * 1e9 / ((double)n * BENCH_BATCH_REPS);
+
+    fast_error ea = {0};
+    for (uint32_t i = 0; i < n; i++) {
+        x[i] = rng_float(-1000.0f, 1000.0f) * (rng_next() % 8 ? 1.0f : 1e-6f);
+        y[i] = rng_float(-1000.0f, 1000.0f) * (rng_next() % 8 ? 1.0f : 1e-6f);
+    }
+    fast_atan2_batch(y, x, a, n);
+    for (uint32_t i = 0; i < n; i++) {
+        float s = fast_atan2(y[i], x[i]);
+        at_mis += memcmp(&s, &a[i], 4) != 0;
+        error_add(&ea, y[i], a[i], atan2((double)y[i], (double)x[i]));
+    }
+    failed += report_error("fast_atan2", ea, FAST_ATAN2_MAX_ERR);
+    start = time_now();
+    for (uint32_t r = 0; r < BENCH_BATCH_REPS; r++) {
+        for (uint32_t i = 0; i < n; i++) acc += atan2f(y[i], x[i]);
+    }
+    double libm_at =
+        time_diff_sec(start, time_now()) * 1e9 / ((double)n * BENCH_BATCH_REPS);
+    start = time_now();
+    for (uint32_t r = 0; r < BENCH_BATCH_REPS; r++) {
+        for (uint32_t i = 0; i < n; i++) acc += fast_atan2(y[i], x[i]);
+    }
+    double fast_at =
+        time_diff_sec(start, time_now()) * 1e9 / ((double)n * BENCH_BATCH_REPS);
+    start = time_now();
+    for (uint32_t r = 0; r < BENCH_BATCH_REPS; r++) fast_atan2_batch(y, x, a, n);
+    double batch_at =
+        time_diff_sec(start, time_now()) * 1e9 / ((double)n * BENCH_BATCH_REPS);
+    g_sink = acc;
+    mismatched = sc_mis + rs_mis + at_mis;
+
+    // the api variants come from the suite, over its own inputs
+    record("fast_sincos", "libm", libm_sc, -1.0, 0);
+    record("fast_sincos", "batch", batch_sc, fmax(es.ulp, ec.ulp), sc_mis);
+    record("fast_rsqrt", "libm", libm_rs, -1.0, 0);
+    record("fast_rsqrt", "batch", batch_rs, er.ulp, rs_mis);
+    record("fast_atan2", "libm", libm_at, -1.0, 0);
+    record("fast_atan2", "batch", batch_at, ea.ulp, at_mis);
+
+    fprintf(g_log, "\n  %-12s %10s %10s %10s\n", "ns/value", "libm", "fast",
+            "batch");
+    fprintf(g_log, "  %-12s %10.2f %10.2f %10.2f\n", "sincos", libm_sc, fast_sc,
+            batch_sc);
+    fprintf(g_log, "  %-12s %10.2f %10.2f %10.2f\n", "rsqrt", libm_rs, fast_rs,
+            batch_rs);
+    fprintf(g_log, "  %-12s %10.2f %10.2f %10.2f\n", "atan2", libm_at, fast_at,
+            batch_at);
+    if (mismatched) {
+        fprintf(g_log, "  %u batch results differ from scalar\n", mismatched);
+    }
+
+    free(x);
+    free(y);
+    free(a);
+    free(b);
+    return failed + mismatched;
+}
+
+int main(int argc, char** argv) {
+    g_log = stdout;
+    if (argc > 1 && strcmp(argv[1], "exhaustive") == 0) {
+        return fast_exhaustive(argc > 2 ? argv[2] : NULL) ? 1 : 0;
+    }
+    int json = argc > 1 && strcmp(argv[1], "json") == 0;
+    if (json) g_log = stderr;
+
+    mat4 vp = mat4_mul(mat4_perspective(1.0f, 16.0f / 9.0f, 0.1f, 1000.0f),
+                       mat4_look_at((vec3){0, 5, -10}, v3_zero(), v3_up()));
+    g_frustum = frustum_from_mat4(vp);
+    fprintf(g_log, "backend: %s\n", MATHF_BACKEND);
+    uint32_t failed = run_suite();
+
+    bench_batch    b;
+    const uint32_t packs = mathf_pack_count(BENCH_BATCH);
+    b.models = malloc(sizeof(mat4) * BENCH_BATCH);
+    b.mvps = malloc(sizeof(mat4) * BENCH_BATCH);
+    b.points = malloc(sizeof(vec3) * BENCH_BATCH);
+    b.clip = malloc(sizeof(vec4) * BENCH_BATCH);
+    b.packs = malloc(sizeof(vec3x8) * packs);
+    b.clip_packs = malloc(sizeof(vec4x8) * packs);
+    b.normal_packs = malloc(sizeof(vec3x8) * packs);
+    for (uint32_t i = 0; i < BENCH_BATCH; i++) {
+        fill_floats(&b.models[i], sizeof(mat4));
+        fill_floats(&b.points[i], sizeof(vec3));
+    }
+    v3x8_pack(b.points, BENCH_BATCH, b.packs);
+
+    fprintf(g_log, "\nbatches of %d objects\n", BENCH_BATCH);
+    uint32_t batch_failed = run_batch(&b, &vp);
+
+    bench_cull c;
+    c.centers = malloc(sizeof(vec3) * BENCH_BATCH);
+    c.extents = malloc(sizeof(vec3) * BENCH_BATCH);
+    c.radii = calloc(packs * MATHF_LANES, sizeof(float));
+    c.center_packs = malloc(sizeof(vec3x8) * packs);
+    c.extent_packs = malloc(sizeof(vec3x8) * packs);
+    c.visible = malloc(sizeof(uint32_t) * BENCH_BATCH);
+    c.expected = malloc(sizeof(uint32_t) * BENCH_BATCH);
+    for (uint32_t i = 0; i < BENCH_BATCH; i++) {
+        c.centers[i] = (vec3){rng_float(-200.0f, 200.0f), rng_float(-50.0f, 50.0f),
+                              rng_float(-200.0f, 200.0f)};
+        c.extents[i] = (vec3){rng_float(0.5f, 4.0f), rng_float(0.5f, 4.0f),
+                              rng_float(0.5f, 4.0f)};
+        c.radii[i] = v3_length(c.extents[i]);
+    }
+    v3x8_pack(c.centers, BENCH_BATCH, c.center_packs);
+    v3x8_pack(c.extents, BENCH_BATCH, c.extent_packs);
+    uint32_t cull_failed = check_and_time_cull(&c, &vp);
+    cull_failed += check_and_time_mask(&c, &vp);
+    cull_failed += check_mask_overflow(&c, &vp);
+    uint32_t fast_failed = fast_sampled();
+
+    failed += batch_failed + cull_failed + fast_failed;
+    if (json) print_json(failed);
+    return failed ? 1 : 0;
+}
+
+#include "base.c"
+#include "time_posix.c"
@@ -0,0 +1,384 @@
+#include "reference.h"
+
+#include <math.h>
+#include <string.h>
+
+static void widen(const float* src, uint32_t n, double* dst) {
+    for (uint32_t i = 0; i < n; i++) dst[i] = src[i];
+}
+
+static double dot3(const double* a, const double* b) {
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+static void cross3(const double* a, const double* b, double* out) {
+    double r[3] = {a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2],
+                   a[0] * b[1] - a[1] * b[0]};
+    memcpy(out, r, sizeof(r));
+}
+
+static void normalize_n(double* v, uint32_t n) {
+    double len = 0.0;
+    for (uint32_t i = 0; i < n; i++) len += v[i] * v[i];
+    len = sqrt(len);
+    for (uint32_t i = 0; i < n; i++) v[i] = len != 0.0 ? v[i] / len : 0.0;
+}
+
+static void identity4(double* out) {
+    memset(out, 0, sizeof(double) * 16);
+    out[0] = out[5] = out[10] = out[15] = 1.0;
+}
+
+void ref_add(const float* a, const float* b, uint32_t n, double* out) {
+    for (uint32_t i = 0; i < n; i++) out[i] = (double)a[i] + b[i];
+}
+
+void ref_sub(const float* a, const float* b, uint32_t n, double* out) {
+    for (uint32_t i = 0; i < n; i++) out[i] = (double)a[i] - b[i];
+}
+
+void ref_mul(const float* a, const float* b, uint32_t n, double* out) {
+    for (uint32_t i = 0; i < n; i++) out[i] = (double)a[i] * b[i];
+}
+
+void ref_scale(const float* v, float s, uint32_t n, double* out) {
+    for (uint32_t i = 0; i < n; i++) out[i] = (double)v[i] * s;
+}
+
+void ref_div(const float* v, float s, uint32_t n, double* out) {
+    for (uint32_t i = 0; i < n; i++) out[i] = (double)v[i] / s;
+}
+
+void ref_lerp(const float* a, const float* b, float t, uint32_t n, double* out) {
+    for (uint32_t i = 0; i < n; i++) out[i] = a[i] + ((double)b[i] - a[i]) * t;
+}
+
+void ref_dot(const float* a, const float* b, uint32_t n, double* out) {
+    double sum = 0.0;
+    for (uint32_t i = 0; i < n; i++) sum += (double)a[i] * b[i];
+    out[0] = sum;
+}
+
+void ref_length(const float* v, uint32_t n, double* out) {
+    ref_dot(v, v, n, out);
+    out[0] = sqrt(out[0]);
+}
+
+void ref_normalize(const float* v, uint32_t n, double* out) {
+    widen(v, n, out);
+    normalize_n(out, n);
+}
+
+void ref_cross(const float* a, const float* b, double* out) {
+    double da[3], db[3];
+    widen(a, 3, da);
+    widen(b, 3, db);
+    cross3(da, db, out);
+}
+
+void ref_mat4_translation(const float* t, double* out) {
+    identity4(out);
+    widen(t, 3, &out[12]);
+}
+
+void ref_mat4_rotation(int axis, float radians, double* out) {
+    double c = cos(radians), s = sin(radians);
+    int    i = (axis + 1) % 3, j = (axis + 2) % 3;  // the plane it turns
+    identity4(out);
+    out[i * 4 + i] = c;
+    out[i * 4 + j] = s;
+    out[j * 4 + i] = -s;
+    out[j * 4 + j] = c;
+}
+
+void ref_mat4_perspective(float fov, float aspect, float near_z, float far_z,
+                          double* out) {
+    double t = tan(fov / 2.0);
+    memset(out, 0, sizeof(double) * 16);
+    out[0] = 1.0 / (aspect * t);
+    out[5] = 1.0 / t;
+    out[10] = far_z / ((double)far_z - near_z);
+    out[11] = 1.0;
+    out[14] = -((double)far_z * near_z) / ((double)far_z - near_z);
+}
+
+void ref_mat4_orthographic(float left, float right, float bottom, float top,
+                           float near_z, float far_z, double* out) {
+    double w = (double)right - left, h = (double)top - bottom;
+    double depth = (double)far_z - near_z;
+    identity4(out);
+    out[0] = 2.0 / w;
+    out[5] = 2.0 / h;
+    out[10] = 1.0 / depth;
+    out[12] = -((double)right + left) / w;
+    out[13] = -((double)top + bottom) / h;
+    out[14] = -near_z / depth;
+}
+
+void ref_mat4_look_at(const float* eye, const float* center, const float* up,
+                      double* out) {
+    double e[3], f[3], s[3], u[3], w[3];
+    widen(eye, 3, e);
+    widen(up, 3, w);
+    for (int i = 0; i < 3; i++) f[i] = (double)center[i] - eye[i];
+    normalize_n(f, 3);
+    cross3(f, w, s);
+    normalize_n(s, 3);
+    cross3(s, f, u);
+    identity4(out);
+    for (int i = 0; i < 3; i++) {
+        out[i * 4 + 0] = s[i];
+        out[i * 4 + 1] = u[i];
+        out[i * 4 + 2] = f[i];
+    }
+    out[12] = -dot3(s, e);
+    out[13] = -dot3(u, e);
+    out[14] = -dot3(f, e);
+}
+
+void ref_mat4_mul(const float* a, const float* b, double* out) {
+    for (int col = 0; col < 4; col++) {
+        for (int row = 0; row < 4; row++) {
+            double sum = 0.0;
+            for (int i = 0; i < 4; i++) {
+                sum += (double)a[i * 4 + row] * b[col * 4 + i];
+            }
+            out[col * 4 + row] = sum;
+        }
+    }
+}
+
+// mat4 <-> affine, dropping or restoring the 0 0 0 1 bottom row
+static void narrow_affine(const float* m, float* out) {
+    for (int col = 0; col < 4; col++) memcpy(&out[col * 3], &m[col * 4], 12);
+}
+
+static void widen_affine(const double* a, double* out) {
+    for (int col = 0; col < 4; col++) {
+        memcpy(&out[col * 4], &a[col * 3], sizeof(double) * 3);
+        out[col * 4 + 3] = col == 3 ? 1.0 : 0.0;
+    }
+}
+
+void ref_mat4_mul_affine(const float* a, const float* b, double* out) {
+    float  fa[12], fb[12];
+    double r[12];
+    narrow_affine(a, fa);
+    narrow_affine(b, fb);
+    ref_affine_mul(fa, fb, r);
+    widen_affine(r, out);
+}
+
+void ref_mat4_inverse_affine(const float* m, double* out) {
+    float  fm[12];
+    double r[12];
+    narrow_affine(m, fm);
+    ref_affine_inverse(fm, r);
+    widen_affine(r, out);
+}
+
+void ref_mat4_transform_point(const float* m, const float* p, double* out) {
+    for (int row = 0; row < 4; row++) {
+        out[row] = (double)m[row] * p[0] + (double)m[4 + row] * p[1] +
+                   (double)m[8 + row] * p[2] + m[12 + row];
+    }
+}
+
+void ref_quat_from_axis_angle(const float* axis, float radians, double* out) {
+    double s = sin(radians * 0.5);
+    for (int i = 0; i < 3; i++) out[i] = axis[i] * s;
+    out[3] = cos(radians * 0.5);
+}
+
+static void quat_mul_d(const double* a, const double* b, double* out) {
+    double r[4] = {
+        a[3] * b[0] + a[0] * b[3] + a[1] * b[2] - a[2] * b[1],
+        a[3] * b[1] - a[0] * b[2] + a[1] * b[3] + a[2] * b[0],
+        a[3] * b[2] + a[0] * b[1] - a[1] * b[0] + a[2] * b[3],
+        a[3] * b[3] - a[0] * b[0] - a[1] * b[1] - a[2] * b[2],
+    };
+    memcpy(out, r, sizeof(r));
+}
+
+void ref_quat_mul(const float* a, const float* b, double* out) {
+    double da[4], db[4];
+    widen(a, 4, da);
+    widen(b, 4, db);
+    quat_mul_d(da, db, out);
+}
+
+static void quat_normalize_d(double* q) {
+    double len = sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+    if (len == 0.0) {
+        q[0] = q[1] = q[2] = 0.0;
+        q[3] = 1.0;
+        return;
+    }
+    for (int i = 0; i < 4; i++) q[i] /= len;
+}
+
+void ref_quat_normalize(const float* q, double* out) {
+    widen(q, 4, out);
+    quat_normalize_d(out);
+}
+
+// q v q*, written out
+static void quat_rotate_d(const double* q, const double* v, double* out) {
+    double p[4] = {v[0], v[1], v[2], 0.0};
+    double c[4] = {-q[0], -q[1], -q[2], q[3]};
+    double t[4];
+    quat_mul_d(q, p, t);
+    quat_mul_d(t, c, p);
+    memcpy(out, p, sizeof(double) * 3);
+}
+
+void ref_quat_rotate(const float* q, const float* v, double* out) {
+    double dq[4], dv[3];
+    widen(q, 4, dq);
+    widen(v, 3, dv);
+    quat_rotate_d(dq, dv, out);
+}
+
+void ref_quat_nlerp(const float* a, const float* b, float t, double* out) {
+    double d = 0.0;
+    for (int i = 0; i < 4; i++) d += (double)a[i] * b[i];
+    double s = d < 0.0 ? -t : t;
+    for (int i = 0; i < 4; i++) out[i] = a[i] * (1.0 - t) + b[i] * s;
+    quat_normalize_d(out);
+}
+
+// the exact arc, without the nlerp shortcut the float version takes near
+// parallel inputs
+static void quat_slerp_d(const double* a, const double* b, double t,
+                         double* out) {
+    double d = a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3];
+    double sign = d < 0.0 ? -1.0 : 1.0;
+    d = fmin(fabs(d), 1.0);
+    double theta = acos(d);
+    if (theta < 1e-12) {
+        memcpy(out, a, sizeof(double) * 4);
+        return;
+    }
+    double ka = sin((1.0 - t) * theta) / sin(theta);
+    double kb = sign * sin(t * theta) / sin(theta);
+    for (int i = 0; i < 4; i++) out[i] = a[i] * ka + b[i] * kb;
+}
+
+void ref_quat_slerp(const float* a, const float* b, float t, double* out) {
+    double da[4], db[4];
+    widen(a, 4, da);
+    widen(b, 4, db);
+    quat_slerp_d(da, db, t, out);
+}
+
+// rotation columns times scale, as affine columns 0-2
+static void basis_d(const double* q, const double* scale, double* out) {
+    double x = q[0], y = q[1], z = q[2], w = q[3];
+    double c[9] = {
+        1.0 - 2.0 * (y * y + z * z), 2.0 * (x * y + w * z), 2.0 * (x * z - w * y),
+        2.0 * (x * y - w * z), 1.0 - 2.0 * (x * x + z * z), 2.0 * (y * z + w * x),
+        2.0 * (x * z + w * y), 2.0 * (y * z - w * x), 1.0 - 2.0 * (x * x + y * y),
+    };
+    for (int i = 0; i < 9; i++) out[i] = c[i] * scale[i / 3];
+}
+
+void ref_quat_to_mat4(const float* q, double* out) {
+    float t[10] = {0.0f, 0.0f, 0.0f, q[0], q[1], q[2], q[3], 1.0f, 1.0f, 1.0f};
+    ref_trs_to_mat4(t, out);
+}
+
+void ref_affine_mul(const float* a, const float* b, double* out) {
+    for (int col = 0; col < 4; col++) {
+        for (int row = 0; row < 3; row++) {
+            out[col * 3 + row] = (double)a[row] * b[col * 3] +
+                                 (double)a[3 + row] * b[col * 3 + 1] +
+                                 (double)a[6 + row] * b[col * 3 + 2] +
+                                 (col == 3 ? a[9 + row] : 0.0);
+        }
+    }
+}
+
+void ref_affine_inverse(const float* m, double* out) {
+    double c[12], r[9];
+    widen(m, 12, c);
+    cross3(&c[3], &c[6], &r[0]);
+    cross3(&c[6], &c[0], &r[3]);
+    cross3(&c[0], &c[3], &r[6]);
+    double det = dot3(&c[0], &r[0]);
+    if (det == 0.0) {
+        memset(out, 0, sizeof(double) * 12);
+        out[0] = out[4] = out[8] = 1.0;
+        return;
+    }
+    for (int i = 0; i < 9; i++) r[i] /= det;
+    for (int row = 0; row < 3; row++) {
+        for (int col = 0; col < 3; col++) out[col * 3 + row] = r[row * 3 + col];
+        out[9 + row] = -dot3(&r[row * 3], &c[9]);
+    }
+}
+
+void ref_affine_transform_point(const float* m, const float* p, double* out) {
+    ref_affine_transform_dir(m, p, out);
+    for (int i = 0; i < 3; i++) out[i] += m[9 + i];
+}
+
+void ref_affine_transform_dir(const float* m, const float* d, double* out) {
+    for (int row = 0; row < 3; row++) {
+        out[row] = (double)m[row] * d[0] + (double)m[3 + row] * d[1] +
+                   (double)m[6 + row] * d[2];
+    }
+}
+
+void ref_trs_to_affine(const float* t, double* out) {
+    double q[4], s[3];
+    widen(&t[3], 4, q);
+    widen(&t[7], 3, s);
+    basis_d(q, s, out);
+    widen(t, 3, &out[9]);
+}
+
+void ref_trs_to_mat4(const float* t, double* out) {
+    double a[12];
+    ref_trs_to_affine(t, a);
+    widen_affine(a, out);
+}
+
+void ref_trs_mul(const float* parent, const float* child, double* out) {
+    double pq[4], cq[4], scaled[3], moved[3];
+    widen(&parent[3], 4, pq);
+    widen(&child[3], 4, cq);
+    for (int i = 0; i < 3; i++) scaled[i] = (double)parent[7 + i] * child[i];
+    quat_rotate_d(pq, scaled, moved);
+    for (int i = 0; i < 3; i++) out[i] = parent[i] + moved[i];
+    quat_mul_d(pq, cq, &out[3]);
+    for (int i = 0; i < 3; i++) out[7 + i] = (double)parent[7 + i] * child[7 + i];
+}
+
+void ref_trs_lerp(const float* a, const float* b, float t, double* out) {
+    ref_lerp(a, b, t, 3, out);
+    ref_quat_slerp(&a[3], &b[3], t, &out[3]);
+    ref_lerp(&a[7], &b[7], t, 3, &out[7]);
+}
+
+// gribb-hartmann for [0, 1] depth: left, right, bottom, top, near, far, each
+// scaled to a unit normal
+void ref_frustum_from_mat4(const float* view_proj, double* out) {
+    double r[4][4];
+    for (int row = 0; row < 4; row++) {
+        for (int col = 0; col < 4; col++) r[row][col] = view_proj[col * 4 + row];
+    }
+    for (int i = 0; i < 4; i++) {
+        out[0 + i] = r[3][i] + r[0][i];
+        out[4 + i] = r[3][i] - r[0][i];
+        out[8 + i] = r[3][i] + r[1][i];
+        out[12 + i] = r[3][i] - r[1][i];
+        out[16 + i] = r[2][i];
+        out[20 + i] = r[3][i] - r[2][i];
+    }
+    for (int p = 0; p < 6; p++) {
+        double* plane = &out[p * 4];
+        double  len = sqrt(dot3(plane, plane));
+        if (len == 0.0) continue;
+        for (int i = 0; i < 4; i++) plane[i] /= len;
+    }
+}
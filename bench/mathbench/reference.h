@@ -0,0 +1,51 @@
+// double precision references for mathbench's ulp check. each follows what
+// its mathf.h namesake is documented to compute, not its float evaluation
+// order, and takes the inputs as the float components of the mathf types
+// (vec3 = 3 floats, mat4 = 16 column major, trs = translation, rotation,
+// scale). results go to out in the same component order
+#pragma once
+#include <stdint.h>
+
+void ref_add(const float* a, const float* b, uint32_t n, double* out);
+void ref_sub(const float* a, const float* b, uint32_t n, double* out);
+void ref_mul(const float* a, const float* b, uint32_t n, double* out);
+void ref_scale(const float* v, float s, uint32_t n, double* out);
+void ref_div(const float* v, float s, uint32_t n, double* out);
+void ref_lerp(const float* a, const float* b, float t, uint32_t n, double* out);
+void ref_dot(const float* a, const float* b, uint32_t n, double* out);
+void ref_length(const float* v, uint32_t n, double* out);
+void ref_normalize(const float* v, uint32_t n, double* out);  // zero stays zero
+void ref_cross(const float* a, const float* b, double* out);
+
+void ref_mat4_translation(const float* t, double* out);
+void ref_mat4_rotation(int axis, float radians, double* out);  // 0 x, 1 y, 2 z
+void ref_mat4_perspective(float fov, float aspect, float near_z, float far_z,
+                          double* out);
+void ref_mat4_orthographic(float left, float right, float bottom, float top,
+                           float near_z, float far_z, double* out);
+void ref_mat4_look_at(const float* eye, const float* center, const float* up,
+                      double* out);
+void ref_mat4_mul(const float* a, const float* b, double* out);
+void ref_mat4_mul_affine(const float* a, const float* b, double* out);
+void ref_mat4_inverse_affine(const float* m, double* out);
+void ref_mat4_transform_point(const float* m, const float* p, double* out);
+
+void ref_quat_from_axis_angle(const float* axis, float radians, double* out);
+void ref_quat_mul(const float* a, const float* b, double* out);
+void ref_quat_normalize(const float* q, double* out);  // zero gives identity
+void ref_quat_rotate(const float* q, const float* v, double* out);
+void ref_quat_nlerp(const float* a, const float* b, float t, double* out);
+void ref_quat_slerp(const float* a, const float* b, float t, double* out);
+void ref_quat_to_mat4(const float* q, double* out);
+
+void ref_affine_mul(const float* a, const float* b, double* out);
+void ref_affine_inverse(const float* m, double* out);
+void ref_affine_transform_point(const float* m, const float* p, double* out);
+void ref_affine_transform_dir(const float* m, const float* d, double* out);
+
+void ref_trs_to_affine(const float* t, double* out);
+void ref_trs_to_mat4(const float* t, double* out);
+void ref_trs_mul(const float* parent, const float* child, double* out);
+void ref_trs_lerp(const float* a, const float* b, float t, double* out);
+
+void ref_frustum_from_mat4(const float* view_proj, double* out);
@@ -0,0 +1,114 @@
+// allocator micro benchmark: random small object churn against the engine
+// allocators and libc malloc
+//
+//   ./build release membench && ./bin/membench
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "base.h"
+#include "core/mem.h"
+#include "time_util.h"
+
+#define BENCH_SLOTS 4096
+#define BENCH_OPS 4000000
+#define BENCH_MIN_SIZE 16
+#define BENCH_MAX_SIZE 1024
+#define BENCH_ARENA mmega(64)
+
+typedef struct {
+    const char* name;
+    void* (*alloc)(void* ctx, size_t size);
+    void (*free)(void* ctx, void* ptr);
+    void* ctx;
+} bench_target;
+
+static uint32_t rng_state = 0x9e3779b9;
+
+static uint32_t rng_next(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+static void* engine_alloc(void* ctx, size_t size) {
+    return aalloc((allocator*)ctx, size);
+}
+
+static void engine_free(void* ctx, void* ptr) { afree((allocator*)ctx, ptr); }
+
+static void* libc_alloc(void* ctx, size_t size) {
+    unused(ctx);
+    return malloc(size);
+}
+
+static void libc_free(void* ctx, void* ptr) {
+    unused(ctx);
+    free(ptr);
+}
+
+static void run_churn(bench_target* target) {
+    static void* slots[BENCH_SLOTS];
+    for (uint32_t i = 0; i < BENCH_SLOTS; i++) {
+        slots[i] = NULL;
+    }
+    rng_state = 0x9e3779b9;
+    uint32_t failed = 0;
+
+    time_p start = time_now();
+    for (uint32_t i = 0; i < BENCH_OPS; i++) {
+        uint32_t r = rng_next();
+        uint32_t slot = r % BENCH_SLOTS;
+        if (slots[slot]) {
+            target->free(target->ctx, slots[slot]);
+            slots[slot] = NULL;
+        } else {
+            size_t size =
+                BENCH_MIN_SIZE + (r >> 12) % (BENCH_MAX_SIZE - BENCH_MIN_SIZE);
+            slots[slot] = target->alloc(target->ctx, size);
+            failed += slots[slot] == NULL;
+        }
+    }
+    time_p end = time_now();
+
+    for (uint32_t i = 0; i < BENCH_SLOTS; i++) {
+        if (slots[i]) target->free(target->ctx, slots[i]);
+    }
+    double sec = time_diff_sec(start, end);
+    printf("  %-8s %8.2f ns/op  (%u failed)\n", target->name,
+           sec * 1e9 / BENCH_OPS, failed);
+}
+
+int main(void) {
+    allocator* heap = allocator_create(ALLOCATOR_TYPE_HEAP, MEM_TAG_CORE, BENCH_ARENA);
+    allocator* pool = allocator_create(ALLOCATOR_TYPE_POOL, MEM_TAG_CORE, BENCH_ARENA);
+    allocator* tlsf = allocator_create(ALLOCATOR_TYPE_TLSF, MEM_TAG_CORE, BENCH_ARENA);
+    if (!heap || !pool || !tlsf) {
+        printf("failed to create allocators\n");
+        return 1;
+    }
+
+    bench_target targets[] = {
+        {"malloc", libc_alloc, libc_free, NULL},
+        {"heap", engine_alloc, engine_free, heap},
+        {"pool", engine_alloc, engine_free, pool},
+        {"tlsf", engine_alloc, engine_free, tlsf},
+    };
+
+    printf("churn: %d ops, %d live slots, %d-%d bytes\n", BENCH_OPS, BENCH_SLOTS,
+           BENCH_MIN_SIZE, BENCH_MAX_SIZE);
+    for (uint32_t i = 0; i < sizeof(targets) / sizeof(targets[0]); i++) {
+        run_churn(&targets[i]);
+    }
+
+    adestroy(tlsf);
+    adestroy(pool);
+    adestroy(heap);
+    return 0;
+}
+
+#include "base.c"
+#include "core/mem.c"
+#include "core/os_linux.c"
+#include "time_posix.c"
@@ -0,0 +1,396 @@
+// replays an allocation trace recorded with GAME0_MEM_TRACE against every
+// allocator type and libc malloc. each allocator seen in the trace gets its own
+// instance of the target type with the same capacity. calls are replayed in
+// recorded order on one thread, whatever thread made them
+//
+//   GAME0_MEM_TRACE=frames.trace ./bin/program
+//   ./build release memreplay && ./bin/memreplay frames.trace
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "base.h"
+#include "core/mem.h"
+#include "time_util.h"
+
+#define REPLAY_SAMPLE_RATE 1024  // replayed allocations between stats samples
+#define REPLAY_MAX_MARKERS 64
+#define REPLAY_TARGET_NULL -1    // bookkeeping only, subtracted from timings
+#define REPLAY_TARGET_MALLOC -2
+
+typedef struct {
+    uint64_t key;  // pointer in the recorded session, 0 for an empty slot
+    void*    ptr;
+    uint8_t  source;
+} live_entry;
+
+// recorded pointer -> replayed pointer, linear probing
+typedef struct {
+    live_entry* entries;
+    size_t      capacity;
+    size_t      count;
+} live_map;
+
+typedef struct {
+    uint64_t addr;
+    amarker  marker;
+} replay_marker;
+
+typedef struct {
+    allocator*    ator;
+    int           active;
+    uint32_t      marker_count;
+    replay_marker markers[REPLAY_MAX_MARKERS];
+} replay_source;
+
+typedef struct {
+    int32_t        target;  // allocator_type or REPLAY_TARGET_*
+    live_map       live;
+    replay_source  sources[MEM_MAX_ALLOCATORS];
+    uint64_t       fake;  // pointers handed out by the null target
+    uint64_t       allocs;
+    uint32_t       failed;
+    uint32_t       unmatched;
+    uint32_t       samples;
+    double         frag_sum;
+    double         frag_max;
+} replay_state;
+
+typedef struct {
+    const char* name;
+    int32_t     target;
+} replay_target;
+
+static const replay_target g_targets[] = {
+    {"null", REPLAY_TARGET_NULL},
+    {"malloc", REPLAY_TARGET_MALLOC},
+    {"stack", ALLOCATOR_TYPE_STACK},
+    {"heap", ALLOCATOR_TYPE_HEAP},
+    {"pool", ALLOCATOR_TYPE_POOL},
+    {"tlsf", ALLOCATOR_TYPE_TLSF},
+    {"tcache", ALLOCATOR_TYPE_TCACHE},
+};
+
+static size_t live_hash(uint64_t key, size_t capacity) {
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdull;
+    key ^= key >> 33;
+    return key & (capacity - 1);
+}
+
+static void live_init(live_map* map, size_t capacity) {
+    map->entries = calloc(capacity, sizeof(*map->entries));
+    map->capacity = capacity;
+    map->count = 0;
+}
+
+static void live_put(live_map* map, uint64_t key, void* ptr, uint8_t source);
+
+static void live_grow(live_map* map) {
+    live_map grown;
+    live_init(&grown, map->capacity * 2);
+    for (size_t i = 0; i < map->capacity; i++) {
+        live_entry* e = &map->entries[i];
+        if (e->key) live_put(&grown, e->key, e->ptr, e->source);
+    }
+    free(map->entries);
+    *map = grown;
+}
+
+static void live_put(live_map* map, uint64_t key, void* ptr, uint8_t source) {
+    if ((map->count + 1) * 2 > map->capacity) {
+        live_grow(map);
+    }
+    size_t i = live_hash(key, map->capacity);
+    while (map->entries[i].key) {
+        i = (i + 1) & (map->capacity - 1);
+    }
+    map->entries[i] = (live_entry){.key = key, .ptr = ptr, .source = source};
+    map->count++;
+}
+
+static live_entry* live_find(live_map* map, uint64_t key) {
+    size_t i = live_hash(key, map->capacity);
+    while (map->entries[i].key) {
+        if (map->entries[i].key == key) return &map->entries[i];
+        i = (i + 1) & (map->capacity - 1);
+    }
+    return NULL;
+}
+
+// backward shift, so lookups never need tombstones
+static void live_remove(live_map* map, live_entry* entry) {
+    size_t mask = map->capacity - 1;
+    size_t hole = (size_t)(entry - map->entries);
+    size_t i = hole;
+    for (;;) {
+        i = (i + 1) & mask;
+        if (!map->entries[i].key) break;
+        size_t home = live_hash(map->entries[i].key, map->capacity);
+        if (((i - home) & mask) >= ((i - hole) & mask)) {
+            map->entries[hole] = map->entries[i];
+            hole = i;
+        }
+    }
+    map->entries[hole].key = 0;
+    map->count--;
+}
+
+static void replay_release(replay_state* st, live_entry* e) {
+    replay_source* src = &st->sources[e->source];
+    if (st->target == REPLAY_TARGET_MALLOC) {
+        free(e->ptr);
+    } else if (src->ator && src->ator->type != ALLOCATOR_TYPE_STACK) {
+        afree(src->ator, e->ptr);
+    }
+}
+
+// drops every live allocation of `source` recorded at or above `addr`; resets
+// pass 0 and take everything. entries shift back on removal, so a slot is
+// revisited until it holds something we keep
+static void replay_drop(replay_state* st, uint8_t source, uint64_t addr,
+                        int release) {
+    live_map* map = &st->live;
+    for (size_t i = 0; i < map->capacity;) {
+        live_entry* e = &map->entries[i];
+        if (e->key && e->source == source && e->key >= addr) {
+            if (release) replay_release(st, e);
+            live_remove(map, e);
+        } else {
+            i++;
+        }
+    }
+}
+
+static void replay_sample(replay_state* st) {
+    for (uint32_t i = 0; i < MEM_MAX_ALLOCATORS; i++) {
+        allocator* ator = st->sources[i].ator;
+        if (!ator) continue;
+        mem_stats stats;
+        mem_stats_get(ator, &stats);
+        st->frag_sum += stats.fragmentation;
+        if (stats.fragmentation > st->frag_max) st->frag_max = stats.fragmentation;
+        st->samples++;
+    }
+}
+
+static void replay_record(replay_state* st, const mem_trace_record* r,
+                          int sample) {
+    if (r->allocator >= MEM_MAX_ALLOCATORS) return;
+    replay_source* src = &st->sources[r->allocator];
+    int            engine = st->target >= 0;
+
+    switch (r->op) {
+        case MEM_TRACE_CREATE: {
+            src->active = 1;
+            src->marker_count = 0;
+            if (engine) {
+                src->ator =
+                    allocator_create(st->target, MEM_TAG_CORE, (size_t)r->size);
+            }
+        } break;
+        case MEM_TRACE_DESTROY: {
+            replay_drop(st, r->allocator, 0, !engine);
+            if (src->ator) adestroy(src->ator);
+            src->ator = NULL;
+            src->active = 0;
+        } break;
+        case MEM_TRACE_ALLOC: {
+            if (!src->active || !r->ptr) return;
+            void* ptr;
+            if (st->target == REPLAY_TARGET_NULL) {
+                ptr = (void*)(uintptr_t)++st->fake;
+            } else if (st->target == REPLAY_TARGET_MALLOC) {
+                size_t align = (size_t)1 << r->align_log2;
+                size_t size = ((size_t)r->size + align - 1) & ~(align - 1);
+                ptr = align > 16 ? aligned_alloc(align, size) : malloc(size);
+            } else {
+                ptr = src->ator ? aalloc_algn(src->ator, (size_t)r->size,
+                                              (size_t)1 << r->align_log2)
+                                : NULL;
+            }
+            if (!ptr) {
+                st->failed++;
+                return;
+            }
+            live_put(&st->live, r->ptr, ptr, r->allocator);
+            if (sample && ++st->allocs % REPLAY_SAMPLE_RATE == 0) {
+                replay_sample(st);
+            }
+        } break;
+        case MEM_TRACE_FREE: {
+            live_entry* e = live_find(&st->live, r->ptr);
+            if (!e) {
+                // allocated before the trace started, or the replay failed it
+                st->unmatched += r->ptr != 0;
+                return;
+            }
+            replay_release(st, e);
+            live_remove(&st->live, e);
+        } break;
+        case MEM_TRACE_RESET: {
+            replay_drop(st, r->allocator, 0, !engine);
+            if (src->ator) areset(src->ator, 0);
+            src->marker_count = 0;
+        } break;
+        case MEM_TRACE_MARK: {
+            if (src->marker_count == REPLAY_MAX_MARKERS) return;
+            replay_marker* m = &src->markers[src->marker_count++];
+            m->addr = r->ptr;
+            if (src->ator && src->ator->type == ALLOCATOR_TYPE_STACK) {
+                m->marker = allocator_mark(src->ator);
+            }
+        } break;
+        case MEM_TRACE_REWIND: {
+            if (!src->marker_count) return;
+            replay_marker* m = &src->markers[--src->marker_count];
+            int stack = src->ator && src->ator->type == ALLOCATOR_TYPE_STACK;
+            replay_drop(st, r->allocator, m->addr, !stack);
+            if (stack) allocator_rewind(src->ator, m->marker);
+        } break;
+    }
+}
+
+static void replay_state_init(replay_state* st, int32_t target) {
+    memset(st, 0, sizeof(*st));
+    st->target = target;
+    live_init(&st->live, 1 << 16);
+}
+
+static void replay_state_free(replay_state* st) {
+    for (uint32_t i = 0; i < MEM_MAX_ALLOCATORS; i++) {
+        replay_drop(st, (uint8_t)i, 0, st->target == REPLAY_TARGET_MALLOC);
+        if (st->sources[i].ator) adestroy(st->sources[i].ator);
+    }
+    free(st->live.entries);
+}
+
+// one pass over the whole trace, returns seconds spent
+static double replay_run(replay_state* st, const mem_trace_record* records,
+                         size_t count, int sample) {
+    time_p start = time_now();
+    for (size_t i = 0; i < count; i++) {
+        replay_record(st, &records[i], sample);
+    }
+    time_p end = time_now();
+    return time_diff_sec(start, end);
+}
+
+// runs in a forked child so peak rss belongs to this target alone
+static void replay_target_run(const replay_target* target,
+                              const mem_trace_record* records, size_t count,
+                              size_t calls, double null_sec, long null_rss) {
+    replay_state st;
+    replay_state_init(&st, target->target);
+    double sec = replay_run(&st, records, count, 0);
+    replay_state_free(&st);
+
+    // second pass for fragmentation and peak live, sampling skews the timing
+    replay_state_init(&st, target->target);
+    replay_run(&st, records, count, 1);
+    mem_stats tag;
+    mem_tag_stats(MEM_TAG_CORE, &tag);
+    replay_state_free(&st);
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    double alloc_sec = sec > null_sec ? sec - null_sec : 0.0;
+    long   rss = usage.ru_maxrss - null_rss;
+
+    printf("  %-8s %10.2f %8.2f %10.2f", target->name, sec * 1e3,
+           alloc_sec * 1e9 / (double)calls, (double)(rss > 0 ? rss : 0) / 1024.0);
+    if (target->target >= 0) {
+        printf(" %10.2f %8.3f %8.3f", (double)tag.peak / (1024.0 * 1024.0),
+               st.samples ? st.frag_sum / st.samples : 0.0, st.frag_max);
+    } else {
+        printf(" %10s %8s %8s", "-", "-", "-");
+    }
+    printf(" %8u %8u\n", st.failed, st.unmatched);
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        printf("usage: %s <trace>\n", argv[0]);
+        return 1;
+    }
+    FILE* file = fopen(argv[1], "rb");
+    if (!file) {
+        printf("failed to open %s\n", argv[1]);
+        return 1;
+    }
+    mem_trace_header header;
+    if (fread(&header, sizeof(header), 1, file) != 1 ||
+        header.magic != MEM_TRACE_MAGIC || header.version != MEM_TRACE_VERSION ||
+        header.record_size != sizeof(mem_trace_record)) {
+        printf("%s is not a version %d memory trace\n", argv[1], MEM_TRACE_VERSION);
+        fclose(file);
+        return 1;
+    }
+    fseek(file, 0, SEEK_END);
+    size_t count =
+        ((size_t)ftell(file) - sizeof(header)) / sizeof(mem_trace_record);
+    fseek(file, sizeof(header), SEEK_SET);
+    mem_trace_record* records = malloc(count * sizeof(*records));
+    if (!records || fread(records, sizeof(*records), count, file) != count) {
+        printf("failed to read %zu records\n", count);
+        fclose(file);
+        return 1;
+    }
+    fclose(file);
+
+    size_t   allocs = 0, frees = 0, sources = 0;
+    uint32_t threads = 0;
+    for (size_t i = 0; i < count; i++) {
+        allocs += records[i].op == MEM_TRACE_ALLOC;
+        frees += records[i].op == MEM_TRACE_FREE;
+        sources += records[i].op == MEM_TRACE_CREATE;
+        if (records[i].thread + 1u > threads) threads = records[i].thread + 1u;
+    }
+    double duration = count ? records[count - 1].time_ns * 1e-9 : 0.0;
+    printf("%s: %zu records over %.2fs, %zu allocs, %zu frees, %zu allocators, "
+           "%u threads\n",
+           argv[1], count, duration, allocs, frees, sources, threads);
+    size_t calls = allocs + frees ? allocs + frees : 1;
+
+    printf("  %-8s %10s %8s %10s %10s %8s %8s %8s %8s\n", "target", "total ms",
+           "ns/call", "rss MB", "peak MB", "frag avg", "frag max", "failed",
+           "unmatched");
+
+    // the null target measures bookkeeping time and the trace's own rss, both
+    // subtracted from every other target
+    double null_sec = 0.0;
+    long   null_rss = 0;
+    {
+        replay_state st;
+        replay_state_init(&st, REPLAY_TARGET_NULL);
+        null_sec = replay_run(&st, records, count, 0);
+        replay_state_free(&st);
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        null_rss = usage.ru_maxrss;
+    }
+
+    for (size_t i = 1; i < sizeof(g_targets) / sizeof(g_targets[0]); i++) {
+        fflush(stdout);
+        pid_t pid = fork();
+        if (pid == 0) {
+            replay_target_run(&g_targets[i], records, count, calls, null_sec,
+                              null_rss);
+            fflush(stdout);
+            _exit(0);
+        }
+        int status;
+        waitpid(pid, &status, 0);
+    }
+    free(records);
+    return 0;
+}
+
+#include "base.c"
+#include "core/mem.c"
+#include "core/os_linux.c"
+#include "time_posix.c"
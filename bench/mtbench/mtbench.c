@@ -0,0 +1,267 @@
+// multi-threaded allocator stress: every thread churns its own slots, and a
+// share of the frees go through a common mailbox so blocks are released on a
+// different thread than the one that allocated them. a last case alternates
+// one thread between two thread cache allocators that share a binding entry
+//
+//   ./build release mtbench && ./bin/mtbench [max threads]
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "base.h"
+#include "core/mem.h"
+#include "time_util.h"
+
+#define BENCH_SLOTS 1024
+#define BENCH_OPS 2000000  // per thread
+#define BENCH_MIN_SIZE 16
+#define BENCH_MAX_SIZE 1024
+#define BENCH_LARGE_SIZE mkilo(8)  // one in BENCH_LARGE_RATE allocations
+#define BENCH_LARGE_RATE 256
+#define BENCH_REMOTE_RATE 16       // one in n frees goes through the mailbox
+#define BENCH_MAILBOX 4096
+#define BENCH_ARENA mmega(256)
+#define BENCH_MAX_THREADS 64
+#define BENCH_REBIND_OPS 100000  // alternations between the colliding pair
+
+typedef struct {
+    const char* name;
+    void* (*create)(void);
+    void (*destroy)(void* ctx);
+    void* (*alloc)(void* ctx, size_t size);
+    void (*free)(void* ctx, void* ptr);
+} bench_target;
+
+typedef struct {
+    bench_target* target;
+    void*         ctx;
+    uint32_t      seed;
+    uint32_t      failed;
+    pthread_t     handle;
+} bench_thread;
+
+static _Atomic(void*)   g_mailbox[BENCH_MAILBOX];
+static _Atomic uint32_t g_ready;
+static _Atomic uint32_t g_go;
+
+static uint32_t rng_next(uint32_t* state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+static void* libc_create(void) { return NULL; }
+
+static void libc_destroy(void* ctx) { unused(ctx); }
+
+static void* libc_alloc(void* ctx, size_t size) {
+    unused(ctx);
+    return malloc(size);
+}
+
+static void libc_free(void* ctx, void* ptr) {
+    unused(ctx);
+    free(ptr);
+}
+
+// the fallback every subsystem would reach for without a thread-safe type
+typedef struct {
+    allocator*      ator;
+    pthread_mutex_t lock;
+} locked_allocator;
+
+static void* locked_create(void) {
+    locked_allocator* l = malloc(sizeof(*l));
+    l->ator = allocator_create(ALLOCATOR_TYPE_TLSF, MEM_TAG_CORE, BENCH_ARENA);
+    pthread_mutex_init(&l->lock, NULL);
+    return l;
+}
+
+static void locked_destroy(void* ctx) {
+    locked_allocator* l = ctx;
+    pthread_mutex_destroy(&l->lock);
+    adestroy(l->ator);
+    free(l);
+}
+
+static void* locked_alloc(void* ctx, size_t size) {
+    locked_allocator* l = ctx;
+    pthread_mutex_lock(&l->lock);
+    void* ptr = aalloc(l->ator, size);
+    pthread_mutex_unlock(&l->lock);
+    return ptr;
+}
+
+static void locked_free(void* ctx, void* ptr) {
+    locked_allocator* l = ctx;
+    pthread_mutex_lock(&l->lock);
+    afree(l->ator, ptr);
+    pthread_mutex_unlock(&l->lock);
+}
+
+static void* tcache_create(void) {
+    return allocator_create(ALLOCATOR_TYPE_TCACHE, MEM_TAG_CORE, BENCH_ARENA);
+}
+
+static void tcache_destroy(void* ctx) { adestroy((allocator*)ctx); }
+
+static void* tcache_alloc(void* ctx, size_t size) {
+    return aalloc((allocator*)ctx, size);
+}
+
+static void tcache_free(void* ctx, void* ptr) { afree((allocator*)ctx, ptr); }
+
+static void* run_thread(void* arg) {
+    bench_thread* t = arg;
+    bench_target* target = t->target;
+    void*         slots[BENCH_SLOTS] = {0};
+    uint32_t      rng = t->seed;
+
+    atomic_fetch_add(&g_ready, 1);
+    while (!atomic_load_explicit(&g_go, memory_order_acquire)) {
+    }
+
+    for (uint32_t i = 0; i < BENCH_OPS; i++) {
+        uint32_t r = rng_next(&rng);
+        uint32_t slot = r % BENCH_SLOTS;
+        if (slots[slot]) {
+            void* ptr = slots[slot];
+            slots[slot] = NULL;
+            if ((r >> 24) % BENCH_REMOTE_RATE == 0) {
+                // park ours, free whatever another thread parked there
+                uint32_t box = (r >> 10) % BENCH_MAILBOX;
+                ptr = atomic_exchange_explicit(&g_mailbox[box], ptr,
+                                               memory_order_acq_rel);
+            }
+            if (ptr) target->free(t->ctx, ptr);
+        } else {
+            size_t size = (r >> 12) % BENCH_LARGE_RATE
+                              ? BENCH_MIN_SIZE +
+                                    (r >> 12) % (BENCH_MAX_SIZE - BENCH_MIN_SIZE)
+                              : BENCH_LARGE_SIZE;
+            slots[slot] = target->alloc(t->ctx, size);
+            t->failed += slots[slot] == NULL;
+        }
+    }
+
+    for (uint32_t i = 0; i < BENCH_SLOTS; i++) {
+        if (slots[i]) target->free(t->ctx, slots[i]);
+    }
+    return NULL;
+}
+
+static double run_target(bench_target* target, uint32_t thread_count) {
+    static bench_thread threads[BENCH_MAX_THREADS];
+    void*               ctx = target->create();
+    atomic_store(&g_ready, 0);
+    atomic_store(&g_go, 0);
+
+    for (uint32_t i = 0; i < thread_count; i++) {
+        threads[i].target = target;
+        threads[i].ctx = ctx;
+        threads[i].seed = 0x9e3779b9 ^ (i * 0x85ebca6b + 1);
+        threads[i].failed = 0;
+        pthread_create(&threads[i].handle, NULL, run_thread, &threads[i]);
+    }
+    while (atomic_load(&g_ready) != thread_count) {
+    }
+
+    time_p start = time_now();
+    atomic_store_explicit(&g_go, 1, memory_order_release);
+    uint32_t failed = 0;
+    for (uint32_t i = 0; i < thread_count; i++) {
+        pthread_join(threads[i].handle, NULL);
+        failed += threads[i].failed;
+    }
+    time_p end = time_now();
+
+    for (uint32_t i = 0; i < BENCH_MAILBOX; i++) {
+        void* ptr = atomic_exchange(&g_mailbox[i], NULL);
+        if (ptr) target->free(ctx, ptr);
+    }
+    target->destroy(ctx);
+
+    double sec = time_diff_sec(start, end);
+    double mops = (double)BENCH_OPS * thread_count / sec / 1e6;
+    printf("  %-8s %8.2f Mops/s %8.2f ns/op/thread  (%u failed)\n", target->name,
+           mops, sec * 1e9 / BENCH_OPS, failed);
+    return mops;
+}
+
+// allocator ids are handed out in sequence and the thread bindings are direct
+// mapped on them, so the first and the last of nine in a row collide. every
+// alternation misses the binding cache and must find the thread's existing
+// slot rather than claim a fresh one
+static void run_rebind(void) {
+    allocator* ators[9];
+    for (uint32_t i = 0; i < 9; i++) {
+        ators[i] = allocator_create(ALLOCATOR_TYPE_TCACHE, MEM_TAG_CORE,
+                                    mmega(4));
+    }
+    allocator* a = ators[0];
+    allocator* b = ators[8];
+    for (uint32_t i = 1; i < 8; i++) adestroy(ators[i]);
+
+    uint32_t failed = 0;
+    time_p   start = time_now();
+    for (uint32_t i = 0; i < BENCH_REBIND_OPS; i++) {
+        void* pa = aalloc(a, 64);
+        void* pb = aalloc(b, 64);
+        failed += !pa + !pb;
+        if (pa) afree(a, pa);
+        if (pb) afree(b, pb);
+    }
+    double ns = time_diff_sec(start, time_now()) * 1e9 / (BENCH_REBIND_OPS * 4);
+
+    size_t used_a, used_b, total;
+    aget_info(a, &used_a, &total);
+    aget_info(b, &used_b, &total);
+    printf("rebind: 2 colliding tcache allocators, %d alternations\n",
+           BENCH_REBIND_OPS);
+    printf("  %-8s %8.2f ns/op  (%u failed, %zu bytes left live)\n", "tcache",
+           ns, failed, used_a + used_b);
+    adestroy(a);
+    adestroy(b);
+}
+
+int main(int argc, char** argv) {
+    long max_threads = argc > 1 ? atol(argv[1]) : sysconf(_SC_NPROCESSORS_ONLN);
+    if (max_threads < 1) max_threads = 1;
+    if (max_threads > BENCH_MAX_THREADS) max_threads = BENCH_MAX_THREADS;
+
+    bench_target targets[] = {
+        {"malloc", libc_create, libc_destroy, libc_alloc, libc_free},
+        {"locked", locked_create, locked_destroy, locked_alloc, locked_free},
+        {"tcache", tcache_create, tcache_destroy, tcache_alloc, tcache_free},
+    };
+    const uint32_t target_count = sizeof(targets) / sizeof(targets[0]);
+    double         base[sizeof(targets) / sizeof(targets[0])] = {0};
+
+    printf("stress: %d ops/thread, %d live slots, %d-%d bytes, 1/%d remote frees\n",
+           BENCH_OPS, BENCH_SLOTS, BENCH_MIN_SIZE, BENCH_MAX_SIZE,
+           BENCH_REMOTE_RATE);
+    for (uint32_t n = 1; n <= (uint32_t)max_threads; n *= 2) {
+        printf("%u thread(s)\n", n);
+        for (uint32_t i = 0; i < target_count; i++) {
+            double mops = run_target(&targets[i], n);
+            if (n == 1) base[i] = mops;
+            else printf("  %-8s %8.2fx scaling\n", "", mops / base[i]);
+        }
+        if (n < (uint32_t)max_threads && n * 2 > (uint32_t)max_threads) {
+            n = (uint32_t)max_threads / 2;
+        }
+    }
+    run_rebind();
+    return 0;
+}
+
+#include "base.c"
+#include "core/mem.c"
+#include "core/os_linux.c"
+#include "time_posix.c"
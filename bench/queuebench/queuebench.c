@@ -0,0 +1,207 @@
+// queue contention: producers and consumers moving 64-bit items through an
+// spsc ring, the mpmc ring at 1:1 up to n:n, and a mutex guarded ring as the
+// baseline. every run checks that each item came out exactly once, and the
+// spsc run that they came out in order
+//
+//   ./build release queuebench && ./bin/queuebench [max threads]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "base.h"
+#include "core/mem.h"
+#include "core/os_thread.h"
+#include "core/queue.h"
+#include "time_util.h"
+
+#define BENCH_ITEMS (1 << 22)  // per run, split between the producers
+#define BENCH_CAPACITY 1024
+#define BENCH_SPIN 64  // failed tries before a thread yields its core
+#define BENCH_MAX_SIDE 16
+
+// the baseline: a plain ring behind one lock
+typedef struct {
+    os_mutex  lock;
+    uint64_t* items;
+    uint64_t  head;
+    uint64_t  tail;
+    uint64_t  mask;
+} locked_queue;
+
+static int locked_push(void* queue, const void* item) {
+    locked_queue* q = queue;
+    os_mutex_lock(&q->lock);
+    int ok = q->tail - q->head <= q->mask;
+    if (ok) q->items[q->tail++ & q->mask] = *(const uint64_t*)item;
+    os_mutex_unlock(&q->lock);
+    return ok;
+}
+
+static int locked_pop(void* queue, void* item) {
+    locked_queue* q = queue;
+    os_mutex_lock(&q->lock);
+    int ok = q->head != q->tail;
+    if (ok) *(uint64_t*)item = q->items[q->head++ & q->mask];
+    os_mutex_unlock(&q->lock);
+    return ok;
+}
+
+static int spsc_push_any(void* q, const void* item) { return spsc_push(q, item); }
+static int spsc_pop_any(void* q, void* item) { return spsc_pop(q, item); }
+static int mpmc_push_any(void* q, const void* item) { return mpmc_push(q, item); }
+static int mpmc_pop_any(void* q, void* item) { return mpmc_pop(q, item); }
+
+typedef struct {
+    void* queue;
+    int (*push)(void* q, const void* item);
+    int (*pop)(void* q, void* item);
+    uint32_t producers;
+    uint32_t consumers;
+    atom_u32 ready;
+    os_event go;
+    atom_u64 popped;  // items taken so far, the consumers stop at BENCH_ITEMS
+} bench_run;
+
+typedef struct {
+    bench_run* run;
+    uint32_t   index;
+    uint64_t   sum;
+    uint64_t   count;
+    uint32_t   out_of_order;
+} bench_side;
+
+static void backoff(uint32_t* tries) {
+    if (++*tries < BENCH_SPIN) {
+        os_cpu_pause();
+    } else {
+        os_thread_yield();
+        *tries = 0;
+    }
+}
+
+static void start(bench_run* run) {
+    atom_add_acq_rel(&run->ready, 1);
+    os_event_wait(&run->go, OS_WAIT_FOREVER);
+}
+
+// producer p sends p, p + producers, p + 2 * producers .. so the values cover
+// 0 .. BENCH_ITEMS - 1 once between them
+static void* producer_main(void* arg) {
+    bench_side* side = arg;
+    bench_run*  run = side->run;
+    start(run);
+    for (uint64_t v = side->index; v < BENCH_ITEMS; v += run->producers) {
+        uint32_t tries = 0;
+        while (!run->push(run->queue, &v)) backoff(&tries);
+    }
+    return NULL;
+}
+
+static void* consumer_main(void* arg) {
+    bench_side* side = arg;
+    bench_run*  run = side->run;
+    start(run);
+    uint64_t expected = 0;
+    uint32_t tries = 0;
+    while (atom_load_relaxed(&run->popped) < BENCH_ITEMS) {
+        uint64_t v;
+        if (!run->pop(run->queue, &v)) {
+            backoff(&tries);
+            continue;
+        }
+        tries = 0;
+        atom_add_relaxed(&run->popped, 1);
+        side->out_of_order += v != expected++;
+        side->sum += v;
+        side->count++;
+    }
+    return NULL;
+}
+
+// ns per item from the first push to the last pop. *failed counts items lost,
+// duplicated or, with check_order, out of order
+static double run_queue(bench_run* run, int check_order, uint32_t* failed) {
+    bench_side sides[BENCH_MAX_SIDE * 2];
+    os_thread  threads[BENCH_MAX_SIDE * 2];
+    uint32_t   count = run->producers + run->consumers;
+    atom_store_relaxed(&run->ready, 0);
+    atom_store_relaxed(&run->popped, 0);
+    os_event_reset(&run->go);
+    for (uint32_t i = 0; i < count; i++) {
+        int producer = i < run->producers;
+        sides[i] = (bench_side){run, producer ? i : i - run->producers, 0, 0, 0};
+        os_thread_create(&threads[i], producer ? producer_main : consumer_main,
+                         &sides[i], producer ? "producer" : "consumer");
+    }
+    while (atom_load_acquire(&run->ready) < count) os_thread_yield();
+    time_p begin = time_now();
+    os_event_set(&run->go);
+    for (uint32_t i = 0; i < count; i++) os_thread_join(&threads[i]);
+    double ns = time_diff_sec(begin, time_now()) * 1e9 / BENCH_ITEMS;
+
+    uint64_t sum = 0, items = 0;
+    for (uint32_t i = run->producers; i < count; i++) {
+        sum += sides[i].sum;
+        items += sides[i].count;
+        if (check_order) *failed += sides[i].out_of_order;
+    }
+    const uint64_t n = BENCH_ITEMS;
+    *failed += items != n || sum != n * (n - 1) / 2;
+    return ns;
+}
+
+int main(int argc, char** argv) {
+    long max_threads = argc > 1 ? atol(argv[1]) : sysconf(_SC_NPROCESSORS_ONLN);
+    if (max_threads < 2) max_threads = 2;
+    if (max_threads > BENCH_MAX_SIDE * 2) max_threads = BENCH_MAX_SIDE * 2;
+
+    allocator* ator = allocator_create(ALLOCATOR_TYPE_TLSF, MEM_TAG_CORE,
+                                       mmega(4));
+    uint32_t failed = 0;
+
+    printf("%d items through a %d slot ring\n", BENCH_ITEMS, BENCH_CAPACITY);
+    printf("  %-8s %-6s %10s %10s\n", "queue", "p:c", "ns/item", "Mitems/s");
+
+    spsc_queue spsc;
+    spsc_init_type(&spsc, ator, uint64_t, BENCH_CAPACITY);
+    bench_run run = {.queue = &spsc, .push = spsc_push_any, .pop = spsc_pop_any,
+                     .producers = 1, .consumers = 1};
+    double    ns = run_queue(&run, 1, &failed);
+    printf("  %-8s %-6s %10.2f %10.2f\n", "spsc", "1:1", ns, 1e3 / ns);
+    spsc_destroy(&spsc);
+
+    mpmc_queue   mpmc;
+    locked_queue locked = {0};
+    mpmc_init_type(&mpmc, ator, uint64_t, BENCH_CAPACITY);
+    locked.items = aalloc_array(ator, uint64_t, BENCH_CAPACITY);
+    locked.mask = BENCH_CAPACITY - 1;
+    for (uint32_t side = 1; side * 2 <= (uint32_t)max_threads; side *= 2) {
+        char label[16];
+        snprintf(label, sizeof(label), "%u:%u", side, side);
+        run = (bench_run){.queue = &mpmc, .push = mpmc_push_any,
+                          .pop = mpmc_pop_any, .producers = side, .consumers = side};
+        ns = run_queue(&run, 0, &failed);
+        printf("  %-8s %-6s %10.2f %10.2f\n", "mpmc", label, ns, 1e3 / ns);
+
+        locked.head = locked.tail = 0;
+        run = (bench_run){.queue = &locked, .push = locked_push, .pop = locked_pop,
+                          .producers = side, .consumers = side};
+        ns = run_queue(&run, 0, &failed);
+        printf("  %-8s %-6s %10.2f %10.2f\n", "locked", label, ns, 1e3 / ns);
+    }
+    mpmc_destroy(&mpmc);
+    afree(ator, locked.items);
+
+    printf("%s\n", failed ? "FAILED" : "ok");
+    adestroy(ator);
+    return failed ? 1 : 0;
+}
+
+#include "base.c"
+#include "core/mem.c"
+#include "core/os_linux.c"
+#include "core/os_thread_linux.c"
+#include "core/queue.c"
+#include "time_posix.c"
@@ -33,6 +33,7 @@ typedef enum {
 
 #ifdef OS_LINUX
     LIB_ID_WAYLAND,
+    LIB_ID_PTHREAD,
 #endif  // OS_LINUX
 
     LIB_ID_COUNT,
@@ -52,6 +53,7 @@ typedef enum {
 
 typedef enum {
     DEFINE_ID_DEBUG = 0,
+    DEFINE_ID_MATHF_INLINE,
     DEFINE_ID_COUNT,
 } define_id;
 
@@ -66,6 +68,15 @@ typedef enum {
 #ifdef OS_LINUX
     MODULE_ID_XDG_SHELL,
 #endif  // OS_LINUX
+    MODULE_ID_MEMBENCH,
+    MODULE_ID_MTBENCH,
+    MODULE_ID_MEMREPLAY,
+    MODULE_ID_MATHBENCH,
+    MODULE_ID_CAMERABENCH,
+    MODULE_ID_JOBBENCH,
+    MODULE_ID_FIBERBENCH,
+    MODULE_ID_QUEUEBENCH,
+    MODULE_ID_ECSBENCH,
     MODULE_ID_COUNT
 } module_id;
 
@@ -87,7 +98,16 @@ typedef struct {
 } module_info;
 
 typedef enum {
-    ARTIFACT_ID_PROGRAM,  // only have the game for now
+    ARTIFACT_ID_PROGRAM,
+    ARTIFACT_ID_MEMBENCH,
+    ARTIFACT_ID_MTBENCH,
+    ARTIFACT_ID_MEMREPLAY,
+    ARTIFACT_ID_MATHBENCH,
+    ARTIFACT_ID_CAMERABENCH,
+    ARTIFACT_ID_JOBBENCH,
+    ARTIFACT_ID_FIBERBENCH,
+    ARTIFACT_ID_QUEUEBENCH,
+    ARTIFACT_ID_ECSBENCH,
     ARTIFACT_ID_COUNT,
 } artifact_id;
 
@@ -100,7 +120,10 @@ typedef struct {
 static char* g_libs[LIB_ID_COUNT] = {
     "-lvulkan",
     "-lm",
+#ifdef OS_LINUX
     "-lwayland-client",
+    "-lpthread",
+#endif  // OS_LINUX
 };
 
 static char* g_links[LINK_ID_COUNT] = {
@@ -115,10 +138,11 @@ static char* g_includes[INCLUDE_ID_COUNT] = {
 
 static char* g_defines[DEFINE_ID_COUNT] = {
     "-D_DEBUG",
+    "-DMATHF_INLINE",
 };
 
 static char* g_flags[FLAG_ID_COUNT] = {
-    "-o2",
+    "-O2",
     "-g",
 };
 
@@ -139,6 +163,7 @@ static module_info g_module_infos[MODULE_ID_COUNT] = {
         .libs[LIB_ID_MATH] = 1,
 #ifdef OS_LINUX
         .libs[LIB_ID_WAYLAND] = 1,
+        .libs[LIB_ID_PTHREAD] = 1,
 #endif  // OS_LINUX
         // flags and defines will be assigned based on user input
         .pre_build = program_prebuild,
@@ -150,6 +175,73 @@ static module_info g_module_infos[MODULE_ID_COUNT] = {
         .pre_build = xdg_shell_prebuild,
     },
 #endif
+    // benchmarks are single translation units that include the engine sources
+    // they exercise, so they don't drag in the program's main()
+    {
+        .name = "membench",
+        .src_dir = "./bench/membench",
+        .includes[INCLUDE_ID_PROGRAM] = 1,
+        .libs[LIB_ID_MATH] = 1,
+    },
+    {
+        .name = "mtbench",
+        .src_dir = "./bench/mtbench",
+        .includes[INCLUDE_ID_PROGRAM] = 1,
+        .libs[LIB_ID_MATH] = 1,
+#ifdef OS_LINUX
+        .libs[LIB_ID_PTHREAD] = 1,
+#endif  // OS_LINUX
+    },
+    {
+        .name = "memreplay",
+        .src_dir = "./bench/memreplay",
+        .includes[INCLUDE_ID_PROGRAM] = 1,
+        .libs[LIB_ID_MATH] = 1,
+    },
+    {
+        .name = "mathbench",
+        .src_dir = "./bench/mathbench",
+        .includes[INCLUDE_ID_PROGRAM] = 1,
+        .libs[LIB_ID_MATH] = 1,
+    },
+    {
+        .name = "camerabench",
+        .src_dir = "./bench/camerabench",
+        .includes[INCLUDE_ID_PROGRAM] = 1,
+        .libs[LIB_ID_MATH] = 1,
+    },
+    {
+        .name = "jobbench",
+        .src_dir = "./bench/jobbench",
+        .includes[INCLUDE_ID_PROGRAM] = 1,
+        .libs[LIB_ID_MATH] = 1,
+#ifdef OS_LINUX
+        .libs[LIB_ID_PTHREAD] = 1,
+#endif  // OS_LINUX
+    },
+    {
+        .name = "fiberbench",
+        .src_dir = "./bench/fiberbench",
+        .includes[INCLUDE_ID_PROGRAM] = 1,
+        .libs[LIB_ID_MATH] = 1,
+#ifdef OS_LINUX
+        .libs[LIB_ID_PTHREAD] = 1,
+#endif  // OS_LINUX
+    },
+    {
+        .name = "queuebench",
+        .src_dir = "./bench/queuebench",
+        .includes[INCLUDE_ID_PROGRAM] = 1,
+#ifdef OS_LINUX
+        .libs[LIB_ID_PTHREAD] = 1,
+#endif  // OS_LINUX
+    },
+    {
+        .name = "ecsbench",
+        .src_dir = "./bench/ecsbench",
+        .includes[INCLUDE_ID_PROGRAM] = 1,
+        .libs[LIB_ID_MATH] = 1,
+    },
 };
 
 static artifact_info g_artifacts[ARTIFACT_ID_COUNT] = {
@@ -168,6 +260,51 @@ static artifact_info g_artifacts[ARTIFACT_ID_COUNT] = {
         .module_count = 1,
 #endif
     },
+    {
+        .name = "membench",
+        .modules = {MODULE_ID_MEMBENCH},
+        .module_count = 1,
+    },
+    {
+        .name = "mtbench",
+        .modules = {MODULE_ID_MTBENCH},
+        .module_count = 1,
+    },
+    {
+        .name = "memreplay",
+        .modules = {MODULE_ID_MEMREPLAY},
+        .module_count = 1,
+    },
+    {
+        .name = "mathbench",
+        .modules = {MODULE_ID_MATHBENCH},
+        .module_count = 1,
+    },
+    {
+        .name = "camerabench",
+        .modules = {MODULE_ID_CAMERABENCH},
+        .module_count = 1,
+    },
+    {
+        .name = "jobbench",
+        .modules = {MODULE_ID_JOBBENCH},
+        .module_count = 1,
+    },
+    {
+        .name = "fiberbench",
+        .modules = {MODULE_ID_FIBERBENCH},
+        .module_count = 1,
+    },
+    {
+        .name = "queuebench",
+        .modules = {MODULE_ID_QUEUEBENCH},
+        .module_count = 1,
+    },
+    {
+        .name = "ecsbench",
+        .modules = {MODULE_ID_ECSBENCH},
+        .module_count = 1,
+    },
 };
 static int64_t g_build_start_time = 0;
 static int64_t g_build_end_time = 0;
@@ -178,10 +315,12 @@ static int  bootstrap(int argc, char** argv);
 static int  build_artifact(artifact_info* artifact, build_mode mode);
 static int  compile_module(module_info* module, build_mode mode, int* obj_count);
 static int  compile_directory(module_info* module, const char** cc, int input_idx,
-                              int output_idx, int* obj_count);
+                              int output_idx, const char* obj_dir, int* obj_count);
 static int  add_object_files(const char* obj_dir, const char** cmd, int* idx);
-static int  link_artifact(artifact_info* artifact);
+static int  link_artifact(artifact_info* artifact, build_mode mode);
 static int  setup_vulkan_paths(void);
+static int  mathf_inline_enabled(build_mode mode);
+static void module_obj_dir(module_info* module, build_mode mode, char* out);
 static void ensure_directories_exist(void);
 
 static int find_xdg_shell_xml(const char* protocols_dir, char* output_path);
@@ -251,6 +390,26 @@ static int setup_vulkan_paths(void) {
     return 0;
 }
 
+// release builds compile mathf as static inline definitions from the header so
+// the math inlines across units; debug keeps mathf.c for stepping through.
+// GAME0_MATHF_INLINE=0/1 overrides either way
+static int mathf_inline_enabled(build_mode mode) {
+    char* env = os_getenv("GAME0_MATHF_INLINE");
+    if (env) {
+        return strcmp(env, "0") != 0;
+    }
+    return mode == BUILD_MODE_RELEASE;
+}
+
+// objects only rebuild when their source is newer, so every combination of
+// mode and mathf inlining keeps its own tree; switching between them never
+// links objects compiled for another
+static void module_obj_dir(module_info* module, build_mode mode, char* out) {
+    snprintf(out, OS_MAX_PATH, "%s" OS_PATH_SEP "%s-%s" OS_PATH_SEP "%s",
+             OBJ_DIR, mode == BUILD_MODE_DEBUG ? "debug" : "release",
+             mathf_inline_enabled(mode) ? "inline" : "noinline", module->name);
+}
+
 static void ensure_directories_exist(void) {
     if (!dir_exists(BIN_DIR)) {
         dir_create(BIN_DIR);
@@ -283,6 +442,9 @@ void print_usage(const char* prog) {
     printf("  release [target]  Build target in release mode\n");
     printf("  help              Show this help\n\n");
 
+    printf("Environment:\n");
+    printf("  GAME0_MATHF_INLINE=0|1  Inline mathf (default: on for release)\n\n");
+
     printf("Available targets:\n");
     for (int i = 0; i < ARTIFACT_ID_COUNT; i++) {
         printf("  %s\n", g_artifacts[i].name);
@@ -340,6 +502,7 @@ int compile_module(module_info* module, build_mode mode, int* obj_count) {
     module->flags[FLAG_ID_O2] = mode == BUILD_MODE_RELEASE;
     module->flags[FLAG_ID_GSYMBOLS] = mode == BUILD_MODE_DEBUG;
     module->defines[DEFINE_ID_DEBUG] = mode == BUILD_MODE_DEBUG;
+    module->defines[DEFINE_ID_MATHF_INLINE] = mathf_inline_enabled(mode);
 
     const char* cc[MAX_COMPILE_FLAGS] = {0};
 
@@ -368,11 +531,14 @@ int compile_module(module_info* module, build_mode mode, int* obj_count) {
         }
     }
 
-    return compile_directory(module, cc, input_idx, output_idx, obj_count);
+    char obj_dir[OS_MAX_PATH];
+    module_obj_dir(module, mode, obj_dir);
+    return compile_directory(module, cc, input_idx, output_idx, obj_dir,
+                             obj_count);
 }
 
 static int compile_directory(module_info* module, const char** cc, int input_idx,
-                             int output_idx, int* obj_count) {
+                             int output_idx, const char* obj_dir, int* obj_count) {
     dir_info stack[MAX_FOLDER_DEPTH] = {0};
     int      top = 0;
 
@@ -420,8 +586,7 @@ static int compile_directory(module_info* module, const char** cc, int input_idx
         basename[len] = '\0';
 
         char ofile[OS_MAX_PATH];
-        snprintf(ofile, OS_MAX_PATH, "%s" OS_PATH_SEP "%s" OS_PATH_SEP "%s.o",
-                 OBJ_DIR, module->name, basename);
+        snprintf(ofile, OS_MAX_PATH, "%s" OS_PATH_SEP "%s.o", obj_dir, basename);
         uint64_t imod = file_modtime(ifile);
         uint64_t omod = file_modtime(ofile);
 
@@ -456,8 +621,7 @@ int build_artifact(artifact_info* artifact, build_mode mode) {
         module_info* module = &g_module_infos[artifact->modules[i]];
 
         char obj_dir[OS_MAX_PATH];
-        snprintf(obj_dir, OS_MAX_PATH, "./%s" OS_PATH_SEP "%s", OBJ_DIR,
-                 module->name);
+        module_obj_dir(module, mode, obj_dir);
         if (!dir_exists(obj_dir)) {
             dir_create_recurse(obj_dir);
         }
@@ -471,13 +635,13 @@ int build_artifact(artifact_info* artifact, build_mode mode) {
     }
 
     printf("generating artifact '%s'\n", artifact->name);
-    if (link_artifact(artifact) != 0) {
+    if (link_artifact(artifact, mode) != 0) {
         return 1;
     }
     return 0;
 }
 
-int link_artifact(artifact_info* artifact) {
+int link_artifact(artifact_info* artifact, build_mode mode) {
     const char* linker_cmd[MAX_COMPILE_FLAGS] = {0};
     int         idx = 0;
     char        out_path[128];
@@ -510,7 +674,7 @@ int link_artifact(artifact_info* artifact) {
     for (int mod_idx = 0; mod_idx < artifact->module_count; mod_idx++) {
         module_info* module = &g_module_infos[artifact->modules[mod_idx]];
         char         obj_dir[OS_MAX_PATH];
-        snprintf(obj_dir, OS_MAX_PATH, "%s/%s", OBJ_DIR, module->name);
+        module_obj_dir(module, mode, obj_dir);
 
         if (add_object_files(obj_dir, linker_cmd, &idx) != 0) {
             return 1;
@@ -25,6 +25,7 @@ camera camera_create_fps(vec3 position, float fov, float aspect, float near_plan
     cam.mouse_sensitivity = DEFAULT_SENSITIVITY;
     cam.type = CAMERA_TYPE_FPS;
     
+    cam.dirty = CAMERA_DIRTY_ALL;
     camera_update_vectors(&cam);
     return cam;
 }
@@ -43,6 +44,7 @@ camera camera_create_orbit(vec3 target, float distance, float fov, float aspect,
     cam.mouse_sensitivity = DEFAULT_SENSITIVITY;
     cam.type = CAMERA_TYPE_ORBIT;
     
+    cam.dirty = CAMERA_DIRTY_ALL;
     camera_update_vectors(&cam);
     return cam;
 }
@@ -61,11 +63,12 @@ camera camera_create_free(vec3 position, vec3 target, float fov, float aspect, f
     cam.mouse_sensitivity = DEFAULT_SENSITIVITY;
     cam.type = CAMERA_TYPE_FREE;
     
+    cam.dirty = CAMERA_DIRTY_ALL;
     camera_update_vectors(&cam);
     return cam;
 }
 
-mat4 camera_view_matrix(const camera* cam) {
+static mat4 camera_build_view(const camera* cam) {
     switch(cam->type) {
         case CAMERA_TYPE_ORBIT:
             return mat4_look_at(cam->position, cam->target, cam->up);
@@ -77,15 +80,94 @@ mat4 camera_view_matrix(const camera* cam) {
     }
 }
 
-mat4 camera_projection_matrix(const camera* cam) {
-    return mat4_perspective(cam->fov, cam->aspect, cam->near_plane, cam->far_plane);
+// Closed form inverse of mat4_perspective: clip = (a x, b y, c z + d, z)
+static mat4 camera_inverse_perspective(const mat4* proj) {
+    float a = proj->m[0], b = proj->m[5], c = proj->m[10], d = proj->m[14];
+    mat4 inv = {0};
+    inv.m[0] = 1.0f / a;
+    inv.m[5] = 1.0f / b;
+    inv.m[11] = 1.0f / d;
+    inv.m[14] = 1.0f;
+    inv.m[15] = -c / d;
+    return inv;
 }
 
-mat4 camera_mvp_matrix(const camera* cam, const mat4* model) {
-    mat4 view = camera_view_matrix(cam);
-    mat4 proj = camera_projection_matrix(cam);
-    mat4 vp = mat4_mul(proj, view);
-    return mat4_mul(vp, *model);
+// Rebuilds what the dirty bits say changed; the combined matrices and the
+// frustum depend on both halves so they follow either
+static void camera_refresh(camera* cam) {
+    if(!cam->dirty) return;
+    if(cam->dirty & CAMERA_DIRTY_VIEW) {
+        cam->view = camera_build_view(cam);
+        cam->inverse_view = mat4_inverse_affine(cam->view);
+    }
+    if(cam->dirty & CAMERA_DIRTY_PROJECTION) {
+        cam->projection = mat4_perspective(cam->fov, cam->aspect, cam->near_plane, cam->far_plane);
+        cam->inverse_projection = camera_inverse_perspective(&cam->projection);
+    }
+    cam->view_projection = mat4_mul(cam->projection, cam->view);
+    cam->inverse_view_projection = mat4_mul(cam->inverse_view, cam->inverse_projection);
+    cam->view_frustum = frustum_from_mat4(cam->view_projection);
+    cam->dirty = 0;
+}
+
+void camera_update(camera* cam) {
+    if(cam->pending_x != 0.0f || cam->pending_y != 0.0f) {
+        float xoffset = cam->pending_x * cam->mouse_sensitivity;
+        float yoffset = cam->pending_y * cam->mouse_sensitivity;
+        cam->pending_x = 0.0f;
+        cam->pending_y = 0.0f;
+
+        if(cam->type == CAMERA_TYPE_FPS) {
+            cam->yaw += xoffset;
+            cam->pitch += yoffset;
+
+            // Constrain pitch to prevent screen flipping
+            if(cam->pending_constrain_pitch) {
+                if(cam->pitch > 89.0f) cam->pitch = 89.0f;
+                if(cam->pitch < -89.0f) cam->pitch = -89.0f;
+            }
+
+            camera_update_vectors(cam);
+        } else if(cam->type == CAMERA_TYPE_ORBIT) {
+            camera_orbit(cam, xoffset, yoffset);
+        }
+    }
+    camera_refresh(cam);
+}
+
+mat4 camera_view_matrix(camera* cam) {
+    camera_refresh(cam);
+    return cam->view;
+}
+
+mat4 camera_projection_matrix(camera* cam) {
+    camera_refresh(cam);
+    return cam->projection;
+}
+
+mat4 camera_view_projection_matrix(camera* cam) {
+    camera_refresh(cam);
+    return cam->view_projection;
+}
+
+mat4 camera_inverse_view_matrix(camera* cam) {
+    camera_refresh(cam);
+    return cam->inverse_view;
+}
+
+mat4 camera_inverse_view_projection_matrix(camera* cam) {
+    camera_refresh(cam);
+    return cam->inverse_view_projection;
+}
+
+mat4 camera_mvp_matrix(camera* cam, const mat4* model) {
+    camera_refresh(cam);
+    return mat4_mul(cam->view_projection, *model);
+}
+
+frustum camera_frustum(camera* cam) {
+    camera_refresh(cam);
+    return cam->view_frustum;
 }
 
 void camera_update_vectors(camera* cam) {
@@ -111,6 +193,7 @@ void camera_update_vectors(camera* cam) {
         cam->right = v3_normalize(v3_cross(cam->front, cam->world_up));
         cam->up = v3_normalize(v3_cross(cam->right, cam->front));
     }
+    cam->dirty |= CAMERA_DIRTY_VIEW;
 }
 
 void camera_move_forward(camera* cam, float delta_time) {
@@ -126,6 +209,7 @@ void camera_move_forward(camera* cam, float delta_time) {
     } else {
         cam->position = v3_add(cam->position, v3_scale(cam->front, velocity));
     }
+    cam->dirty |= CAMERA_DIRTY_VIEW;
     if(cam->type != CAMERA_TYPE_FPS) camera_update_vectors(cam);
 }
 
@@ -139,51 +223,43 @@ void camera_move_backward(camera* cam, float delta_time) {
     } else {
         cam->position = v3_sub(cam->position, v3_scale(cam->front, velocity));
     }
+    cam->dirty |= CAMERA_DIRTY_VIEW;
     if(cam->type != CAMERA_TYPE_FPS) camera_update_vectors(cam);
 }
 
 void camera_move_left(camera* cam, float delta_time) {
     float velocity = cam->move_speed * delta_time;
     cam->position = v3_sub(cam->position, v3_scale(cam->right, velocity));
+    cam->dirty |= CAMERA_DIRTY_VIEW;
     if(cam->type != CAMERA_TYPE_FPS) camera_update_vectors(cam);
 }
 
 void camera_move_right(camera* cam, float delta_time) {
     float velocity = cam->move_speed * delta_time;
     cam->position = v3_add(cam->position, v3_scale(cam->right, velocity));
+    cam->dirty |= CAMERA_DIRTY_VIEW;
     if(cam->type != CAMERA_TYPE_FPS) camera_update_vectors(cam);
 }
 
 void camera_move_up(camera* cam, float delta_time) {
     float velocity = cam->move_speed * delta_time;
     cam->position = v3_add(cam->position, v3_scale(cam->up, velocity));
+    cam->dirty |= CAMERA_DIRTY_VIEW;
     if(cam->type != CAMERA_TYPE_FPS) camera_update_vectors(cam);
 }
 
 void camera_move_down(camera* cam, float delta_time) {
     float velocity = cam->move_speed * delta_time;
     cam->position = v3_sub(cam->position, v3_scale(cam->up, velocity));
+    cam->dirty |= CAMERA_DIRTY_VIEW;
     if(cam->type != CAMERA_TYPE_FPS) camera_update_vectors(cam);
 }
 
 void camera_process_mouse(camera* cam, float xoffset, float yoffset, int constrain_pitch) {
-    xoffset *= cam->mouse_sensitivity;
-    yoffset *= cam->mouse_sensitivity;
-
-    if(cam->type == CAMERA_TYPE_FPS) {
-        cam->yaw += xoffset;
-        cam->pitch += yoffset;
-
-        // Constrain pitch to prevent screen flipping
-        if(constrain_pitch) {
-            if(cam->pitch > 89.0f) cam->pitch = 89.0f;
-            if(cam->pitch < -89.0f) cam->pitch = -89.0f;
-        }
-
-        camera_update_vectors(cam);
-    } else if(cam->type == CAMERA_TYPE_ORBIT) {
-        camera_orbit(cam, xoffset, yoffset);
-    }
+    // Summed here and turned once in camera_update, however many events arrive
+    cam->pending_x += xoffset;
+    cam->pending_y += yoffset;
+    cam->pending_constrain_pitch = constrain_pitch;
 }
 
 void camera_orbit(camera* cam, float horizontal, float vertical) {
@@ -229,11 +305,13 @@ void camera_zoom(camera* cam, float zoom_amount) {
         cam->fov -= zoom_amount * 0.1f;
         if(cam->fov < 1.0f) cam->fov = 1.0f;
         if(cam->fov > 120.0f) cam->fov = 120.0f;
+        cam->dirty |= CAMERA_DIRTY_PROJECTION;
     }
 }
 
 void camera_set_aspect_ratio(camera* cam, float aspect) {
     cam->aspect = aspect;
+    cam->dirty |= CAMERA_DIRTY_PROJECTION;
 }
 
 void camera_look_at(camera* cam, vec3 target) {
@@ -247,6 +325,174 @@ void camera_look_at(camera* cam, vec3 target) {
     camera_update_vectors(cam);
 }
 
+camera camera_interpolate(const camera* previous, const camera* current, float alpha) {
+    camera cam = *current;
+    cam.position = v3_lerp(previous->position, current->position, alpha);
+    if(cam.type == CAMERA_TYPE_ORBIT) cam.target = v3_lerp(previous->target, current->target, alpha);
+    cam.dirty |= CAMERA_DIRTY_VIEW;
+    return cam;
+}
+
+void camera_views_reset(camera_views* views) {
+    views->count = 0;
+}
+
+static uint32_t camera_views_reserve(camera_views* views, uint32_t count) {
+    if(views->count + count > CAMERA_MAX_VIEWS) return UINT32_MAX;
+    uint32_t first = views->count;
+    views->count += count;
+    return first;
+}
+
+uint32_t camera_views_add_cascades(camera_views* views, camera* cam, const camera_cascade_desc* desc) {
+    if(desc->count == 0 || desc->count > CAMERA_MAX_CASCADES) return UINT32_MAX;
+    uint32_t first = camera_views_reserve(views, desc->count);
+    if(first == UINT32_MAX) return first;
+
+    float near_z = cam->near_plane;
+    float far_z = cam->far_plane;
+    if(desc->max_distance > 0.0f && desc->max_distance < far_z) far_z = desc->max_distance;
+
+    // The inverse view's columns are the camera's axes and eye in world space
+    camera_refresh(cam);
+    const float* inv = cam->inverse_view.m;
+    vec3 right = {inv[0], inv[1], inv[2]};
+    vec3 up = {inv[4], inv[5], inv[6]};
+    vec3 forward = {inv[8], inv[9], inv[10]};
+    vec3 eye = {inv[12], inv[13], inv[14]};
+    float tan_y = tanf(cam->fov * 0.5f);
+    float tan_x = tan_y * cam->aspect;
+
+    // All cascades share one light rotation; only the fit differs
+    vec3 light_up = fabsf(desc->light_dir.y) > 0.99f ? (vec3){0.0f, 0.0f, 1.0f} : (vec3){0.0f, 1.0f, 0.0f};
+    mat4 light_view = mat4_look_at(v3_zero(), desc->light_dir, light_up);
+    affine to_light = mat4_to_affine(light_view);
+
+    float slice_near = near_z;
+    for(uint32_t c = 0; c < desc->count; c++) {
+        // Practical split scheme: logarithmic splits blended toward uniform
+        float t = (float)(c + 1) / (float)desc->count;
+        float log_split = near_z * powf(far_z / near_z, t);
+        float uniform_split = near_z + (far_z - near_z) * t;
+        float slice_far = desc->split_lambda * log_split + (1.0f - desc->split_lambda) * uniform_split;
+        if(c == desc->count - 1) slice_far = far_z;
+
+        // Light space bounds of the slice's eight corners
+        vec3 lo = {INFINITY, INFINITY, INFINITY};
+        vec3 hi = {-INFINITY, -INFINITY, -INFINITY};
+        for(int k = 0; k < 8; k++) {
+            float z = k & 4 ? slice_far : slice_near;
+            vec3 side = v3_scale(right, (k & 1 ? tan_x : -tan_x) * z);
+            vec3 rise = v3_scale(up, (k & 2 ? tan_y : -tan_y) * z);
+            vec3 corner = v3_add(v3_add(eye, v3_scale(forward, z)), v3_add(side, rise));
+            vec3 p = affine_transform_point(to_light, corner);
+            lo = (vec3){fminf(lo.x, p.x), fminf(lo.y, p.y), fminf(lo.z, p.z)};
+            hi = (vec3){fmaxf(hi.x, p.x), fmaxf(hi.y, p.y), fmaxf(hi.z, p.z)};
+        }
+
+        // Whole texel bounds stop shadow edges crawling as the camera moves. The
+        // texel leaves one texel of slack so the snapped-down minimum still
+        // reaches the maximum
+        if(desc->resolution > 1) {
+            float texel_x = (hi.x - lo.x) / (float)(desc->resolution - 1);
+            float texel_y = (hi.y - lo.y) / (float)(desc->resolution - 1);
+            lo.x = floorf(lo.x / texel_x) * texel_x;
+            lo.y = floorf(lo.y / texel_y) * texel_y;
+            hi.x = lo.x + texel_x * (float)desc->resolution;
+            hi.y = lo.y + texel_y * (float)desc->resolution;
+        }
+
+        uint32_t v = first + c;
+        views->view[v] = light_view;
+        views->projection[v] = mat4_orthographic(lo.x, hi.x, lo.y, hi.y, lo.z - desc->caster_distance, hi.z);
+        views->near_plane[v] = slice_near;
+        views->far_plane[v] = slice_far;
+        slice_near = slice_far;
+    }
+    return first;
+}
+
+uint32_t camera_views_add_cube(camera_views* views, vec3 position, float near_plane, float far_plane) {
+    static const vec3 directions[CAMERA_CUBE_FACES] = {
+        {1.0f, 0.0f, 0.0f}, {-1.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f},
+        {0.0f, -1.0f, 0.0f}, {0.0f, 0.0f, 1.0f}, {0.0f, 0.0f, -1.0f},
+    };
+    static const vec3 ups[CAMERA_CUBE_FACES] = {
+        {0.0f, -1.0f, 0.0f}, {0.0f, -1.0f, 0.0f}, {0.0f, 0.0f, 1.0f},
+        {0.0f, 0.0f, -1.0f}, {0.0f, -1.0f, 0.0f}, {0.0f, -1.0f, 0.0f},
+    };
+    uint32_t first = camera_views_reserve(views, CAMERA_CUBE_FACES);
+    if(first == UINT32_MAX) return first;
+
+    mat4 projection = mat4_perspective((float)(PI / 2.0), 1.0f, near_plane, far_plane);
+    for(uint32_t f = 0; f < CAMERA_CUBE_FACES; f++) {
+        uint32_t v = first + f;
+        views->view[v] = mat4_look_at(position, v3_add(position, directions[f]), ups[f]);
+        views->projection[v] = projection;
+        views->near_plane[v] = near_plane;
+        views->far_plane[v] = far_plane;
+    }
+    return first;
+}
+
+uint32_t camera_views_add_mirror(camera_views* views, camera* cam, vec4 plane) {
+    uint32_t v = camera_views_reserve(views, 1);
+    if(v == UINT32_MAX) return v;
+    camera_refresh(cam);
+
+    // Reflection through the plane: I - 2 n n^T, moved by -2 d n
+    float nx = plane.x, ny = plane.y, nz = plane.z, d = plane.w;
+    mat4 reflect = mat4_identity();
+    reflect.m[0] = 1.0f - 2.0f * nx * nx;
+    reflect.m[1] = -2.0f * nx * ny;
+    reflect.m[2] = -2.0f * nx * nz;
+    reflect.m[4] = -2.0f * ny * nx;
+    reflect.m[5] = 1.0f - 2.0f * ny * ny;
+    reflect.m[6] = -2.0f * ny * nz;
+    reflect.m[8] = -2.0f * nz * nx;
+    reflect.m[9] = -2.0f * nz * ny;
+    reflect.m[10] = 1.0f - 2.0f * nz * nz;
+    reflect.m[12] = -2.0f * d * nx;
+    reflect.m[13] = -2.0f * d * ny;
+    reflect.m[14] = -2.0f * d * nz;
+    mat4 view = mat4_mul_affine(cam->view, reflect);
+
+    // The mirror plane in the reflected view space, plane^T * inverse(view). The
+    // reflected eye lies behind it, so c.w < 0 as oblique clipping needs
+    mat4 inv = mat4_inverse_affine(view);
+    vec4 c;
+    c.x = v4_dot(plane, (vec4){inv.m[0], inv.m[1], inv.m[2], inv.m[3]});
+    c.y = v4_dot(plane, (vec4){inv.m[4], inv.m[5], inv.m[6], inv.m[7]});
+    c.z = v4_dot(plane, (vec4){inv.m[8], inv.m[9], inv.m[10], inv.m[11]});
+    c.w = v4_dot(plane, (vec4){inv.m[12], inv.m[13], inv.m[14], inv.m[15]});
+
+    // Lengyel's oblique near plane for 0..1 depth: q is the view space far
+    // corner opposite the plane, and the z row becomes c scaled so q stays on
+    // the far plane
+    mat4 proj = cam->projection;
+    float sx = (float)((c.x > 0.0f) - (c.x < 0.0f));
+    float sy = (float)((c.y > 0.0f) - (c.y < 0.0f));
+    vec4 q = {sx / proj.m[0], sy / proj.m[5], 1.0f, (1.0f - proj.m[10]) / proj.m[14]};
+    vec4 row = v4_scale(c, 1.0f / v4_dot(c, q));
+    proj.m[2] = row.x;
+    proj.m[6] = row.y;
+    proj.m[10] = row.z;
+    proj.m[14] = row.w;
+
+    views->view[v] = view;
+    views->projection[v] = proj;
+    views->near_plane[v] = cam->near_plane;
+    views->far_plane[v] = cam->far_plane;
+    return v;
+}
+
+void camera_views_update(camera_views* views) {
+    for(uint32_t i = 0; i < views->count; i++) {
+        views->view_projection[i] = mat4_mul(views->projection[i], views->view[i]);
+        views->frusta[i] = frustum_from_mat4(views->view_projection[i]);
+    }
+}
+
 // Example usage:
 /*
 // Create an FPS camera
@@ -258,7 +504,8 @@ camera fps_cam = camera_create_fps(
     100.0f                          // far plane
 );
 
-// In your main loop:
+// In your main loop, after input:
+camera_update(&fps_cam);
 mat4 model = mat4_identity();
 mat4 mvp = camera_mvp_matrix(&fps_cam, &model);
 rcmd_push_constants(cmd, pipeline, RSHADER_STAGE_VERTEX, 0, sizeof(mat4), &mvp);
@@ -1,6 +1,15 @@
 #pragma once
+#include <stdint.h>
+
 #include "math_types.h" // Your math library
 
+// Parts of the matrix cache that need rebuilding
+enum {
+    CAMERA_DIRTY_VIEW = 1 << 0,        // position, orientation or up changed
+    CAMERA_DIRTY_PROJECTION = 1 << 1,  // fov, aspect or clip planes changed
+    CAMERA_DIRTY_ALL = CAMERA_DIRTY_VIEW | CAMERA_DIRTY_PROJECTION,
+};
+
 typedef struct {
     vec3 position;
     vec3 target;
@@ -31,6 +40,23 @@ typedef struct {
         CAMERA_TYPE_FPS,      // First-person shooter style
         CAMERA_TYPE_FREE      // Free-flying camera
     } type;
+
+    // Mouse movement since the last camera_update, applied there in one go
+    float pending_x;
+    float pending_y;
+    int   pending_constrain_pitch;
+
+    // Matrix cache, rebuilt on first use after the parts it depends on change.
+    // The functions below flag it; after writing position, fov, etc. directly
+    // set the matching CAMERA_DIRTY_* bit
+    uint32_t dirty;
+    mat4     view;
+    mat4     projection;
+    mat4     view_projection;
+    mat4     inverse_view;
+    mat4     inverse_projection;
+    mat4     inverse_view_projection;
+    frustum  view_frustum;
 } camera;
 
 // Camera creation
@@ -38,10 +64,21 @@ camera camera_create_fps(vec3 position, float fov, float aspect, float near_plan
 camera camera_create_orbit(vec3 target, float distance, float fov, float aspect, float near_plane, float far_plane);
 camera camera_create_free(vec3 position, vec3 target, float fov, float aspect, float near_plane, float far_plane);
 
-// Matrix generation
-mat4 camera_view_matrix(const camera* cam);
-mat4 camera_projection_matrix(const camera* cam);
-mat4 camera_mvp_matrix(const camera* cam, const mat4* model);
+// Once per frame: applies the accumulated mouse movement and refreshes the
+// matrix cache
+void camera_update(camera* cam);
+
+// Matrix generation, from the cache; only what is flagged dirty is rebuilt, so
+// repeated calls within a frame cost a copy (mvp: one multiply)
+mat4 camera_view_matrix(camera* cam);
+mat4 camera_projection_matrix(camera* cam);
+mat4 camera_view_projection_matrix(camera* cam);
+mat4 camera_inverse_view_matrix(camera* cam);
+mat4 camera_inverse_view_projection_matrix(camera* cam);
+mat4 camera_mvp_matrix(camera* cam, const mat4* model);
+
+// World space frustum of the current view and projection, for culling
+frustum camera_frustum(camera* cam);
 
 // Movement functions
 void camera_move_forward(camera* cam, float delta_time);
@@ -51,7 +88,7 @@ void camera_move_right(camera* cam, float delta_time);
 void camera_move_up(camera* cam, float delta_time);
 void camera_move_down(camera* cam, float delta_time);
 
-// Mouse input
+// Mouse input, accumulated until the next camera_update
 void camera_process_mouse(camera* cam, float xoffset, float yoffset, int constrain_pitch);
 
 // Orbit camera specific
@@ -65,3 +102,58 @@ void camera_update_vectors(camera* cam);
 void camera_set_aspect_ratio(camera* cam, float aspect);
 void camera_look_at(camera* cam, vec3 target);
 
+// Render state between two fixed simulation steps: position (and an orbit
+// target) blended by alpha, orientation and projection taken from current so
+// mouse look isn't held back a step
+camera camera_interpolate(const camera* previous, const camera* current, float alpha);
+
+// Derived views
+//
+// Shadow cascades, cube faces and mirrors rendered on behalf of one camera.
+// Views are appended to a set, then camera_views_update builds every
+// view_projection and frustum in one pass. The frusta sit contiguously so
+// frustum_mask_spheres/aabbs can cull a batch of bounds against all of them
+// at once, bit i of an object's mask standing for view i
+#define CAMERA_MAX_VIEWS 32  // one bit each in a frustum_mask_* mask
+#define CAMERA_MAX_CASCADES 8
+#define CAMERA_CUBE_FACES 6
+
+typedef struct {
+    uint32_t count;
+    mat4     view[CAMERA_MAX_VIEWS];
+    mat4     projection[CAMERA_MAX_VIEWS];
+    mat4     view_projection[CAMERA_MAX_VIEWS];  // from camera_views_update
+    frustum  frusta[CAMERA_MAX_VIEWS];           // from camera_views_update
+    // Depth range each view covers: a cascade's slice of the camera's view
+    // depth (compare against it to pick the cascade), else the clip planes
+    float    near_plane[CAMERA_MAX_VIEWS];
+    float    far_plane[CAMERA_MAX_VIEWS];
+} camera_views;
+
+typedef struct {
+    vec3     light_dir;        // Direction the light travels, unit length
+    uint32_t count;            // 1 .. CAMERA_MAX_CASCADES
+    float    split_lambda;     // 0 uniform splits, 1 logarithmic
+    float    max_distance;     // Shadowed depth; 0 or beyond far_plane uses far_plane
+    float    caster_distance;  // Casters this far toward the light still land in a slice
+    uint32_t resolution;       // Shadow map texels; when set the fit snaps to whole texels
+} camera_cascade_desc;
+
+void camera_views_reset(camera_views* views);
+
+// The add functions return the index of their first view, or UINT32_MAX
+// (adding nothing) when the set has no room.
+//
+// One orthographic view per slice of the camera's frustum, fitted tightly
+// around the slice in light space
+uint32_t camera_views_add_cascades(camera_views* views, camera* cam, const camera_cascade_desc* desc);
+// 90 degree faces in Vulkan cube layer order: +x, -x, +y, -y, +z, -z
+uint32_t camera_views_add_cube(camera_views* views, vec3 position, float near_plane, float far_plane);
+// The camera reflected in plane (n, d): unit n, dot(n, p) + d = 0, with the
+// camera on the positive side. The near plane is replaced by the mirror plane
+// (oblique clipping) so nothing behind the mirror is drawn. Reflection flips
+// triangle winding, so render it with the opposite front face
+uint32_t camera_views_add_mirror(camera_views* views, camera* cam, vec4 plane);
+
+// Builds view_projection and frusta for every view in the set
+void camera_views_update(camera_views* views);
@@ -0,0 +1,351 @@
+#include "ecs.h"
+
+#include <string.h>
+
+#include "../base.h"
+
+#define ECS_CHUNK_ALIGN 64
+#define ECS_NONE UINT32_MAX
+
+#define ecs_align_up(value, align) (((value) + (align) - 1) & ~((align) - 1))
+
+int ecs_init(ecs_world* world, allocator* ator, uint32_t max_entities) {
+    memset(world, 0, sizeof(*world));
+    world->ator = ator;
+    world->records = aalloc_array(ator, ecs_record, max_entities);
+    world->archetypes = aalloc_array(ator, ecs_archetype, ECS_MAX_ARCHETYPES);
+    if (!world->records || !world->archetypes) {
+        debug_log("ecs_init: out of memory for %u entities\n", max_entities);
+        ecs_destroy(world);
+        return -1;
+    }
+    world->max_entities = max_entities;
+    world->free_head = ECS_NONE;
+    return 0;
+}
+
+void ecs_destroy(ecs_world* world) {
+    allocator* ator = world->ator;
+    for (uint32_t i = 0; i < world->archetype_count; i++) {
+        ecs_archetype* a = &world->archetypes[i];
+        for (uint32_t c = 0; c < a->chunk_count; c++) afree(ator, a->chunks[c]);
+        if (a->chunks) afree(ator, a->chunks);
+    }
+    while (world->free_chunks) {
+        void* chunk = world->free_chunks;
+        world->free_chunks = *(void**)chunk;
+        afree(ator, chunk);
+    }
+    if (world->archetypes) afree(ator, world->archetypes);
+    if (world->records) afree(ator, world->records);
+    memset(world, 0, sizeof(*world));
+}
+
+// a row has to fit a chunk a few times over to be worth chunking
+ecs_component ecs_component_register(ecs_world* world, uint32_t size,
+                                     uint32_t align) {
+    if (world->component_count == ECS_MAX_COMPONENTS ||
+        size > ECS_CHUNK_SIZE / 4 || align > ECS_CHUNK_ALIGN) {
+        debug_log("ecs_component_register: no room for a %u byte component\n",
+                  size);
+        return ECS_NONE;
+    }
+    ecs_component id = world->component_count++;
+    world->sizes[id] = size;
+    world->aligns[id] = align < ECS_COLUMN_ALIGN ? ECS_COLUMN_ALIGN : align;
+    return id;
+}
+
+// the most entities whose ids and columns, each column aligned, fit a chunk
+static int archetype_layout(ecs_world* world, ecs_archetype* a) {
+    uint32_t row = sizeof(ecs_entity);
+    for (uint32_t i = 0; i < a->component_count; i++) {
+        row += world->sizes[a->components[i]];
+    }
+    for (uint32_t capacity = ECS_CHUNK_SIZE / row; capacity > 0; capacity--) {
+        uint32_t offset = sizeof(ecs_entity) * capacity;
+        for (uint32_t i = 0; i < a->component_count; i++) {
+            ecs_component c = a->components[i];
+            offset = ecs_align_up(offset, world->aligns[c]);
+            a->offsets[i] = (uint16_t)offset;
+            offset += world->sizes[c] * capacity;
+        }
+        if (offset <= ECS_CHUNK_SIZE) {
+            a->capacity = capacity;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+// archetypes are few and looked up only on structural changes, a scan will do
+static ecs_archetype* archetype_get(ecs_world* world, uint64_t mask) {
+    for (uint32_t i = 0; i < world->archetype_count; i++) {
+        if (world->archetypes[i].mask == mask) return &world->archetypes[i];
+    }
+    if (world->archetype_count == ECS_MAX_ARCHETYPES) {
+        debug_log("ecs: out of archetypes\n");
+        return NULL;
+    }
+    if (world->component_count < 64 && mask >> world->component_count) {
+        debug_log("ecs: mask %llx names unregistered components\n",
+                  (unsigned long long)mask);
+        return NULL;
+    }
+
+    ecs_archetype* a = &world->archetypes[world->archetype_count];
+    memset(a, 0, sizeof(*a));
+    memset(a->slot, -1, sizeof(a->slot));
+    a->mask = mask;
+    for (uint64_t bits = mask; bits; bits &= bits - 1) {
+        uint32_t c = (uint32_t)__builtin_ctzll(bits);
+        a->slot[c] = (int8_t)a->component_count;
+        a->components[a->component_count++] = (uint8_t)c;
+    }
+    if (archetype_layout(world, a) != 0) return NULL;
+    world->archetype_count++;
+    return a;
+}
+
+static uint8_t* chunk_acquire(ecs_world* world) {
+    void* chunk = world->free_chunks;
+    if (chunk) {
+        world->free_chunks = *(void**)chunk;
+        return chunk;
+    }
+    return aalloc_algn(world->ator, ECS_CHUNK_SIZE, ECS_CHUNK_ALIGN);
+}
+
+static void chunk_release(ecs_world* world, uint8_t* chunk) {
+    *(void**)chunk = world->free_chunks;
+    world->free_chunks = chunk;
+}
+
+// a zeroed row at the end of the archetype, ECS_NONE when out of memory
+static uint32_t archetype_push(ecs_world* world, ecs_archetype* a, ecs_entity e) {
+    uint32_t row = a->count;
+    uint32_t chunk = row / a->capacity;
+    if (chunk == a->chunk_count) {
+        if (a->chunk_count == a->chunk_max) {
+            uint32_t  max = a->chunk_max ? a->chunk_max * 2 : 8;
+            uint8_t** chunks = aalloc_array(world->ator, uint8_t*, max);
+            if (!chunks) return ECS_NONE;
+            if (a->chunks) {
+                memcpy(chunks, a->chunks, sizeof(uint8_t*) * a->chunk_count);
+                afree(world->ator, a->chunks);
+            }
+            a->chunks = chunks;
+            a->chunk_max = max;
+        }
+        uint8_t* data = chunk_acquire(world);
+        if (!data) return ECS_NONE;
+        a->chunks[a->chunk_count++] = data;
+    }
+
+    uint8_t* data = a->chunks[chunk];
+    uint32_t local = row - chunk * a->capacity;
+    ((ecs_entity*)data)[local] = e;
+    for (uint32_t i = 0; i < a->component_count; i++) {
+        uint32_t size = world->sizes[a->components[i]];
+        memset(data + a->offsets[i] + local * size, 0, size);
+    }
+    a->count++;
+    return row;
+}
+
+// fills the hole with the archetype's last entity and hands back a chunk
+// once it empties
+static void archetype_remove(ecs_world* world, ecs_archetype* a, uint32_t row) {
+    uint32_t last = a->count - 1;
+    if (row != last) {
+        uint8_t* dst = a->chunks[row / a->capacity];
+        uint8_t* src = a->chunks[last / a->capacity];
+        uint32_t d = row % a->capacity;
+        uint32_t s = last % a->capacity;
+        ecs_entity moved = ((ecs_entity*)src)[s];
+        ((ecs_entity*)dst)[d] = moved;
+        for (uint32_t i = 0; i < a->component_count; i++) {
+            uint32_t size = world->sizes[a->components[i]];
+            memcpy(dst + a->offsets[i] + d * size, src + a->offsets[i] + s * size,
+                   size);
+        }
+        world->records[ecs_entity_index(moved)].row = row;
+    }
+    a->count--;
+    if (a->count == (a->chunk_count - 1) * a->capacity) {
+        chunk_release(world, a->chunks[--a->chunk_count]);
+    }
+}
+
+static ecs_entity entity_alloc(ecs_world* world) {
+    uint32_t index;
+    if (world->free_head != ECS_NONE) {
+        index = world->free_head;
+        world->free_head = world->records[index].row;
+    } else if (world->used < world->max_entities) {
+        index = world->used++;
+        world->records[index].generation = 1;
+    } else {
+        return ECS_NULL;
+    }
+    return (ecs_entity)world->records[index].generation << 32 | index;
+}
+
+static void entity_free(ecs_world* world, uint32_t index) {
+    ecs_record* r = &world->records[index];
+    r->generation = r->generation + 1 ? r->generation + 1 : 1;
+    r->archetype = ECS_NONE;
+    r->row = world->free_head;
+    world->free_head = index;
+}
+
+uint32_t ecs_spawn_n(ecs_world* world, uint64_t mask, uint32_t count,
+                     ecs_entity* ids) {
+    ecs_archetype* a = archetype_get(world, mask);
+    if (!a) return 0;
+    uint32_t archetype = (uint32_t)(a - world->archetypes);
+    for (uint32_t i = 0; i < count; i++) {
+        ecs_entity e = entity_alloc(world);
+        if (e == ECS_NULL) return i;
+        uint32_t row = archetype_push(world, a, e);
+        if (row == ECS_NONE) {
+            entity_free(world, ecs_entity_index(e));
+            return i;
+        }
+        ecs_record* r = &world->records[ecs_entity_index(e)];
+        r->archetype = archetype;
+        r->row = row;
+        world->alive++;
+        if (ids) ids[i] = e;
+    }
+    return count;
+}
+
+ecs_entity ecs_spawn(ecs_world* world, uint64_t mask) {
+    ecs_entity e = ECS_NULL;
+    ecs_spawn_n(world, mask, 1, &e);
+    return e;
+}
+
+int ecs_alive(const ecs_world* world, ecs_entity e) {
+    uint32_t index = ecs_entity_index(e);
+    return index < world->used &&
+           world->records[index].generation == ecs_entity_generation(e) &&
+           world->records[index].archetype != ECS_NONE;
+}
+
+int ecs_despawn(ecs_world* world, ecs_entity e) {
+    if (!ecs_alive(world, e)) return 0;
+    ecs_record* r = &world->records[ecs_entity_index(e)];
+    archetype_remove(world, &world->archetypes[r->archetype], r->row);
+    entity_free(world, ecs_entity_index(e));
+    world->alive--;
+    return 1;
+}
+
+void* ecs_get(ecs_world* world, ecs_entity e, ecs_component component) {
+    if (!ecs_alive(world, e) || component >= ECS_MAX_COMPONENTS) return NULL;
+    ecs_record*    r = &world->records[ecs_entity_index(e)];
+    ecs_archetype* a = &world->archetypes[r->archetype];
+    int            slot = a->slot[component];
+    if (slot < 0) return NULL;
+    uint32_t size = world->sizes[component];
+    return a->chunks[r->row / a->capacity] + a->offsets[slot] +
+           (r->row % a->capacity) * size;
+}
+
+static int entity_move(ecs_world* world, ecs_entity e, uint64_t mask) {
+    ecs_record*    r = &world->records[ecs_entity_index(e)];
+    ecs_archetype* src = &world->archetypes[r->archetype];
+    if (src->mask == mask) return 1;
+    ecs_archetype* dst = archetype_get(world, mask);
+    if (!dst) return 0;
+    uint32_t row = archetype_push(world, dst, e);
+    if (row == ECS_NONE) return 0;
+
+    uint8_t* from = src->chunks[r->row / src->capacity];
+    uint8_t* to = dst->chunks[row / dst->capacity];
+    uint32_t s = r->row % src->capacity;
+    uint32_t d = row % dst->capacity;
+    for (uint32_t i = 0; i < dst->component_count; i++) {
+        ecs_component c = dst->components[i];
+        int           slot = src->slot[c];
+        if (slot < 0) continue;
+        uint32_t size = world->sizes[c];
+        memcpy(to + dst->offsets[i] + d * size,
+               from + src->offsets[slot] + s * size, size);
+    }
+    archetype_remove(world, src, r->row);
+    r->archetype = (uint32_t)(dst - world->archetypes);
+    r->row = row;
+    return 1;
+}
+
+static uint64_t entity_mask(const ecs_world* world, ecs_entity e) {
+    return world->archetypes[world->records[ecs_entity_index(e)].archetype].mask;
+}
+
+int ecs_add(ecs_world* world, ecs_entity e, ecs_component component) {
+    if (!ecs_alive(world, e) || component >= world->component_count) return 0;
+    return entity_move(world, e, entity_mask(world, e) | ecs_mask(component));
+}
+
+int ecs_remove(ecs_world* world, ecs_entity e, ecs_component component) {
+    if (!ecs_alive(world, e) || component >= world->component_count) return 0;
+    return entity_move(world, e, entity_mask(world, e) & ~ecs_mask(component));
+}
+
+static uint64_t query_mask(const ecs_query* query) {
+    uint64_t mask = 0;
+    for (uint32_t i = 0; i < query->count; i++) {
+        mask |= ecs_mask(query->components[i]);
+    }
+    return mask;
+}
+
+static int query_matches(const ecs_archetype* a, uint64_t mask,
+                         uint64_t exclude) {
+    return (a->mask & mask) == mask && !(a->mask & exclude);
+}
+
+ecs_iter ecs_query_iter(ecs_world* world, const ecs_query* query) {
+    ecs_iter it = {0};
+    it.world = world;
+    it.query = query;
+    it.mask = query_mask(query);
+    return it;
+}
+
+int ecs_iter_next(ecs_iter* it) {
+    ecs_world*       world = it->world;
+    const ecs_query* query = it->query;
+    for (; it->archetype < world->archetype_count;
+         it->archetype++, it->chunk = 0) {
+        ecs_archetype* a = &world->archetypes[it->archetype];
+        if (it->chunk >= a->chunk_count ||
+            !query_matches(a, it->mask, query->exclude)) {
+            continue;
+        }
+        uint32_t first = it->chunk * a->capacity;
+        uint8_t* data = a->chunks[it->chunk++];
+        it->count = a->count - first < a->capacity ? a->count - first : a->capacity;
+        it->entities = (const ecs_entity*)data;
+        for (uint32_t i = 0; i < query->count; i++) {
+            it->columns[i] = data + a->offsets[a->slot[query->components[i]]];
+        }
+        return 1;
+    }
+    it->count = 0;
+    return 0;
+}
+
+uint32_t ecs_query_count(ecs_world* world, const ecs_query* query) {
+    uint64_t mask = query_mask(query);
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < world->archetype_count; i++) {
+        if (query_matches(&world->archetypes[i], mask, query->exclude)) {
+            count += world->archetypes[i].count;
+        }
+    }
+    return count;
+}
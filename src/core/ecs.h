@@ -0,0 +1,116 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "mem.h"
+
+// archetype entity component system. every distinct set of components is an
+// archetype, and an archetype's entities live in ECS_CHUNK_SIZE chunks as
+// structure of arrays: one contiguous array per component plus one of entity
+// ids. entities are kept packed, removing one moves the archetype's last
+// entity into the hole, so a query walks dense arrays chunk by chunk and
+// never looks at an entity it doesn't want. chunks come from the world's
+// allocator and are recycled between archetypes
+#define ECS_CHUNK_SIZE mkilo(16)
+#define ECS_MAX_COMPONENTS 64
+#define ECS_MAX_ARCHETYPES 256
+#define ECS_QUERY_MAX 8  // components a query hands out arrays for
+#define ECS_COLUMN_ALIGN 16
+
+// low 32 bits index, high 32 bits generation. generations start at 1, so 0
+// is never a live entity; a stale id stops resolving once its index is reused
+typedef uint64_t ecs_entity;
+#define ECS_NULL ((ecs_entity)0)
+#define ecs_entity_index(e) ((uint32_t)(e))
+#define ecs_entity_generation(e) ((uint32_t)((e) >> 32))
+
+typedef uint32_t ecs_component;
+#define ecs_mask(component) ((uint64_t)1 << (component))
+
+typedef struct {
+    uint64_t  mask;
+    uint32_t  component_count;
+    uint8_t   components[ECS_MAX_COMPONENTS];  // ascending ids
+    int8_t    slot[ECS_MAX_COMPONENTS];        // column of each id, or -1
+    uint16_t  offsets[ECS_MAX_COMPONENTS];     // per column, into a chunk
+    uint32_t  capacity;                        // entities per chunk
+    uint32_t  count;
+    uint32_t  chunk_count;
+    uint32_t  chunk_max;
+    uint8_t** chunks;  // entity ids at offset 0, then the columns
+} ecs_archetype;
+
+typedef struct {
+    uint32_t generation;
+    uint32_t archetype;
+    uint32_t row;  // within the archetype; next free index once despawned
+} ecs_record;
+
+typedef struct {
+    allocator*     ator;
+    ecs_record*    records;
+    uint32_t       max_entities;
+    uint32_t       used;       // records handed out at least once
+    uint32_t       free_head;  // despawned indices, UINT32_MAX when none
+    uint32_t       alive;
+    uint32_t       component_count;
+    uint32_t       sizes[ECS_MAX_COMPONENTS];
+    uint32_t       aligns[ECS_MAX_COMPONENTS];
+    ecs_archetype* archetypes;
+    uint32_t       archetype_count;
+    void*          free_chunks;  // linked through their first bytes
+} ecs_world;
+
+// max_entities is fixed for the world's life. 0 on success
+int  ecs_init(ecs_world* world, allocator* ator, uint32_t max_entities);
+void ecs_destroy(ecs_world* world);
+
+// ECS_MAX_COMPONENTS at most; UINT32_MAX when full
+ecs_component ecs_component_register(ecs_world* world, uint32_t size,
+                                     uint32_t align);
+#define ecs_component_type(world, type) \
+    ecs_component_register((world), sizeof(type), _Alignof(type))
+
+// components start zeroed. ECS_NULL when the world is full
+ecs_entity ecs_spawn(ecs_world* world, uint64_t mask);
+// count entities of one archetype, filling ids when it isn't NULL. returns
+// how many were spawned
+uint32_t   ecs_spawn_n(ecs_world* world, uint64_t mask, uint32_t count,
+                       ecs_entity* ids);
+int        ecs_despawn(ecs_world* world, ecs_entity e);  // 0 when stale
+int        ecs_alive(const ecs_world* world, ecs_entity e);
+
+// NULL when e is stale or lacks the component. the pointer stays valid until
+// the next spawn, despawn, add or remove in the same archetype
+void* ecs_get(ecs_world* world, ecs_entity e, ecs_component component);
+#define ecs_get_type(world, e, type, component) \
+    ((type*)ecs_get((world), (e), (component)))
+// move e to the archetype with the component added or removed; data of the
+// components it keeps goes with it. 0 when e is stale
+int   ecs_add(ecs_world* world, ecs_entity e, ecs_component component);
+int   ecs_remove(ecs_world* world, ecs_entity e, ecs_component component);
+
+// every entity with all of components and none of exclude
+typedef struct {
+    ecs_component components[ECS_QUERY_MAX];
+    uint32_t      count;
+    uint64_t      exclude;
+} ecs_query;
+
+// one chunk per ecs_iter_next: count entities, and for each query component
+// an array of count values in query order
+typedef struct {
+    ecs_world*        world;
+    const ecs_query*  query;
+    uint64_t          mask;
+    uint32_t          archetype;
+    uint32_t          chunk;
+    uint32_t          count;
+    const ecs_entity* entities;
+    void*             columns[ECS_QUERY_MAX];
+} ecs_iter;
+
+// structural changes while iterating move entities under the iterator
+ecs_iter ecs_query_iter(ecs_world* world, const ecs_query* query);
+int      ecs_iter_next(ecs_iter* it);
+uint32_t ecs_query_count(ecs_world* world, const ecs_query* query);
@@ -0,0 +1,151 @@
+#include "fiber.h"
+
+#include <string.h>
+
+#include "../base.h"
+#include "os.h"
+
+#if defined(__SANITIZE_THREAD__)
+#define FIBER_TSAN
+#elif defined(__has_feature)
+#if __has_feature(thread_sanitizer)
+#define FIBER_TSAN
+#endif
+#endif
+
+#ifdef FIBER_TSAN
+#include <sanitizer/tsan_interface.h>
+#endif
+
+#ifndef FIBER_UCONTEXT
+
+// fiber_swap(void** save_sp, void* load_sp), system v abi. the frame it leaves
+// on the old stack, from the top: return address, rbp, rbx, r12 .. r15, then
+// mxcsr and the x87 control word sharing one slot
+void fiber_swap(void** save_sp, void* load_sp);
+void fiber_start(void);
+
+__asm__(
+    ".text\n"
+    ".globl fiber_swap\n"
+    ".hidden fiber_swap\n"
+    ".type fiber_swap, @function\n"
+    "fiber_swap:\n"
+    "    pushq %rbp\n"
+    "    pushq %rbx\n"
+    "    pushq %r12\n"
+    "    pushq %r13\n"
+    "    pushq %r14\n"
+    "    pushq %r15\n"
+    "    subq $8, %rsp\n"
+    "    stmxcsr (%rsp)\n"
+    "    fnstcw 4(%rsp)\n"
+    "    movq %rsp, (%rdi)\n"
+    "    movq %rsi, %rsp\n"
+    "    ldmxcsr (%rsp)\n"
+    "    fldcw 4(%rsp)\n"
+    "    addq $8, %rsp\n"
+    "    popq %r15\n"
+    "    popq %r14\n"
+    "    popq %r13\n"
+    "    popq %r12\n"
+    "    popq %rbx\n"
+    "    popq %rbp\n"
+    "    ret\n"
+    ".size fiber_swap, .-fiber_swap\n"
+    // first switch into a fiber returns here with the stack aligned as before
+    // a call; fn in r13, arg in r12
+    ".globl fiber_start\n"
+    ".hidden fiber_start\n"
+    ".type fiber_start, @function\n"
+    "fiber_start:\n"
+    "    movq %r12, %rdi\n"
+    "    callq *%r13\n"
+    "    ud2\n"
+    ".size fiber_start, .-fiber_start\n");
+
+static void context_init(fiber* f, void* top, fiber_fn fn, void* arg) {
+    uint64_t* sp = (uint64_t*)((uintptr_t)top & ~(uintptr_t)15);
+    *--sp = (uint64_t)(uintptr_t)fiber_start;
+    *--sp = 0;  // rbp, ends backtraces
+    *--sp = 0;  // rbx
+    *--sp = (uint64_t)(uintptr_t)arg;  // r12
+    *--sp = (uint64_t)(uintptr_t)fn;   // r13
+    *--sp = 0;  // r14
+    *--sp = 0;  // r15
+    *--sp = 0x037full << 32 | 0x1f80;  // default x87 control word and mxcsr
+    f->context.sp = sp;
+}
+
+#else
+
+// makecontext only passes ints
+static void fiber_start(uint32_t fn_hi, uint32_t fn_lo, uint32_t arg_hi,
+                        uint32_t arg_lo) {
+    fiber_fn fn = (fiber_fn)(uintptr_t)((uint64_t)fn_hi << 32 | fn_lo);
+    fn((void*)(uintptr_t)((uint64_t)arg_hi << 32 | arg_lo));
+    debug_abort();
+}
+
+static void context_init(fiber* f, void* top, fiber_fn fn, void* arg) {
+    getcontext(&f->context.uc);
+    f->context.uc.uc_stack.ss_sp = (char*)f->base + os_page_size();
+    f->context.uc.uc_stack.ss_size = (size_t)((char*)top - (char*)f->base) -
+                                     os_page_size();
+    f->context.uc.uc_link = NULL;
+    uint64_t fn_bits = (uint64_t)(uintptr_t)fn;
+    uint64_t arg_bits = (uint64_t)(uintptr_t)arg;
+    makecontext(&f->context.uc, (void (*)(void))fiber_start, 4,
+                (uint32_t)(fn_bits >> 32), (uint32_t)fn_bits,
+                (uint32_t)(arg_bits >> 32), (uint32_t)arg_bits);
+}
+
+#endif
+
+int fiber_create(fiber* f, size_t stack_size, fiber_fn fn, void* arg) {
+    memset(f, 0, sizeof(*f));
+    size_t page = os_page_size();
+    if (stack_size == 0) stack_size = FIBER_STACK_SIZE;
+    stack_size = (stack_size + page - 1) & ~(page - 1);
+
+    // the lowest page stays reserved but never committed
+    void* base = os_mem_reserve(stack_size + page);
+    if (!base) return -1;
+    if (!os_mem_commit((char*)base + page, stack_size)) {
+        os_mem_release(base, stack_size + page);
+        return -1;
+    }
+    f->base = base;
+    f->size = stack_size + page;
+    context_init(f, (char*)base + f->size, fn, arg);
+#ifdef FIBER_TSAN
+    f->tsan = __tsan_create_fiber(0);
+#endif
+    return 0;
+}
+
+void fiber_destroy(fiber* f) {
+#ifdef FIBER_TSAN
+    if (f->tsan) __tsan_destroy_fiber(f->tsan);
+#endif
+    if (f->base) os_mem_release(f->base, f->size);
+    memset(f, 0, sizeof(*f));
+}
+
+void fiber_from_thread(fiber* f) {
+    memset(f, 0, sizeof(*f));
+#ifdef FIBER_TSAN
+    f->tsan = __tsan_get_current_fiber();
+#endif
+}
+
+void fiber_switch(fiber* from, fiber* to) {
+#ifdef FIBER_TSAN
+    __tsan_switch_to_fiber(to->tsan, 0);
+#endif
+#ifndef FIBER_UCONTEXT
+    fiber_swap(&from->context.sp, to->context.sp);
+#else
+    swapcontext(&from->context.uc, &to->context.uc);
+#endif
+}
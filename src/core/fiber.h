@@ -0,0 +1,52 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mem.h"
+
+// user space context switching. on x86-64 a switch saves the callee-saved
+// registers and the sse/x87 control words on the old stack and swaps stack
+// pointers, a handful of instructions. elsewhere, or with FIBER_UCONTEXT
+// defined, it falls back to swapcontext, which also saves the signal mask and
+// costs a system call per switch
+#if defined(__x86_64__) && !defined(FIBER_UCONTEXT)
+#define FIBER_BACKEND "x86-64 asm"
+typedef struct {
+    void* sp;
+} fiber_context;
+#else
+#ifndef FIBER_UCONTEXT
+#define FIBER_UCONTEXT
+#endif
+#include <ucontext.h>
+#define FIBER_BACKEND "ucontext"
+typedef struct {
+    ucontext_t uc;
+} fiber_context;
+#endif
+
+#define FIBER_STACK_SIZE mkilo(64)
+
+// fn must never return: a fiber ends by switching away for good
+typedef void (*fiber_fn)(void* arg);
+
+// a stack of its own, with an inaccessible guard page below it so an overflow
+// faults instead of running into the next fiber's stack
+typedef struct {
+    fiber_context context;
+    void*         base;  // the reserved range, guard page included
+    size_t        size;
+    void*         tsan;  // thread sanitizer's fiber, when built with it
+} fiber;
+
+// stack_size is rounded up to whole pages; 0 means FIBER_STACK_SIZE. 0 on
+// success
+int  fiber_create(fiber* f, size_t stack_size, fiber_fn fn, void* arg);
+void fiber_destroy(fiber* f);
+// wraps the calling thread's own stack so it can be switched away from and
+// back to. nothing to destroy
+void fiber_from_thread(fiber* f);
+
+// saves the running context into from and resumes to
+void fiber_switch(fiber* from, fiber* to);
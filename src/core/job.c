@@ -0,0 +1,591 @@
+#include "job.h"
+
+#include <stdalign.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../base.h"
+#include "fiber.h"
+#include "os_thread.h"
+
+#define JOB_LINE 64
+#define JOB_SPIN 64           // empty scans before an idle worker sleeps
+#define JOB_WAIT_YIELD 1024   // empty scans before a waiter starts yielding
+
+// a deque entry holds the job by value: a thief copies it out before its cas on
+// top, and a copy torn by the owner reusing the slot is thrown away with the
+// failed cas. the fields are atomics so that race is defined; relaxed is enough
+// since the release store and acquire load of bottom order them
+typedef struct {
+    _Atomic(job_fn)       fn;
+    _Atomic(void*)        data;
+    _Atomic(job_counter*) counter;
+    _Atomic uint32_t      index;
+} job_slot;
+
+typedef struct {
+    job_fn       fn;
+    void*        data;
+    job_counter* counter;
+    uint32_t     index;
+} job_entry;
+
+// fixed size chase-lev deque, after le, pop, cohen and zappa nardelli,
+// "correct and efficient work-stealing for weak memory models"
+typedef struct {
+    alignas(JOB_LINE) _Atomic int64_t top;  // thieves
+    alignas(JOB_LINE) _Atomic int64_t bottom;  // owner
+    alignas(JOB_LINE) job_slot slots[JOB_DEQUE_SIZE];
+} job_deque;
+
+// a pooled fiber loops forever: run job, switch back to the thread that ran
+// it, wait to be handed the next one
+typedef struct job_fiber {
+    fiber             fiber;
+    job_entry         job;
+    struct job_fiber* next;  // free, ready or counter wait list
+} job_fiber;
+
+typedef enum {
+    JOB_FIBER_DONE = 0,  // finished its job, back to the pool
+    JOB_FIBER_WAIT,      // park on the thread's wait counter
+} job_fiber_exit;
+
+typedef struct {
+    job_deque deque;
+    os_thread handle;
+    uint32_t  index;
+    uint32_t  rng;
+
+    // fibers only: the thread's own stack, which hands fibers their work and
+    // files them away when they switch back
+    fiber          hub;
+    job_fiber*     current;
+    job_fiber*     spare;  // last finished fiber, reused without the pool lock
+    job_fiber_exit exit;
+    job_counter*   wait;
+} job_thread;
+
+typedef struct {
+    allocator*  ator;
+    job_thread* threads;
+    uint32_t    thread_count;
+    atom_u32    quit;
+
+    // idle workers sleep on the epoch futex; it moves on every push so a
+    // worker that scanned before a push can't sleep through it
+    alignas(JOB_LINE) atom_u32 epoch;
+    atom_u32 sleepers;
+
+    job_fiber* fibers;
+    uint32_t   fiber_count;
+    alignas(JOB_LINE) atom_u32 free_lock;
+    job_fiber* free;
+    alignas(JOB_LINE) atom_u32 ready_lock;
+    atom_u32   ready_count;
+    job_fiber* ready_head;  // resumed fibers, fifo
+    job_fiber* ready_tail;
+} job_system;
+
+static job_system             g_jobs;
+static _Thread_local uint32_t t_job_index;
+
+// fibers move between threads, and the compiler may keep a thread local's
+// address in a register across the call that switches them. every lookup
+// after a possible switch goes through here
+static __attribute__((noinline)) job_thread* job_self(void) {
+    return &g_jobs.threads[t_job_index];
+}
+
+static void spin_lock(atom_u32* lock) {
+    while (atom_swap_acquire(lock, 1)) {
+        while (atom_load_relaxed(lock)) os_cpu_pause();
+    }
+}
+
+static void spin_unlock(atom_u32* lock) { atom_store_release(lock, 0); }
+
+static int deque_push(job_deque* q, const job_entry* job) {
+    int64_t b = atom_load_relaxed(&q->bottom);
+    int64_t t = atom_load_acquire(&q->top);
+    if (b - t >= JOB_DEQUE_SIZE) return 0;
+    job_slot* s = &q->slots[b & (JOB_DEQUE_SIZE - 1)];
+    atom_store_relaxed(&s->fn, job->fn);
+    atom_store_relaxed(&s->data, job->data);
+    atom_store_relaxed(&s->counter, job->counter);
+    atom_store_relaxed(&s->index, job->index);
+    atom_store_release(&q->bottom, b + 1);
+    return 1;
+}
+
+static void slot_load(job_slot* s, job_entry* job) {
+    job->fn = atom_load_relaxed(&s->fn);
+    job->data = atom_load_relaxed(&s->data);
+    job->counter = atom_load_relaxed(&s->counter);
+    job->index = atom_load_relaxed(&s->index);
+}
+
+// owner only, newest first
+static int deque_pop(job_deque* q, job_entry* job) {
+    int64_t b = atom_load_relaxed(&q->bottom) - 1;
+    atom_store_relaxed(&q->bottom, b);
+    atomic_thread_fence(memory_order_seq_cst);
+    int64_t t = atom_load_relaxed(&q->top);
+    if (t > b) {
+        atom_store_relaxed(&q->bottom, b + 1);
+        return 0;
+    }
+    slot_load(&q->slots[b & (JOB_DEQUE_SIZE - 1)], job);
+    if (t == b) {
+        // last entry: race the thieves for it
+        int won = atomic_compare_exchange_strong_explicit(
+            &q->top, &t, t + 1, memory_order_seq_cst, memory_order_relaxed);
+        atom_store_relaxed(&q->bottom, b + 1);
+        return won;
+    }
+    return 1;
+}
+
+// any thread, oldest first. 0 when empty or another thief got there first
+static int deque_steal(job_deque* q, job_entry* job) {
+    int64_t t = atom_load_acquire(&q->top);
+    atomic_thread_fence(memory_order_seq_cst);
+    int64_t b = atom_load_acquire(&q->bottom);
+    if (t >= b) return 0;
+    slot_load(&q->slots[t & (JOB_DEQUE_SIZE - 1)], job);
+    return atomic_compare_exchange_strong_explicit(
+        &q->top, &t, t + 1, memory_order_seq_cst, memory_order_relaxed);
+}
+
+static void counter_add(job_counter* counter, int32_t count) {
+    for (; counter; counter = counter->parent, count = 1) {
+        if (atomic_fetch_add_explicit(&counter->pending, count,
+                                      memory_order_relaxed) != 0) {
+            return;
+        }
+    }
+}
+
+static void job_notify(uint32_t count);
+
+static void ready_push(job_fiber* first, job_fiber* last, uint32_t count) {
+    last->next = NULL;
+    spin_lock(&g_jobs.ready_lock);
+    if (g_jobs.ready_tail) {
+        g_jobs.ready_tail->next = first;
+    } else {
+        g_jobs.ready_head = first;
+    }
+    g_jobs.ready_tail = last;
+    atom_add_relaxed(&g_jobs.ready_count, count);
+    spin_unlock(&g_jobs.ready_lock);
+    job_notify(count);
+}
+
+static job_fiber* ready_pop(void) {
+    if (atom_load_relaxed(&g_jobs.ready_count) == 0) {
+        return NULL;
+    }
+    spin_lock(&g_jobs.ready_lock);
+    job_fiber* jf = g_jobs.ready_head;
+    if (jf) {
+        g_jobs.ready_head = jf->next;
+        if (!g_jobs.ready_head) g_jobs.ready_tail = NULL;
+        atom_sub_relaxed(&g_jobs.ready_count, 1);
+    }
+    spin_unlock(&g_jobs.ready_lock);
+    return jf;
+}
+
+// the last one out drains the counter under its lock, so a fiber parking on
+// it either sees pending > 0 and gets taken off the wait list here, or sees
+// zero and doesn't park. parent is read first and the unlock is the last
+// touch: once it is done the waiter may return and the counter go away
+static void counter_finish(job_counter* counter) {
+    while (counter) {
+        job_counter* parent = counter->parent;
+        int32_t pending = atom_load_relaxed(&counter->pending);
+        while (pending > 1 && !atomic_compare_exchange_weak_explicit(
+                                  &counter->pending, &pending, pending - 1,
+                                  memory_order_acq_rel, memory_order_relaxed)) {
+        }
+        if (pending > 1) return;
+
+        spin_lock(&counter->lock);
+        if (atomic_fetch_sub_explicit(&counter->pending, 1,
+                                      memory_order_acq_rel) != 1) {
+            spin_unlock(&counter->lock);
+            return;
+        }
+        job_fiber* waiters = counter->waiters;
+        counter->waiters = NULL;
+        spin_unlock(&counter->lock);
+
+        if (waiters) {
+            job_fiber* last = waiters;
+            uint32_t   count = 1;
+            for (; last->next; last = last->next) count++;
+            ready_push(waiters, last, count);
+        }
+        counter = parent;
+    }
+}
+
+static void job_execute(const job_entry* job) {
+    job->fn(job->data, job->index);
+    counter_finish(job->counter);
+}
+
+static uint32_t rng_next(uint32_t* state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+// own deque first, then one pass over the others from a random start
+static int job_find(job_thread* self, job_entry* job) {
+    if (deque_pop(&self->deque, job)) return 1;
+    uint32_t n = g_jobs.thread_count;
+    uint32_t start = rng_next(&self->rng) % n;
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t victim = start + i < n ? start + i : start + i - n;
+        if (victim == self->index) continue;
+        if (deque_steal(&g_jobs.threads[victim].deque, job)) return 1;
+    }
+    return 0;
+}
+
+// seq_cst against the sleeper count: either a sleeper registered in time to
+// be woken, or its futex sees the new epoch and doesn't sleep
+static void job_notify(uint32_t count) {
+    atomic_fetch_add(&g_jobs.epoch, 1);
+    if (atomic_load(&g_jobs.sleepers) == 0) return;
+    if (count > 1) {
+        os_futex_wake_all(&g_jobs.epoch);
+    } else {
+        os_futex_wake(&g_jobs.epoch, 1);
+    }
+}
+
+static job_fiber* fiber_pool_pop(void) {
+    spin_lock(&g_jobs.free_lock);
+    job_fiber* jf = g_jobs.free;
+    if (jf) g_jobs.free = jf->next;
+    spin_unlock(&g_jobs.free_lock);
+    return jf;
+}
+
+static void fiber_pool_push(job_fiber* jf) {
+    spin_lock(&g_jobs.free_lock);
+    jf->next = g_jobs.free;
+    g_jobs.free = jf;
+    spin_unlock(&g_jobs.free_lock);
+}
+
+static void job_fiber_main(void* arg) {
+    job_fiber* jf = arg;
+    for (;;) {
+        job_execute(&jf->job);
+        job_thread* self = job_self();
+        self->exit = JOB_FIBER_DONE;
+        fiber_switch(&jf->fiber, &self->hub);
+    }
+}
+
+// runs on the hub once the fiber is off its stack, so a wake can't resume it
+// on another thread while it is still running here
+static void job_fiber_park(job_fiber* jf, job_counter* counter) {
+    spin_lock(&counter->lock);
+    if (atom_load_acquire(&counter->pending) == 0) {
+        spin_unlock(&counter->lock);
+        ready_push(jf, jf, 1);
+        return;
+    }
+    jf->next = counter->waiters;
+    counter->waiters = jf;
+    spin_unlock(&counter->lock);
+}
+
+// resumed fibers first: they hold a pool slot and are further along. a new
+// job needs a free fiber to run on, otherwise it stays queued
+static int job_fiber_step(job_thread* self) {
+    job_fiber* jf = ready_pop();
+    if (!jf) {
+        if (!self->spare && !(self->spare = fiber_pool_pop())) return 0;
+        if (!job_find(self, &self->spare->job)) return 0;
+        jf = self->spare;
+        self->spare = NULL;
+    }
+    self->current = jf;
+    fiber_switch(&self->hub, &jf->fiber);
+    self->current = NULL;
+    if (self->exit == JOB_FIBER_WAIT) {
+        job_fiber_park(jf, self->wait);
+    } else if (!self->spare) {
+        self->spare = jf;
+    } else {
+        fiber_pool_push(jf);
+    }
+    return 1;
+}
+
+// one job or resumed fiber, 0 when there was nothing to do
+static int job_step(job_thread* self) {
+    if (g_jobs.fiber_count) return job_fiber_step(self);
+    job_entry job;
+    if (!job_find(self, &job)) return 0;
+    job_execute(&job);
+    return 1;
+}
+
+static void* job_worker(void* arg) {
+    job_thread* self = arg;
+    t_job_index = self->index;
+    fiber_from_thread(&self->hub);
+
+    uint32_t idle = 0;
+    while (!atom_load_acquire(&g_jobs.quit)) {
+        uint32_t epoch = atomic_load(&g_jobs.epoch);
+        if (job_step(self)) {
+            idle = 0;
+            continue;
+        }
+        if (++idle < JOB_SPIN) {
+            os_cpu_pause();
+            continue;
+        }
+
+        // sleeps only if nothing was pushed since the scan began
+        atomic_fetch_add(&g_jobs.sleepers, 1);
+        if (!atom_load_acquire(&g_jobs.quit)) {
+            os_futex_wait(&g_jobs.epoch, epoch, OS_WAIT_FOREVER);
+        }
+        atom_sub_relaxed(&g_jobs.sleepers, 1);
+        idle = 0;
+    }
+    return NULL;
+}
+
+int job_init(allocator* ator, uint32_t thread_count) {
+    return job_init_ex(ator, thread_count, 0, 0);
+}
+
+static void job_fibers_destroy(void) {
+    for (uint32_t i = 0; i < g_jobs.fiber_count; i++) {
+        fiber_destroy(&g_jobs.fibers[i].fiber);
+    }
+    afree(g_jobs.ator, g_jobs.fibers);
+    g_jobs.fibers = NULL;
+    g_jobs.fiber_count = 0;
+    g_jobs.free = NULL;
+    g_jobs.ready_head = g_jobs.ready_tail = NULL;
+    atomic_store(&g_jobs.ready_count, 0);
+}
+
+static int job_fibers_create(uint32_t fiber_count, size_t fiber_stack) {
+    job_fiber* fibers = aalloc_array(g_jobs.ator, job_fiber, fiber_count);
+    if (!fibers) {
+        debug_log("job_init: out of memory for %u fibers\n", fiber_count);
+        return -1;
+    }
+    memset(fibers, 0, sizeof(job_fiber) * fiber_count);
+    g_jobs.fibers = fibers;
+    for (uint32_t i = 0; i < fiber_count; i++) {
+        if (fiber_create(&fibers[i].fiber, fiber_stack, job_fiber_main,
+                         &fibers[i]) != 0) {
+            debug_log("job_init: could not map the stack of fiber %u\n", i);
+            g_jobs.fiber_count = i;
+            job_fibers_destroy();
+            return -1;
+        }
+        fibers[i].next = i + 1 < fiber_count ? &fibers[i + 1] : NULL;
+    }
+    g_jobs.fiber_count = fiber_count;
+    g_jobs.free = fibers;
+    return 0;
+}
+
+int job_init_ex(allocator* ator, uint32_t thread_count, uint32_t fiber_count,
+                size_t fiber_stack) {
+    if (thread_count == 0) {
+        os_cpu_info cpus;
+        os_cpu_topology(&cpus);
+        thread_count = cpus.logical_count;
+    }
+    if (thread_count > JOB_MAX_THREADS) thread_count = JOB_MAX_THREADS;
+
+    job_thread* threads =
+        aalloc_algn(ator, sizeof(job_thread) * thread_count, alignof(job_thread));
+    if (!threads) {
+        debug_log("job_init: out of memory for %u threads\n", thread_count);
+        return -1;
+    }
+    memset(threads, 0, sizeof(job_thread) * thread_count);
+
+    g_jobs.ator = ator;
+    g_jobs.threads = threads;
+    g_jobs.thread_count = thread_count;
+    atomic_store(&g_jobs.quit, 0);
+    atomic_store(&g_jobs.epoch, 0);
+    atomic_store(&g_jobs.sleepers, 0);
+
+    t_job_index = 0;
+    fiber_from_thread(&threads[0].hub);
+    if (fiber_count && job_fibers_create(fiber_count, fiber_stack) != 0) {
+        afree(ator, threads);
+        g_jobs.threads = NULL;
+        g_jobs.thread_count = 0;
+        return -1;
+    }
+    for (uint32_t i = 0; i < thread_count; i++) {
+        threads[i].index = i;
+        threads[i].rng = 0x9e3779b9u * (i + 1);
+    }
+    for (uint32_t i = 1; i < thread_count; i++) {
+        char name[OS_THREAD_NAME_MAX];
+        snprintf(name, sizeof(name), "job %u", i);
+        if (os_thread_create(&threads[i].handle, job_worker, &threads[i], name) != 0) {
+            debug_log("job_init: could not start worker %u\n", i);
+            g_jobs.thread_count = i;
+            job_shutdown();
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// queued jobs that were never run and parked fibers are dropped; wait on them
+// first
+void job_shutdown(void) {
+    if (!g_jobs.threads) return;
+    atom_store_release(&g_jobs.quit, 1);
+    job_notify(g_jobs.thread_count);
+    for (uint32_t i = 1; i < g_jobs.thread_count; i++) {
+        os_thread_join(&g_jobs.threads[i].handle);
+    }
+    if (g_jobs.fiber_count) job_fibers_destroy();
+    afree(g_jobs.ator, g_jobs.threads);
+    g_jobs.threads = NULL;
+    g_jobs.thread_count = 0;
+}
+
+uint32_t job_thread_count(void) { return g_jobs.thread_count; }
+
+uint32_t job_thread_index(void) { return job_self()->index; }
+
+void job_counter_init(job_counter* counter, job_counter* parent) {
+    atom_store_relaxed(&counter->pending, 0);
+    atom_store_relaxed(&counter->lock, 0);
+    counter->waiters = NULL;
+    counter->parent = parent;
+}
+
+// the lock too: whoever drained the counter may still be handing its waiters
+// over
+int job_counter_done(const job_counter* counter) {
+    return atom_load_acquire(&counter->pending) == 0 &&
+           atom_load_acquire(&counter->lock) == 0;
+}
+
+void job_run(const job_desc* jobs, uint32_t count, job_counter* counter) {
+    if (count == 0) return;
+    // counted up front, so the counter can't drain while the batch is queued
+    counter_add(counter, (int32_t)count);
+    job_deque* q = &job_self()->deque;
+    for (uint32_t i = 0; i < count; i++) {
+        job_entry job = {jobs[i].fn, jobs[i].data, counter, jobs[i].index};
+        if (!deque_push(q, &job)) job_execute(&job);
+    }
+    job_notify(count);
+}
+
+void job_run_n(job_fn fn, void* data, uint32_t count, job_counter* counter) {
+    if (count == 0) return;
+    counter_add(counter, (int32_t)count);
+    job_deque* q = &job_self()->deque;
+    for (uint32_t i = 0; i < count; i++) {
+        job_entry job = {fn, data, counter, i};
+        if (!deque_push(q, &job)) job_execute(&job);
+    }
+    job_notify(count);
+}
+
+void job_wait(job_counter* counter) {
+    if (job_counter_done(counter)) return;
+    job_thread* self = job_self();
+    if (self->current) {
+        // on a fiber: the hub parks it, and whoever drains the counter puts it
+        // back on the ready list
+        job_fiber* jf = self->current;
+        self->exit = JOB_FIBER_WAIT;
+        self->wait = counter;
+        fiber_switch(&jf->fiber, &self->hub);
+        return;
+    }
+
+    uint32_t idle = 0;
+    while (!job_counter_done(counter)) {
+        if (job_step(self)) {
+            idle = 0;
+        } else if (++idle < JOB_WAIT_YIELD) {
+            os_cpu_pause();
+        } else {
+            // the last jobs are running elsewhere; let their threads have the core
+            os_thread_yield();
+        }
+    }
+}
+
+// parallel_for splits the chunks as an implicit binary tree: node 1 covers all
+// of them, node n's children are 2n and 2n + 1. a job keeps its left half and
+// queues the right, so thieves take the oldest and largest halves and a range
+// crosses threads in log2(chunks) steals instead of one steal per chunk
+typedef struct {
+    job_range_fn fn;
+    void*        data;
+    uint32_t     count;
+    uint32_t     grain;
+    uint32_t     chunks;
+    uint32_t     leaves;  // chunks rounded up to a power of two
+    job_counter* counter;
+} job_range;
+
+static void job_range_run(void* data, uint32_t node) {
+    job_range* range = data;
+    uint32_t   depth = 31 - (uint32_t)__builtin_clz(node);
+    uint32_t   span = range->leaves >> depth;
+    uint32_t   first = (node - (1u << depth)) * span;
+    while (span > 1) {
+        span >>= 1;
+        node <<= 1;
+        if (first + span < range->chunks) {
+            job_desc right = {job_range_run, range, node + 1};
+            job_run(&right, 1, range->counter);
+        }
+    }
+    uint32_t begin = first * range->grain;
+    uint32_t end = range->count - begin < range->grain ? range->count
+                                                       : begin + range->grain;
+    range->fn(range->data, begin, end);
+}
+
+void job_parallel_for(uint32_t count, uint32_t grain, job_range_fn fn, void* data) {
+    if (count == 0) return;
+    if (grain == 0) grain = 1;
+    uint32_t chunks = count / grain + (count % grain != 0);
+    if (chunks == 1 || g_jobs.thread_count < 2) {
+        fn(data, 0, count);
+        return;
+    }
+    uint32_t leaves = 1;
+    while (leaves < chunks) leaves <<= 1;
+
+    job_counter counter;
+    job_counter_init(&counter, NULL);
+    job_range range = {fn, data, count, grain, chunks, leaves, &counter};
+    job_range_run(&range, 1);
+    job_wait(&counter);
+}
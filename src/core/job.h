@@ -0,0 +1,71 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "mem.h"
+#include "os_thread.h"
+
+// work-stealing job system: one thread per core, the thread that calls job_init
+// being thread 0. each thread owns a chase-lev deque; it pushes and pops its
+// own jobs at the bottom, lifo, so a job's children run hot in cache, and idle
+// threads steal the oldest jobs from the top of a random victim's deque.
+// job_run and job_wait may only be called from thread 0 or inside a job.
+//
+// with fibers, every job runs on a fiber from a fixed pool and job_wait inside
+// a job parks the fiber on the counter's wait list and frees the thread for
+// other work; the fiber resumes on whichever thread picks it up once the
+// counter drains. without them, a waiting job runs other jobs on top of its
+// own stack, so it can't wait on anything queued beneath it. a job may move
+// to another thread across job_wait, so thread locals read before a wait
+// must not be trusted after it
+#define JOB_MAX_THREADS 64
+#define JOB_DEQUE_SIZE 4096  // jobs queued per thread; power of two
+
+typedef void (*job_fn)(void* data, uint32_t index);
+
+typedef struct {
+    job_fn   fn;
+    void*    data;
+    uint32_t index;
+} job_desc;
+
+// jobs in flight under this counter. a counter with a parent holds one of the
+// parent's pending slots from the moment it goes non-zero until it drains, so
+// waiting on a parent waits for every child counter under it too. counters
+// live in the caller's memory and must outlive their jobs and every job_wait
+// on them
+typedef struct job_counter {
+    atom_i32            pending;
+    atom_u32            lock;     // guards waiters and the drain to zero
+    struct job_fiber*   waiters;  // fibers parked until pending drains
+    struct job_counter* parent;
+} job_counter;
+
+// thread_count 0 means one per online core. state comes from ator, sized by
+// the thread count (about JOB_DEQUE_SIZE * 32 bytes a thread). 0 on success
+int      job_init(allocator* ator, uint32_t thread_count);
+// fiber_count 0 is job_init. every wait in flight holds a fiber, so the pool
+// must cover the deepest chain of waiting jobs plus one per thread; a job that
+// finds none free stays queued. stacks are reserved from the os, fiber_stack
+// bytes each (0: FIBER_STACK_SIZE) plus a guard page
+int      job_init_ex(allocator* ator, uint32_t thread_count, uint32_t fiber_count,
+                     size_t fiber_stack);
+void     job_shutdown(void);
+uint32_t job_thread_count(void);
+uint32_t job_thread_index(void);  // 0 .. job_thread_count() - 1
+
+void job_counter_init(job_counter* counter, job_counter* parent);
+int  job_counter_done(const job_counter* counter);
+
+// counter may be NULL for jobs nobody waits on. a full deque runs the job
+// in place instead of queuing it
+void job_run(const job_desc* jobs, uint32_t count, job_counter* counter);
+// count jobs of fn over the same data, index 0 .. count - 1
+void job_run_n(job_fn fn, void* data, uint32_t count, job_counter* counter);
+// runs queued and stolen jobs until counter drains, so waiting inside a job
+// keeps its thread busy rather than blocking it
+void job_wait(job_counter* counter);
+
+// fn over [0, count) in ranges of at most grain, returning when all are done
+typedef void (*job_range_fn)(void* data, uint32_t begin, uint32_t end);
+void job_parallel_for(uint32_t count, uint32_t grain, job_range_fn fn, void* data);
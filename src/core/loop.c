@@ -0,0 +1,37 @@
+#include "loop.h"
+
+static int64_t loop_ns(time_p t) { return t.sec * 1000000000ll + t.nsec; }
+
+void loop_init(frame_loop* loop, double step_seconds, uint32_t max_steps) {
+    *loop = (frame_loop){0};
+    loop->step_ns = (int64_t)(step_seconds * 1e9);
+    if (loop->step_ns < 1) loop->step_ns = 1;
+    loop->max_steps = max_steps ? max_steps : 1;
+    loop->step = (float)(loop->step_ns / 1e9);
+}
+
+// the accumulator counts whole nanoseconds, so the step count over a long
+// session doesn't drift the way summing float frame times would
+uint32_t loop_advance(frame_loop* loop, time_p now) {
+    int64_t elapsed = loop->started ? loop_ns(now) - loop_ns(loop->last) : 0;
+    if (elapsed < 0) elapsed = 0;
+    loop->last = now;
+    loop->started = 1;
+    loop->frame_time = elapsed / 1e9;
+    loop->accumulator_ns += elapsed;
+
+    int64_t steps = loop->accumulator_ns / loop->step_ns;
+    if (steps > loop->max_steps) {
+        // keep the partial step so alpha stays continuous across the clamp
+        int64_t excess = (steps - loop->max_steps) * loop->step_ns;
+        loop->accumulator_ns -= excess;
+        loop->dropped += excess / 1e9;
+        steps = loop->max_steps;
+    }
+    loop->accumulator_ns -= steps * loop->step_ns;
+
+    loop->steps = (uint32_t)steps;
+    loop->total_steps += (uint64_t)steps;
+    loop->alpha = (float)((double)loop->accumulator_ns / (double)loop->step_ns);
+    return loop->steps;
+}
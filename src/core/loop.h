@@ -0,0 +1,43 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "../time_util.h"
+
+// fixed timestep driver: the simulation always advances by the same step, as
+// many times as the wall clock has moved on, and rendering blends the last two
+// simulated states by alpha. frame rate then changes how often the simulation
+// is sampled, not what it computes
+//
+//   uint32_t steps = loop_advance(&loop, time_now());
+//   for (uint32_t i = 0; i < steps; i++) {
+//       previous = current;
+//       simulate(&current, loop.step);
+//   }
+//   render(lerp(previous, current, loop.alpha));
+//
+// a frame slower than max_steps steps runs max_steps and drops the rest of the
+// backlog, so one long frame (a hitch, a breakpoint) is lost rather than
+// making every following frame slower while it is caught up
+typedef struct {
+    int64_t  step_ns;
+    uint32_t max_steps;
+    int64_t  accumulator_ns;  // wall time not yet simulated, < step_ns
+    time_p   last;
+    uint32_t started;
+
+    // filled in by loop_advance
+    float    step;        // seconds per step, what the simulation is handed
+    uint32_t steps;       // steps to run this frame
+    float    alpha;       // accumulator / step, 0 = previous state,
+                          // 1 = current state
+    double   frame_time;  // seconds since the previous loop_advance
+
+    uint64_t total_steps;
+    double   dropped;  // seconds discarded by the max_steps clamp
+} frame_loop;
+
+void loop_init(frame_loop* loop, double step_seconds, uint32_t max_steps);
+// measures the frame that ended at now and returns loop->steps. the first call
+// only starts the clock and returns 0
+uint32_t loop_advance(frame_loop* loop, time_p now);
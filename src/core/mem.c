@@ -1,21 +1,48 @@
 #include "mem.h"
 
 #include <stdalign.h>
+#include <stdatomic.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "../base.h"
+#include "os.h"
 
 #define round_align(size, align) (((size) + ((align) - 1)) & ~((align) - 1))
 
+#define STACK_COMMIT_CHUNK mkilo(64)
+
+#define TLSF_ALIGN_SIZE 8
+#define TLSF_SL_LOG2 5
+#define TLSF_SL_COUNT (1 << TLSF_SL_LOG2)
+#define TLSF_FL_SHIFT (TLSF_SL_LOG2 + 3)  // + log2(TLSF_ALIGN_SIZE)
+#define TLSF_FL_MAX 32                    // blocks below 4 GiB
+#define TLSF_FL_COUNT (TLSF_FL_MAX - TLSF_FL_SHIFT + 1)
+#define TLSF_SMALL_BLOCK (1 << TLSF_FL_SHIFT)
+#define TLSF_BLOCK_FREE 0x1
+#define TLSF_PREV_FREE 0x2
+
+#define POOL_MIN_CLASS_SHIFT 4  // log2(POOL_MIN_BLOCK)
+#define POOL_CLASS_COUNT 8      // 16, 32, ... POOL_MAX_BLOCK
+
+#define TCACHE_BINDINGS 8  // allocators a thread can use without re-binding
+#define TCACHE_LINE 64
+
 typedef struct free_block free_block;
+typedef struct tlsf_block tlsf_block;
+typedef struct pool_block pool_block;
 
 typedef struct {
     uint8_t* mem;
     size_t   size;
     size_t   cursor;
     size_t   prev_cursor;
+    size_t   committed;  // == size unless the arena is virtual
+    uint32_t flags;
+    uint32_t marker_depth;
 } stack_allocator;
 
 struct free_block {
@@ -26,23 +53,150 @@ struct free_block {
 typedef struct {
     uint8_t*    mem;
     size_t      size;
+    size_t      used;
     free_block* list;
 } heap_allocator;
 
+// prev_phys is only meaningful while the previous block is free; the free
+// list links live in the payload and only exist while this block is free
+struct tlsf_block {
+    tlsf_block* prev_phys;
+    size_t      size;  // payload size, low bits hold TLSF_BLOCK_FREE/PREV_FREE
+    tlsf_block* next_free;
+    tlsf_block* prev_free;
+};
+
+typedef struct {
+    uint8_t*    mem;
+    size_t      size;
+    size_t      used;
+    uint32_t    fl_bitmap;
+    uint32_t    sl_bitmap[TLSF_FL_COUNT];
+    tlsf_block* blocks[TLSF_FL_COUNT][TLSF_SL_COUNT];
+} tlsf_allocator;
+
+#define TLSF_HEADER offsetof(tlsf_block, next_free)
+#define TLSF_MIN_PAYLOAD (sizeof(tlsf_block) - TLSF_HEADER)
+
+struct pool_block {
+    pool_block* next;
+};
+
+typedef struct {
+    uint8_t*    mem;
+    size_t      size;
+    size_t      cursor;      // next span to carve out of mem
+    size_t      used;
+    uint8_t*    span_class;  // size class of each carved span
+    pool_block* free[POOL_CLASS_COUNT];
+} pool_allocator;
+
+// one per thread, padded so no two owners share a line. free lists are only
+// touched by the owner, other threads hand blocks back through remote
+typedef struct {
+    alignas(TCACHE_LINE) pool_block* free[POOL_CLASS_COUNT];
+    _Atomic(pool_block*) remote[POOL_CLASS_COUNT];
+    _Atomic uint64_t     thread;  // t_tcache_thread of the owner, 0 while free
+    // owner writes, tcache_sync_stats sums; frees of foreign blocks count here
+    // too so a single slot's live may go negative
+    _Atomic int64_t  live;
+    _Atomic uint64_t allocs;
+    _Atomic uint64_t frees;
+} tcache_thread;
+
+typedef struct {
+    uint8_t*         mem;
+    size_t           size;
+    _Atomic size_t   cursor;      // next span to carve, overshoots once full
+    uint8_t*         span_class;
+    uint8_t*         span_owner;  // thread slot each span was carved for
+    uint64_t         id;          // matches thread bindings to this allocator
+    _Atomic uint32_t thread_count;
+    atomic_flag      large_lock;
+    tlsf_allocator   large;       // blocks above POOL_MAX_BLOCK
+    // frees from threads that could not get a slot
+    _Atomic int64_t  orphan_live;
+    _Atomic uint64_t orphan_frees;
+    // totals already folded into mem_stats
+    int64_t          synced_live;
+    uint64_t         synced_allocs;
+    uint64_t         synced_frees;
+    tcache_thread    threads[TCACHE_MAX_THREADS];
+} tcache_allocator;
+
+typedef struct {
+    uint64_t id;
+    uint32_t slot;
+} tcache_binding;
+
+static void mem_track_alloc(allocator* ator, size_t bytes);
+static void mem_track_free(allocator* ator, size_t bytes);
+static void mem_track_reset(allocator* ator);
+static void mem_track_bulk(allocator* ator, int64_t bytes, uint64_t allocs,
+                           uint64_t frees);
+static void mem_register(allocator* ator);
+static void mem_unregister(allocator* ator);
+static void mem_trace_write(allocator* ator, mem_trace_op op, const void* ptr,
+                            size_t size, size_t align);
+static void mem_trace_attach(allocator* ator);
+
+// every type's arena comes from here: malloc, or a 2MB aligned mapping when
+// the allocator was created with ALLOCATOR_FLAG_HUGE_PAGES
+static void* arena_alloc(allocator* ator, size_t size, size_t align) {
+    if (ator->flags & ALLOCATOR_FLAG_HUGE_PAGES) {
+        os_pages pages = OS_PAGES_SMALL;
+        void*    mem = os_mem_map_huge(size, &pages);
+        ator->backing = (mem_backing)pages;  // same order as os_pages
+        return mem;
+    }
+    ator->backing = MEM_BACKING_SMALL_PAGES;
+    if (align <= alignof(max_align_t)) return malloc(size);
+    return aligned_alloc(align, round_align(size, align));
+}
+
+static void arena_free(allocator* ator, void* mem, size_t size) {
+    if (!mem) return;
+    if (ator->flags & ALLOCATOR_FLAG_HUGE_PAGES) {
+        os_mem_unmap_huge(mem, size);
+    } else {
+        free(mem);
+    }
+}
+
+// commits whole chunks up to `end`; already committed pages are never moved,
+// so growing a virtual arena never copies
+static int stack_commit(stack_allocator* data, size_t end) {
+    size_t commit_end = round_align(end, STACK_COMMIT_CHUNK);
+    if (commit_end > data->size) commit_end = data->size;
+    if (!os_mem_commit(data->mem + data->committed, commit_end - data->committed)) {
+        return 0;
+    }
+    data->committed = commit_end;
+    return 1;
+}
+
 static void* stack_alloc_impl(allocator* ator, size_t size, size_t align) {
     debug_assert(ator);
     stack_allocator* data = (stack_allocator*)ator->data;
     debug_assert(data);
 
-    size_t aligned_size = round_align(size, align);
+    // align the address rather than the offset, the block itself may only be
+    // malloc aligned
+    uintptr_t base = (uintptr_t)data->mem;
+    size_t    start = round_align(base + data->cursor, align) - base;
+    size_t    end = start + round_align(size, align);
 
-    if (data->cursor + aligned_size > data->size) {
+    if (end > data->size) {
+        return NULL;
+    }
+    if (end > data->committed && !stack_commit(data, end)) {
         return NULL;
     }
 
-    void* ptr = data->mem + data->cursor;
+    void* ptr = data->mem + start;
     data->prev_cursor = data->cursor;
-    data->cursor += aligned_size;
+    mem_track_alloc(ator, end - data->cursor);
+    data->cursor = end;
     return ptr;
 }
 
@@ -59,6 +213,12 @@ static void stack_reset_impl(allocator* ator) {
     debug_assert(data);
     data->cursor = 0;
     data->prev_cursor = 0;
+    data->marker_depth = 0;
+    mem_track_reset(ator);
+    if ((data->flags & ALLOCATOR_FLAG_DECOMMIT) && data->committed) {
+        os_mem_decommit(data->mem, data->committed);
+        data->committed = 0;
+    }
 }
 
 static void stack_get_info_impl(allocator* ator, size_t* used, size_t* total) {
@@ -69,12 +229,23 @@ static void stack_get_info_impl(allocator* ator, size_t* used, size_t* total) {
     *total = data->size;
 }
 
+static size_t stack_largest_free_impl(allocator* ator) {
+    debug_assert(ator);
+    stack_allocator* data = (stack_allocator*)ator->data;
+    debug_assert(data);
+    return data->size - data->cursor;
+}
+
 static void stack_destroy_impl(allocator* ator) {
     debug_assert(ator);
     stack_allocator* data = (stack_allocator*)ator->data;
     debug_assert(data);
     if (data) {
-        free(data->mem);
+        if (data->flags & ALLOCATOR_FLAG_VIRTUAL) {
+            os_mem_release(data->mem, data->size);
+        } else {
+            arena_free(ator, data->mem, data->size);
+        }
         free(data);
     }
     free(ator);
@@ -85,10 +256,11 @@ static allocfn stack_allocfn = {
     .free = stack_free_impl,
     .reset = stack_reset_impl,
     .get_info = stack_get_info_impl,
+    .largest_free = stack_largest_free_impl,
     .destroy = stack_destroy_impl,
 };
 
-static allocator* stack_create_impl(mem_tag tag, size_t size) {
+static allocator* stack_create_impl(mem_tag tag, size_t size, uint32_t flags) {
     allocator* ator = malloc(sizeof(*ator));
     if (!ator) return NULL;
     stack_allocator* data = malloc(sizeof(*data));
@@ -96,21 +268,68 @@ static allocator* stack_create_impl(mem_tag tag, size_t size) {
         free(ator);
         return NULL;
     }
-    data->mem = malloc(size);
+    ator->flags = flags;
+    ator->backing = MEM_BACKING_SMALL_PAGES;
+    if (flags & ALLOCATOR_FLAG_VIRTUAL) {
+        size = round_align(size, STACK_COMMIT_CHUNK);
+        data->mem = os_mem_reserve(size);
+        data->committed = 0;
+        // commits stay 64K chunks, so only transparent pages can back them
+        if (data->mem && (flags & ALLOCATOR_FLAG_HUGE_PAGES)) {
+            ator->backing = (mem_backing)os_mem_advise_huge(data->mem, size);
+        }
+    } else {
+        data->mem = arena_alloc(ator, size, alignof(max_align_t));
+        data->committed = size;
+    }
     if (!data->mem) {
         free(ator);
         free(data);
         return NULL;
     }
     data->size = size;
+    data->flags = (flags & ALLOCATOR_FLAG_VIRTUAL) ? flags : ALLOCATOR_FLAG_NONE;
     data->cursor = 0;
     data->prev_cursor = 0;
+    data->marker_depth = 0;
     ator->data = data;
+    ator->type = ALLOCATOR_TYPE_STACK;
     ator->tag = tag;
     ator->fn = &stack_allocfn;
     return ator;
 }
 
+amarker allocator_mark(allocator* ator) {
+    debug_assert(ator);
+    debug_assert(ator->type == ALLOCATOR_TYPE_STACK);
+    stack_allocator* data = (stack_allocator*)ator->data;
+    debug_assert(data);
+    data->marker_depth++;
+    mem_trace_write(ator, MEM_TRACE_MARK, data->mem + data->cursor, 0, 0);
+    return (amarker){.cursor = data->cursor, .depth = data->marker_depth};
+}
+
+void allocator_rewind(allocator* ator, amarker marker) {
+    debug_assert(ator);
+    debug_assert(ator->type == ALLOCATOR_TYPE_STACK);
+    stack_allocator* data = (stack_allocator*)ator->data;
+    debug_assert(data);
+    // an inner marker still open, or one taken before a reset
+    debug_assert(marker.depth == data->marker_depth);
+    debug_assert(marker.cursor <= data->cursor);
+    mem_trace_write(ator, MEM_TRACE_REWIND, data->mem + marker.cursor, 0, 0);
+    mem_track_free(ator, data->cursor - marker.cursor);
+    data->cursor = marker.cursor;
+    data->prev_cursor = marker.cursor;
+    data->marker_depth = marker.depth - 1;
+}
+
+atemp atemp_begin(allocator* ator) {
+    return (atemp){.ator = ator, .marker = allocator_mark(ator)};
+}
+
+void atemp_end(atemp temp) { allocator_rewind(temp.ator, temp.marker); }
+
 static void* heap_alloc_impl(allocator* ator, size_t size, size_t align) {
     debug_assert(ator);
     heap_allocator* data = (heap_allocator*)ator->data;
@@ -134,6 +353,8 @@ static void* heap_alloc_impl(allocator* ator, size_t size, size_t align) {
             } else {
                 *current = block->next;
             }
+            data->used += block->size + sizeof(free_block);
+            mem_track_alloc(ator, block->size + sizeof(free_block));
             return (uint8_t*)block + sizeof(free_block);
         }
         current = &block->next;
@@ -147,6 +368,8 @@ static void heap_free_impl(allocator* ator, void* ptr) {
     debug_assert(data);
 
     free_block* block_to_free = (free_block*)((uint8_t*)ptr - sizeof(free_block));
+    data->used -= block_to_free->size + sizeof(free_block);
+    mem_track_free(ator, block_to_free->size + sizeof(free_block));
     free_block** current = &data->list;
     free_block* prev = NULL;
 
@@ -177,29 +400,36 @@ static void heap_reset_impl(allocator* ator) {
     data->list = (free_block*)data->mem;
     data->list->size = data->size;
     data->list->next = NULL;
+    data->used = 0;
+    mem_track_reset(ator);
 }
 
 static void heap_get_info_impl(allocator* ator, size_t* used, size_t* total) {
     debug_assert(ator);
     heap_allocator* data = (heap_allocator*)ator->data;
     debug_assert(data);
-
+    *used = data->used;
     *total = data->size;
-    *used = 0;
-    size_t free_bytes = 0;
-    free_block* current = data->list;
-    while (current) {
-        free_bytes += current->size + sizeof(free_block);
-        current = current->next;
+}
+
+// first-fit has no size index, so this walks the free list; telemetry only
+// asks for it once per dumped frame
+static size_t heap_largest_free_impl(allocator* ator) {
+    debug_assert(ator);
+    heap_allocator* data = (heap_allocator*)ator->data;
+    debug_assert(data);
+    size_t largest = 0;
+    for (free_block* block = data->list; block; block = block->next) {
+        if (block->size > largest) largest = block->size;
     }
-    *used = *total - free_bytes;
+    return largest;
 }
 
 static void heap_destroy_impl(allocator* ator) {
     debug_assert(ator);
     heap_allocator* data = (heap_allocator*)ator->data;
     debug_assert(data);
-    free(data->mem);
+    arena_free(ator, data->mem, data->size + sizeof(free_block));
     free(data);
     free(ator);
 }
@@ -209,10 +439,11 @@ static allocfn heap_allocfn = {
     .free = heap_free_impl,
     .reset = heap_reset_impl,
     .get_info = heap_get_info_impl,
+    .largest_free = heap_largest_free_impl,
     .destroy = heap_destroy_impl,
 };
 
-static allocator* heap_create_impl(mem_tag tag, size_t size) {
+static allocator* heap_create_impl(mem_tag tag, size_t size, uint32_t flags) {
     allocator* ator = malloc(sizeof(*ator));
     if (!ator) return NULL;
     heap_allocator* data = malloc(sizeof(*data));
@@ -220,27 +451,1240 @@ static allocator* heap_create_impl(mem_tag tag, size_t size) {
         free(ator);
         return NULL;
     }
-    data->mem = malloc(size);
+    ator->flags = flags;
+    data->mem = arena_alloc(ator, size, alignof(max_align_t));
     if(!data->mem) {
         free(data);
         free(ator);
         return NULL;
     }
+    ator->data = data;
+    ator->type = ALLOCATOR_TYPE_HEAP;
     ator->tag = tag;
     ator->fn = &heap_allocfn;
     data->size = size - sizeof(free_block);
+    data->used = 0;
     data->list = (free_block*)data->mem;
+    data->list->size = data->size;
     data->list->next = NULL;
     return ator;
 }
 
+// two-level segregated fit: the first level splits sizes by power of two,
+// the second splits each power of two into TLSF_SL_COUNT linear ranges.
+// both levels keep a bitmap of non-empty lists so finding a fit is a couple
+// of bit scans, and physical neighbours are coalesced on free
+
+static size_t tlsf_block_size(tlsf_block* block) {
+    return block->size & ~(size_t)(TLSF_BLOCK_FREE | TLSF_PREV_FREE);
+}
+
+static void tlsf_set_size(tlsf_block* block, size_t size) {
+    block->size = size | (block->size & (TLSF_BLOCK_FREE | TLSF_PREV_FREE));
+}
+
+static uint8_t* tlsf_payload(tlsf_block* block) {
+    return (uint8_t*)block + TLSF_HEADER;
+}
+
+static tlsf_block* tlsf_next(tlsf_block* block) {
+    return (tlsf_block*)(tlsf_payload(block) + tlsf_block_size(block));
+}
+
+static tlsf_block* tlsf_link_next(tlsf_block* block) {
+    tlsf_block* next = tlsf_next(block);
+    next->prev_phys = block;
+    return next;
+}
+
+static void tlsf_mark_free(tlsf_block* block) {
+    tlsf_block* next = tlsf_link_next(block);
+    next->size |= TLSF_PREV_FREE;
+    block->size |= TLSF_BLOCK_FREE;
+}
+
+static void tlsf_mark_used(tlsf_block* block) {
+    tlsf_block* next = tlsf_next(block);
+    next->size &= ~(size_t)TLSF_PREV_FREE;
+    block->size &= ~(size_t)TLSF_BLOCK_FREE;
+}
+
+static void tlsf_mapping(size_t size, uint32_t* fl, uint32_t* sl) {
+    if (size < TLSF_SMALL_BLOCK) {
+        *fl = 0;
+        *sl = (uint32_t)(size / (TLSF_SMALL_BLOCK / TLSF_SL_COUNT));
+    } else {
+        uint32_t f = 63 - __builtin_clzll(size);
+        *sl = (uint32_t)(size >> (f - TLSF_SL_LOG2)) ^ TLSF_SL_COUNT;
+        *fl = f - (TLSF_FL_SHIFT - 1);
+    }
+}
+
+// rounds the request up to the next list so any block found there fits
+static void tlsf_mapping_search(size_t size, uint32_t* fl, uint32_t* sl) {
+    if (size >= TLSF_SMALL_BLOCK) {
+        size += ((size_t)1 << (63 - __builtin_clzll(size) - TLSF_SL_LOG2)) - 1;
+    }
+    tlsf_mapping(size, fl, sl);
+}
+
+static void tlsf_insert(tlsf_allocator* data, tlsf_block* block) {
+    uint32_t fl, sl;
+    tlsf_mapping(tlsf_block_size(block), &fl, &sl);
+    tlsf_block* head = data->blocks[fl][sl];
+    block->next_free = head;
+    block->prev_free = NULL;
+    if (head) head->prev_free = block;
+    data->blocks[fl][sl] = block;
+    data->fl_bitmap |= 1u << fl;
+    data->sl_bitmap[fl] |= 1u << sl;
+}
+
+static void tlsf_remove(tlsf_allocator* data, tlsf_block* block) {
+    uint32_t fl, sl;
+    tlsf_mapping(tlsf_block_size(block), &fl, &sl);
+    if (block->prev_free) {
+        block->prev_free->next_free = block->next_free;
+    } else {
+        data->blocks[fl][sl] = block->next_free;
+    }
+    if (block->next_free) {
+        block->next_free->prev_free = block->prev_free;
+    }
+    if (!data->blocks[fl][sl]) {
+        data->sl_bitmap[fl] &= ~(1u << sl);
+        if (!data->sl_bitmap[fl]) {
+            data->fl_bitmap &= ~(1u << fl);
+        }
+    }
+}
+
+static tlsf_block* tlsf_find(tlsf_allocator* data, size_t size) {
+    uint32_t fl, sl;
+    tlsf_mapping_search(size, &fl, &sl);
+    if (fl >= TLSF_FL_COUNT) return NULL;
+
+    uint32_t sl_map = data->sl_bitmap[fl] & (~0u << sl);
+    if (!sl_map) {
+        uint32_t fl_map = data->fl_bitmap & (~0u << (fl + 1));
+        if (!fl_map) return NULL;
+        fl = __builtin_ctz(fl_map);
+        sl_map = data->sl_bitmap[fl];
+    }
+    sl = __builtin_ctz(sl_map);
+    return data->blocks[fl][sl];
+}
+
+// splits `size` bytes off the front of a free block, returns the free rest
+static tlsf_block* tlsf_split(tlsf_block* block, size_t size) {
+    tlsf_block* rest = (tlsf_block*)(tlsf_payload(block) + size);
+    rest->prev_phys = block;
+    rest->size = (tlsf_block_size(block) - size - TLSF_HEADER) | TLSF_PREV_FREE;
+    tlsf_set_size(block, size);
+    tlsf_mark_free(rest);
+    return rest;
+}
+
+static void tlsf_init_pool(tlsf_allocator* data) {
+    data->used = 0;
+    data->fl_bitmap = 0;
+    for (uint32_t i = 0; i < TLSF_FL_COUNT; i++) {
+        data->sl_bitmap[i] = 0;
+        for (uint32_t j = 0; j < TLSF_SL_COUNT; j++) {
+            data->blocks[i][j] = NULL;
+        }
+    }
+    // one free block spanning the pool, followed by a zero sized used
+    // sentinel so the last real block always has a physical neighbour
+    tlsf_block* block = (tlsf_block*)data->mem;
+    block->prev_phys = NULL;
+    block->size = (data->size - 2 * TLSF_HEADER) & ~(size_t)(TLSF_ALIGN_SIZE - 1);
+    tlsf_block* sentinel = tlsf_next(block);
+    sentinel->size = 0;
+    tlsf_mark_free(block);
+    tlsf_insert(data, block);
+}
+
+// bytes a live allocation takes out of the pool, header included
+static size_t tlsf_alloc_size(void* ptr) {
+    tlsf_block* block = (tlsf_block*)((uint8_t*)ptr - TLSF_HEADER);
+    return tlsf_block_size(block) + TLSF_HEADER;
+}
+
+// the pool itself, shared by the tlsf allocator type and the large block
+// heap of the thread cache; telemetry is left to the caller
+static void* tlsf_malloc(tlsf_allocator* data, size_t size, size_t align) {
+    debug_assert((align & (align - 1)) == 0);
+
+    size_t adjust = round_align(size, TLSF_ALIGN_SIZE);
+    if (adjust < TLSF_MIN_PAYLOAD) adjust = TLSF_MIN_PAYLOAD;
+    if (align < TLSF_ALIGN_SIZE) align = TLSF_ALIGN_SIZE;
+
+    // over-aligned requests reserve room to split a free block off the front
+    size_t gap_min = sizeof(tlsf_block);
+    size_t search = align > TLSF_ALIGN_SIZE ? adjust + align + gap_min : adjust;
+
+    tlsf_block* block = tlsf_find(data, search);
+    if (!block) {
+        return NULL;
+    }
+    tlsf_remove(data, block);
+
+    if (align > TLSF_ALIGN_SIZE) {
+        uintptr_t payload = (uintptr_t)tlsf_payload(block);
+        size_t    gap = round_align(payload, align) - payload;
+        if (gap && gap < gap_min) {
+            gap = round_align(payload + gap_min, align) - payload;
+        }
+        if (gap) {
+            tlsf_block* aligned = tlsf_split(block, gap - TLSF_HEADER);
+            tlsf_insert(data, block);
+            block = aligned;
+        }
+    }
+
+    if (tlsf_block_size(block) >= adjust + sizeof(tlsf_block)) {
+        tlsf_block* rest = tlsf_split(block, adjust);
+        tlsf_insert(data, rest);
+    }
+    tlsf_mark_used(block);
+    data->used += tlsf_block_size(block) + TLSF_HEADER;
+    return tlsf_payload(block);
+}
+
+static void tlsf_release(tlsf_allocator* data, void* ptr) {
+    tlsf_block* block = (tlsf_block*)((uint8_t*)ptr - TLSF_HEADER);
+    debug_assert(!(block->size & TLSF_BLOCK_FREE));
+    data->used -= tlsf_block_size(block) + TLSF_HEADER;
+    tlsf_mark_free(block);
+
+    if (block->size & TLSF_PREV_FREE) {
+        tlsf_block* prev = block->prev_phys;
+        tlsf_remove(data, prev);
+        tlsf_set_size(prev, tlsf_block_size(prev) + TLSF_HEADER +
+                                tlsf_block_size(block));
+        tlsf_link_next(prev);
+        block = prev;
+    }
+    tlsf_block* next = tlsf_next(block);
+    if (next->size & TLSF_BLOCK_FREE) {
+        tlsf_remove(data, next);
+        tlsf_set_size(block, tlsf_block_size(block) + TLSF_HEADER +
+                                 tlsf_block_size(next));
+        tlsf_link_next(block);
+    }
+    tlsf_insert(data, block);
+}
+
+static void* tlsf_alloc_impl(allocator* ator, size_t size, size_t align) {
+    debug_assert(ator);
+    tlsf_allocator* data = (tlsf_allocator*)ator->data;
+    debug_assert(data);
+    void* ptr = tlsf_malloc(data, size, align);
+    if (ptr) {
+        mem_track_alloc(ator, tlsf_alloc_size(ptr));
+    }
+    return ptr;
+}
+
+static void tlsf_free_impl(allocator* ator, void* ptr) {
+    debug_assert(ator);
+    tlsf_allocator* data = (tlsf_allocator*)ator->data;
+    debug_assert(data);
+    if (!ptr) return;
+    mem_track_free(ator, tlsf_alloc_size(ptr));
+    tlsf_release(data, ptr);
+}
+
+static void tlsf_reset_impl(allocator* ator) {
+    debug_assert(ator);
+    tlsf_allocator* data = (tlsf_allocator*)ator->data;
+    debug_assert(data);
+    tlsf_init_pool(data);
+    mem_track_reset(ator);
+}
+
+static void tlsf_get_info_impl(allocator* ator, size_t* used, size_t* total) {
+    debug_assert(ator);
+    tlsf_allocator* data = (tlsf_allocator*)ator->data;
+    debug_assert(data);
+    *used = data->used;
+    *total = data->size;
+}
+
+// head of the highest non-empty list; blocks in one list differ by less than
+// a second-level step, so this is exact to within 1/TLSF_SL_COUNT
+static size_t tlsf_largest_free(tlsf_allocator* data) {
+    if (!data->fl_bitmap) return 0;
+    uint32_t fl = 31 - __builtin_clz(data->fl_bitmap);
+    uint32_t sl = 31 - __builtin_clz(data->sl_bitmap[fl]);
+    return tlsf_block_size(data->blocks[fl][sl]);
+}
+
+static size_t tlsf_largest_free_impl(allocator* ator) {
+    debug_assert(ator);
+    tlsf_allocator* data = (tlsf_allocator*)ator->data;
+    debug_assert(data);
+    return tlsf_largest_free(data);
+}
+
+static void tlsf_destroy_impl(allocator* ator) {
+    debug_assert(ator);
+    tlsf_allocator* data = (tlsf_allocator*)ator->data;
+    debug_assert(data);
+    arena_free(ator, data->mem, data->size);
+    free(data);
+    free(ator);
+}
+
+static allocfn tlsf_allocfn = {
+    .alloc = tlsf_alloc_impl,
+    .free = tlsf_free_impl,
+    .reset = tlsf_reset_impl,
+    .get_info = tlsf_get_info_impl,
+    .largest_free = tlsf_largest_free_impl,
+    .destroy = tlsf_destroy_impl,
+};
+
+static allocator* tlsf_create_impl(mem_tag tag, size_t size, uint32_t flags) {
+    if (size < 4 * sizeof(tlsf_block) || size >> TLSF_FL_MAX) {
+        return NULL;
+    }
+    allocator* ator = malloc(sizeof(*ator));
+    if (!ator) return NULL;
+    tlsf_allocator* data = malloc(sizeof(*data));
+    if (!data) {
+        free(ator);
+        return NULL;
+    }
+    ator->flags = flags;
+    data->mem = arena_alloc(ator, size, alignof(max_align_t));
+    if (!data->mem) {
+        free(data);
+        free(ator);
+        return NULL;
+    }
+    data->size = size;
+    tlsf_init_pool(data);
+    ator->data = data;
+    ator->type = ALLOCATOR_TYPE_TLSF;
+    ator->tag = tag;
+    ator->fn = &tlsf_allocfn;
+    return ator;
+}
+
+// blocks are carved out of POOL_SPAN_SIZE spans, each span serving a single
+// size class; the span index of a pointer gives back its class on free
+
+static uint32_t pool_class_index(size_t size) {
+    if (size <= POOL_MIN_BLOCK) return 0;
+    return (64 - __builtin_clzll(size - 1)) - POOL_MIN_CLASS_SHIFT;
+}
+
+static int pool_grow(pool_allocator* data, uint32_t cls) {
+    if (data->cursor + POOL_SPAN_SIZE > data->size) {
+        return 0;
+    }
+    uint8_t* span = data->mem + data->cursor;
+    size_t   block_size = (size_t)POOL_MIN_BLOCK << cls;
+    size_t   block_count = POOL_SPAN_SIZE / block_size;
+
+    data->span_class[data->cursor / POOL_SPAN_SIZE] = (uint8_t)cls;
+    data->cursor += POOL_SPAN_SIZE;
+
+    for (size_t i = 0; i < block_count - 1; i++) {
+        pool_block* block = (pool_block*)(span + i * block_size);
+        block->next = (pool_block*)(span + (i + 1) * block_size);
+    }
+    pool_block* last = (pool_block*)(span + (block_count - 1) * block_size);
+    last->next = data->free[cls];
+    data->free[cls] = (pool_block*)span;
+    return 1;
+}
+
+static void* pool_alloc_impl(allocator* ator, size_t size, size_t align) {
+    debug_assert(ator);
+    pool_allocator* data = (pool_allocator*)ator->data;
+    debug_assert(data);
+
+    // classes are powers of two and spans are span-aligned, so every block is
+    // naturally aligned to its own size
+    uint32_t cls = pool_class_index(size > align ? size : align);
+    if (cls >= POOL_CLASS_COUNT) {
+        return NULL;
+    }
+    if (!data->free[cls] && !pool_grow(data, cls)) {
+        return NULL;
+    }
+    pool_block* block = data->free[cls];
+    data->free[cls] = block->next;
+    data->used += (size_t)POOL_MIN_BLOCK << cls;
+    mem_track_alloc(ator, (size_t)POOL_MIN_BLOCK << cls);
+    return block;
+}
+
+static void pool_free_impl(allocator* ator, void* ptr) {
+    debug_assert(ator);
+    pool_allocator* data = (pool_allocator*)ator->data;
+    debug_assert(data);
+    if (!ptr) return;
+
+    size_t offset = (uint8_t*)ptr - data->mem;
+    debug_assert(offset < data->cursor);
+    uint32_t    cls = data->span_class[offset / POOL_SPAN_SIZE];
+    pool_block* block = (pool_block*)ptr;
+    block->next = data->free[cls];
+    data->free[cls] = block;
+    data->used -= (size_t)POOL_MIN_BLOCK << cls;
+    mem_track_free(ator, (size_t)POOL_MIN_BLOCK << cls);
+}
+
+static void pool_reset_impl(allocator* ator) {
+    debug_assert(ator);
+    pool_allocator* data = (pool_allocator*)ator->data;
+    debug_assert(data);
+    data->cursor = 0;
+    data->used = 0;
+    for (uint32_t i = 0; i < POOL_CLASS_COUNT; i++) {
+        data->free[i] = NULL;
+    }
+    mem_track_reset(ator);
+}
+
+static void pool_get_info_impl(allocator* ator, size_t* used, size_t* total) {
+    debug_assert(ator);
+    pool_allocator* data = (pool_allocator*)ator->data;
+    debug_assert(data);
+    *used = data->used;
+    *total = data->size;
+}
+
+static size_t pool_largest_free_impl(allocator* ator) {
+    debug_assert(ator);
+    pool_allocator* data = (pool_allocator*)ator->data;
+    debug_assert(data);
+    if (data->cursor + POOL_SPAN_SIZE <= data->size) return POOL_MAX_BLOCK;
+    for (uint32_t i = POOL_CLASS_COUNT; i > 0; i--) {
+        if (data->free[i - 1]) return (size_t)POOL_MIN_BLOCK << (i - 1);
+    }
+    return 0;
+}
+
+static void pool_destroy_impl(allocator* ator) {
+    debug_assert(ator);
+    pool_allocator* data = (pool_allocator*)ator->data;
+    debug_assert(data);
+    free(data->span_class);
+    arena_free(ator, data->mem, data->size);
+    free(data);
+    free(ator);
+}
+
+static allocfn pool_allocfn = {
+    .alloc = pool_alloc_impl,
+    .free = pool_free_impl,
+    .reset = pool_reset_impl,
+    .get_info = pool_get_info_impl,
+    .largest_free = pool_largest_free_impl,
+    .destroy = pool_destroy_impl,
+};
+
+static allocator* pool_create_impl(mem_tag tag, size_t size, uint32_t flags) {
+    size = round_align(size, POOL_SPAN_SIZE);
+    allocator* ator = malloc(sizeof(*ator));
+    if (!ator) return NULL;
+    pool_allocator* data = malloc(sizeof(*data));
+    if (!data) {
+        free(ator);
+        return NULL;
+    }
+    ator->flags = flags;
+    data->mem = arena_alloc(ator, size, POOL_SPAN_SIZE);
+    data->span_class = malloc(size / POOL_SPAN_SIZE);
+    if (!data->mem || !data->span_class) {
+        arena_free(ator, data->mem, size);
+        free(data->span_class);
+        free(data);
+        free(ator);
+        return NULL;
+    }
+    data->size = size;
+    data->cursor = 0;
+    data->used = 0;
+    for (uint32_t i = 0; i < POOL_CLASS_COUNT; i++) {
+        data->free[i] = NULL;
+    }
+    ator->data = data;
+    ator->type = ALLOCATOR_TYPE_POOL;
+    ator->tag = tag;
+    ator->fn = &pool_allocfn;
+    return ator;
+}
+
+// thread cache: the pool's size classes and spans, but every thread carves
+// its own spans and keeps its own free lists, so the common alloc and free
+// never synchronise. a block freed by another thread is pushed onto its
+// owner's lock-free remote list and adopted the next time the owner runs dry.
+// spans are never handed back between threads; blocks above POOL_MAX_BLOCK go
+// to a tlsf heap behind a spinlock
+
+static _Thread_local tcache_binding t_tcache_bindings[TCACHE_BINDINGS];
+static _Thread_local uint64_t       t_tcache_thread;
+static _Atomic uint64_t             g_tcache_next_id = 1;
+static _Atomic uint64_t             g_tcache_next_thread = 1;
+
+static uint32_t tcache_thread_count(tcache_allocator* data) {
+    uint32_t count =
+        atomic_load_explicit(&data->thread_count, memory_order_relaxed);
+    return count < TCACHE_MAX_THREADS ? count : TCACHE_MAX_THREADS;
+}
+
+// a thread keeps one slot per allocator for its whole life, its spans and
+// remote lists hang off it. the bindings only cache which slot that is,
+// direct mapped on the allocator id; on a miss the slots are searched for
+// this thread before a new one is claimed, so allocators that collide in the
+// cache cost a scan when alternating, never a slot
+static tcache_thread* tcache_bind(tcache_allocator* data) {
+    tcache_binding* binding = &t_tcache_bindings[data->id % TCACHE_BINDINGS];
+    if (binding->id == data->id) {
+        return &data->threads[binding->slot];
+    }
+    if (!t_tcache_thread) {
+        t_tcache_thread = atomic_fetch_add_explicit(&g_tcache_next_thread, 1,
+                                                    memory_order_relaxed);
+    }
+    // only this thread ever stores its own id, so a relaxed scan can't miss
+    // a slot it claimed earlier
+    uint32_t count = tcache_thread_count(data);
+    uint32_t slot = 0;
+    while (slot < count &&
+           atomic_load_explicit(&data->threads[slot].thread,
+                                memory_order_relaxed) != t_tcache_thread) {
+        slot++;
+    }
+    if (slot == count) {
+        slot = atomic_fetch_add_explicit(&data->thread_count, 1,
+                                         memory_order_relaxed);
+        if (slot >= TCACHE_MAX_THREADS) {
+            debug_log("thread cache allocator out of thread slots\n");
+            return NULL;
+        }
+        atomic_store_explicit(&data->threads[slot].thread, t_tcache_thread,
+                              memory_order_relaxed);
+    }
+    binding->id = data->id;
+    binding->slot = slot;
+    return &data->threads[slot];
+}
+
+// only the owning thread writes its counters, a plain load/store is enough
+static void tcache_count(tcache_thread* c, int64_t bytes, uint64_t allocs,
+                         uint64_t frees) {
+    memory_order relaxed = memory_order_relaxed;
+    int64_t      live = atomic_load_explicit(&c->live, relaxed);
+    uint64_t     total_allocs = atomic_load_explicit(&c->allocs, relaxed);
+    uint64_t     total_frees = atomic_load_explicit(&c->frees, relaxed);
+    atomic_store_explicit(&c->live, live + bytes, relaxed);
+    atomic_store_explicit(&c->allocs, total_allocs + allocs, relaxed);
+    atomic_store_explicit(&c->frees, total_frees + frees, relaxed);
+}
+
+static void tcache_lock(tcache_allocator* data) {
+    while (atomic_flag_test_and_set_explicit(&data->large_lock,
+                                             memory_order_acquire)) {
+    }
+}
+
+static void tcache_unlock(tcache_allocator* data) {
+    atomic_flag_clear_explicit(&data->large_lock, memory_order_release);
+}
+
+static pool_block* tcache_grow(tcache_allocator* data, tcache_thread* c,
+                               uint32_t cls) {
+    size_t offset = atomic_fetch_add_explicit(&data->cursor, POOL_SPAN_SIZE,
+                                              memory_order_relaxed);
+    if (offset + POOL_SPAN_SIZE > data->size) {
+        return NULL;
+    }
+    uint8_t* span = data->mem + offset;
+    size_t   block_size = (size_t)POOL_MIN_BLOCK << cls;
+    size_t   block_count = POOL_SPAN_SIZE / block_size;
+
+    data->span_class[offset / POOL_SPAN_SIZE] = (uint8_t)cls;
+    data->span_owner[offset / POOL_SPAN_SIZE] = (uint8_t)(c - data->threads);
+
+    for (size_t i = 0; i < block_count - 1; i++) {
+        pool_block* block = (pool_block*)(span + i * block_size);
+        block->next = (pool_block*)(span + (i + 1) * block_size);
+    }
+    pool_block* last = (pool_block*)(span + (block_count - 1) * block_size);
+    last->next = NULL;
+    return (pool_block*)span;
+}
+
+static void* tcache_alloc_impl(allocator* ator, size_t size, size_t align) {
+    debug_assert(ator);
+    tcache_allocator* data = (tcache_allocator*)ator->data;
+    debug_assert(data);
+    tcache_thread* c = tcache_bind(data);
+    if (!c) return NULL;
+
+    size_t need = size > align ? size : align;
+    if (need > POOL_MAX_BLOCK) {
+        tcache_lock(data);
+        void*  ptr = tlsf_malloc(&data->large, size, align);
+        size_t bytes = ptr ? tlsf_alloc_size(ptr) : 0;
+        tcache_unlock(data);
+        if (ptr) tcache_count(c, (int64_t)bytes, 1, 0);
+        return ptr;
+    }
+
+    uint32_t    cls = pool_class_index(need);
+    pool_block* block = c->free[cls];
+    if (!block) {
+        // take back everything other threads freed before carving a new span
+        block = atomic_exchange_explicit(&c->remote[cls], NULL,
+                                         memory_order_acquire);
+        if (!block) block = tcache_grow(data, c, cls);
+        if (!block) return NULL;
+    }
+    c->free[cls] = block->next;
+    tcache_count(c, (int64_t)POOL_MIN_BLOCK << cls, 1, 0);
+    return block;
+}
+
+static void tcache_free_impl(allocator* ator, void* ptr) {
+    debug_assert(ator);
+    tcache_allocator* data = (tcache_allocator*)ator->data;
+    debug_assert(data);
+    if (!ptr) return;
+
+    tcache_thread* c = tcache_bind(data);
+    size_t         offset = (uintptr_t)ptr - (uintptr_t)data->mem;
+    int64_t        bytes;
+    if (offset < data->size) {
+        size_t         span = offset / POOL_SPAN_SIZE;
+        uint32_t       cls = data->span_class[span];
+        tcache_thread* owner = &data->threads[data->span_owner[span]];
+        pool_block*    block = (pool_block*)ptr;
+        if (owner == c) {
+            block->next = c->free[cls];
+            c->free[cls] = block;
+        } else {
+            pool_block* head =
+                atomic_load_explicit(&owner->remote[cls], memory_order_relaxed);
+            do {
+                block->next = head;
+            } while (!atomic_compare_exchange_weak_explicit(
+                &owner->remote[cls], &head, block, memory_order_release,
+                memory_order_relaxed));
+        }
+        bytes = (int64_t)POOL_MIN_BLOCK << cls;
+    } else {
+        tcache_lock(data);
+        bytes = (int64_t)tlsf_alloc_size(ptr);
+        tlsf_release(&data->large, ptr);
+        tcache_unlock(data);
+    }
+
+    if (c) {
+        tcache_count(c, -bytes, 0, 1);
+    } else {
+        atomic_fetch_sub_explicit(&data->orphan_live, bytes, memory_order_relaxed);
+        atomic_fetch_add_explicit(&data->orphan_frees, 1, memory_order_relaxed);
+    }
+}
+
+static int64_t tcache_live(tcache_allocator* data) {
+    int64_t  live = atomic_load_explicit(&data->orphan_live, memory_order_relaxed);
+    uint32_t count = tcache_thread_count(data);
+    for (uint32_t i = 0; i < count; i++) {
+        live += atomic_load_explicit(&data->threads[i].live, memory_order_relaxed);
+    }
+    return live;
+}
+
+// thread counters are folded into mem_stats whenever telemetry reads them, so
+// peak and the frame counters are only as fine grained as those reads
+static void tcache_sync_stats(allocator* ator) {
+    tcache_allocator* data = (tcache_allocator*)ator->data;
+    int64_t           live = tcache_live(data);
+    uint64_t          allocs = 0;
+    uint64_t          frees =
+        atomic_load_explicit(&data->orphan_frees, memory_order_relaxed);
+    uint32_t count = tcache_thread_count(data);
+    for (uint32_t i = 0; i < count; i++) {
+        tcache_thread* c = &data->threads[i];
+        allocs += atomic_load_explicit(&c->allocs, memory_order_relaxed);
+        frees += atomic_load_explicit(&c->frees, memory_order_relaxed);
+    }
+    mem_track_bulk(ator, live - data->synced_live, allocs - data->synced_allocs,
+                   frees - data->synced_frees);
+    data->synced_live = live;
+    data->synced_allocs = allocs;
+    data->synced_frees = frees;
+}
+
+// not thread-safe: no other thread may be using the allocator
+static void tcache_reset_impl(allocator* ator) {
+    debug_assert(ator);
+    tcache_allocator* data = (tcache_allocator*)ator->data;
+    debug_assert(data);
+    atomic_store(&data->cursor, 0);
+    for (uint32_t i = 0; i < TCACHE_MAX_THREADS; i++) {
+        tcache_thread* c = &data->threads[i];
+        for (uint32_t j = 0; j < POOL_CLASS_COUNT; j++) {
+            c->free[j] = NULL;
+            atomic_store(&c->remote[j], NULL);
+        }
+        atomic_store(&c->live, 0);
+        atomic_store(&c->allocs, 0);
+        atomic_store(&c->frees, 0);
+    }
+    atomic_store(&data->orphan_live, 0);
+    atomic_store(&data->orphan_frees, 0);
+    data->synced_live = 0;
+    data->synced_allocs = 0;
+    data->synced_frees = 0;
+    tlsf_init_pool(&data->large);
+    mem_track_reset(ator);
+}
+
+static void tcache_get_info_impl(allocator* ator, size_t* used, size_t* total) {
+    debug_assert(ator);
+    tcache_allocator* data = (tcache_allocator*)ator->data;
+    debug_assert(data);
+    int64_t live = tcache_live(data);
+    *used = live > 0 ? (size_t)live : 0;
+    *total = data->size + data->large.size;
+}
+
+static size_t tcache_largest_free_impl(allocator* ator) {
+    debug_assert(ator);
+    tcache_allocator* data = (tcache_allocator*)ator->data;
+    debug_assert(data);
+    tcache_lock(data);
+    size_t largest = tlsf_largest_free(&data->large);
+    tcache_unlock(data);
+    size_t cursor = atomic_load_explicit(&data->cursor, memory_order_relaxed);
+    if (cursor + POOL_SPAN_SIZE <= data->size && largest < POOL_MAX_BLOCK) {
+        largest = POOL_MAX_BLOCK;
+    }
+    return largest;
+}
+
+static void tcache_destroy_impl(allocator* ator) {
+    debug_assert(ator);
+    tcache_allocator* data = (tcache_allocator*)ator->data;
+    debug_assert(data);
+    arena_free(ator, data->large.mem, data->large.size);
+    free(data->span_owner);
+    free(data->span_class);
+    arena_free(ator, data->mem, data->size);
+    free(data);
+    free(ator);
+}
+
+static allocfn tcache_allocfn = {
+    .alloc = tcache_alloc_impl,
+    .free = tcache_free_impl,
+    .reset = tcache_reset_impl,
+    .get_info = tcache_get_info_impl,
+    .largest_free = tcache_largest_free_impl,
+    .destroy = tcache_destroy_impl,
+};
+
+static allocator* tcache_create_impl(mem_tag tag, size_t size, uint32_t flags) {
+    size_t large_size = size / TCACHE_LARGE_DIV;
+    size_t span_size = (size - large_size) & ~(size_t)(POOL_SPAN_SIZE - 1);
+    if (!span_size || large_size < 4 * sizeof(tlsf_block) ||
+        large_size >> TLSF_FL_MAX) {
+        return NULL;
+    }
+    allocator* ator = malloc(sizeof(*ator));
+    if (!ator) return NULL;
+    tcache_allocator* data =
+        aligned_alloc(TCACHE_LINE, round_align(sizeof(*data), TCACHE_LINE));
+    if (!data) {
+        free(ator);
+        return NULL;
+    }
+    memset(data, 0, sizeof(*data));
+    ator->flags = flags;
+    // spans last, they are the bulk of it and the backing reported is theirs
+    data->large.mem = arena_alloc(ator, large_size, alignof(max_align_t));
+    data->mem = arena_alloc(ator, span_size, POOL_SPAN_SIZE);
+    data->span_class = malloc(span_size / POOL_SPAN_SIZE);
+    data->span_owner = malloc(span_size / POOL_SPAN_SIZE);
+    if (!data->mem || !data->span_class || !data->span_owner ||
+        !data->large.mem) {
+        arena_free(ator, data->large.mem, large_size);
+        free(data->span_owner);
+        free(data->span_class);
+        arena_free(ator, data->mem, span_size);
+        free(data);
+        free(ator);
+        return NULL;
+    }
+    data->size = span_size;
+    data->large.size = large_size;
+    tlsf_init_pool(&data->large);
+    atomic_flag_clear(&data->large_lock);
+    data->id = atomic_fetch_add(&g_tcache_next_id, 1);
+    ator->data = data;
+    ator->type = ALLOCATOR_TYPE_TCACHE;
+    ator->tag = tag;
+    ator->fn = &tcache_allocfn;
+    return ator;
+}
+
 allocator* allocator_create(allocator_type type, mem_tag tag, size_t size) {
+    return allocator_create_ex(type, tag, size, ALLOCATOR_FLAG_NONE);
+}
+
+allocator* allocator_create_ex(allocator_type type, mem_tag tag, size_t size,
+                               uint32_t flags) {
+    // only the stack allocator knows how to grow into reserved address space
+    uint32_t stack_only = ALLOCATOR_FLAG_VIRTUAL | ALLOCATOR_FLAG_DECOMMIT;
+    if (type != ALLOCATOR_TYPE_STACK && (flags & stack_only)) {
+        debug_log("allocator flags %x not supported for type %d\n", flags, type);
+        return NULL;
+    }
+    allocator* ator = NULL;
     switch (type) {
         case ALLOCATOR_TYPE_STACK:
-            return stack_create_impl(tag, size);
+            ator = stack_create_impl(tag, size, flags);
+            break;
         case ALLOCATOR_TYPE_HEAP:
-            return heap_create_impl(tag, size);
+            ator = heap_create_impl(tag, size, flags);
+            break;
+        case ALLOCATOR_TYPE_POOL:
+            ator = pool_create_impl(tag, size, flags);
+            break;
+        case ALLOCATOR_TYPE_TLSF:
+            ator = tlsf_create_impl(tag, size, flags);
+            break;
+        case ALLOCATOR_TYPE_TCACHE:
+            ator = tcache_create_impl(tag, size, flags);
+            break;
         default:
             return NULL;
     }
+    if (ator) {
+        mem_register(ator);
+    }
+    return ator;
+}
+
+void allocator_destroy(allocator* ator) {
+    debug_assert(ator);
+    mem_unregister(ator);
+    ator->fn->destroy(ator);
+}
+
+//=========================================================
+//
+// telemetry
+//
+//=========================================================
+
+static const char* g_tag_names[MEM_TAG_MAX_ENUM] = {
+    "core",
+    "renderer",
+};
+
+static const char* g_type_names[ALLOCATOR_TYPE_MAX_ENUM] = {
+    "stack",
+    "heap",
+    "pool",
+    "tlsf",
+    "tcache",
+};
+
+static const char* g_backing_names[] = {
+    "small",
+    "huge_explicit",
+    "huge_transparent",
+};
+
+// counting only touches the allocator's own stats, which have one owner, so
+// allocators used on different threads never share a line. a tag's totals
+// are summed over its allocators when they are read; the tag peak is the
+// highest of those sums, so it is only as fine grained as the reads, like the
+// thread cache counters
+static allocator*       g_allocators[MEM_MAX_ALLOCATORS];
+static FILE*            g_stats_file;
+static mem_stats_format g_stats_format;
+// an allocator's frame counters only ever grow, its owner may be counting on
+// another thread; the frame values are taken against these, written by
+// mem_stats_frame
+static uint32_t g_frame_base_allocs[MEM_MAX_ALLOCATORS];
+static uint32_t g_frame_base_frees[MEM_MAX_ALLOCATORS];
+static size_t   g_tag_peak[MEM_TAG_MAX_ENUM];
+static uint64_t g_tag_retired_allocs[MEM_TAG_MAX_ENUM];  // destroyed allocators
+
+static void mem_track_alloc(allocator* ator, size_t bytes) {
+    mem_stats* stats = &ator->stats;
+    stats->live += bytes;
+    if (stats->live > stats->peak) stats->peak = stats->live;
+    stats->frame_allocs++;
+    stats->total_allocs++;
+}
+
+static void mem_track_free(allocator* ator, size_t bytes) {
+    ator->stats.live -= bytes;
+    ator->stats.frame_frees++;
+}
+
+static void mem_track_reset(allocator* ator) { ator->stats.live = 0; }
+
+// for allocators that count on their own threads and report in batches
+static void mem_track_bulk(allocator* ator, int64_t bytes, uint64_t allocs,
+                           uint64_t frees) {
+    mem_stats* stats = &ator->stats;
+    stats->live += (size_t)bytes;
+    if (stats->live > stats->peak) stats->peak = stats->live;
+    stats->frame_allocs += (uint32_t)allocs;
+    stats->frame_frees += (uint32_t)frees;
+    stats->total_allocs += allocs;
+}
+
+static void mem_sync(allocator* ator) {
+    if (ator->type == ALLOCATOR_TYPE_TCACHE) {
+        tcache_sync_stats(ator);
+    }
+}
+
+static void mem_register(allocator* ator) {
+    size_t used;
+    aget_info(ator, &used, &ator->stats.capacity);
+    ator->stats.live = 0;
+    ator->stats.peak = 0;
+    ator->stats.frame_allocs = 0;
+    ator->stats.frame_frees = 0;
+    ator->stats.total_allocs = 0;
+    uint32_t slot = 0;
+    while (slot < MEM_MAX_ALLOCATORS && g_allocators[slot]) {
+        slot++;
+    }
+    if (slot < MEM_MAX_ALLOCATORS) {
+        g_allocators[slot] = ator;
+        g_frame_base_allocs[slot] = 0;
+        g_frame_base_frees[slot] = 0;
+    } else {
+        debug_log("allocator registry full, allocator will not be reported\n");
+    }
+    mem_trace_attach(ator);
+}
+
+static void mem_unregister(allocator* ator) {
+    mem_sync(ator);
+    mem_trace_write(ator, MEM_TRACE_DESTROY, NULL, 0, 0);
+    g_tag_retired_allocs[ator->tag] += ator->stats.total_allocs;
+    for (uint32_t i = 0; i < MEM_MAX_ALLOCATORS; i++) {
+        if (g_allocators[i] == ator) {
+            g_allocators[i] = NULL;
+            return;
+        }
+    }
+}
+
+static size_t mem_free_bytes(const mem_stats* stats) {
+    return stats->capacity > stats->live ? stats->capacity - stats->live : 0;
+}
+
+// free bytes a request of any size could still be served from. for the
+// splitting types that is the largest block. the size-class types never split
+// or merge, so for them it is whatever isn't parked in one class's free
+// lists: the uncarved span tail, plus the large heap's biggest block for the
+// thread cache
+static size_t mem_usable_free(allocator* ator, size_t largest_free) {
+    switch (ator->type) {
+        case ALLOCATOR_TYPE_POOL: {
+            pool_allocator* data = (pool_allocator*)ator->data;
+            return data->cursor < data->size ? data->size - data->cursor : 0;
+        }
+        case ALLOCATOR_TYPE_TCACHE: {
+            tcache_allocator* data = (tcache_allocator*)ator->data;
+            size_t cursor =
+                atomic_load_explicit(&data->cursor, memory_order_relaxed);
+            tcache_lock(data);
+            size_t large = tlsf_largest_free(&data->large);
+            tcache_unlock(data);
+            return (cursor < data->size ? data->size - cursor : 0) + large;
+        }
+        default:
+            return largest_free;
+    }
+}
+
+static float mem_fragmentation(size_t free_bytes, size_t usable) {
+    if (!free_bytes || usable >= free_bytes) return 0.0f;
+    return 1.0f - (float)usable / (float)free_bytes;
+}
+
+void mem_stats_get(allocator* ator, mem_stats* stats) {
+    debug_assert(ator);
+    mem_sync(ator);
+    *stats = ator->stats;
+    for (uint32_t i = 0; i < MEM_MAX_ALLOCATORS; i++) {
+        if (g_allocators[i] != ator) continue;
+        stats->frame_allocs -= g_frame_base_allocs[i];
+        stats->frame_frees -= g_frame_base_frees[i];
+        break;
+    }
+    stats->backing = ator->backing;
+    stats->largest_free = ator->fn->largest_free(ator);
+    stats->fragmentation =
+        mem_fragmentation(mem_free_bytes(stats),
+                          mem_usable_free(ator, stats->largest_free));
+}
+
+void mem_tag_stats(mem_tag tag, mem_stats* stats) {
+    debug_assert(tag < MEM_TAG_MAX_ENUM);
+    *stats = (mem_stats){.total_allocs = g_tag_retired_allocs[tag]};
+    size_t peak = g_tag_peak[tag];
+    float  weighted = 0.0f;  // each allocator's fragmentation by its free bytes
+    for (uint32_t i = 0; i < MEM_MAX_ALLOCATORS; i++) {
+        allocator* ator = g_allocators[i];
+        if (!ator || ator->tag != tag) continue;
+        mem_stats a;
+        mem_stats_get(ator, &a);
+        stats->live += a.live;
+        stats->capacity += a.capacity;
+        stats->frame_allocs += a.frame_allocs;
+        stats->frame_frees += a.frame_frees;
+        stats->total_allocs += a.total_allocs;
+        if (a.peak > peak) peak = a.peak;
+        if (a.largest_free > stats->largest_free) {
+            stats->largest_free = a.largest_free;
+        }
+        weighted += a.fragmentation * (float)mem_free_bytes(&a);
+    }
+    if (stats->live > peak) peak = stats->live;
+    g_tag_peak[tag] = peak;
+    stats->peak = peak;
+    size_t free_bytes = mem_free_bytes(stats);
+    stats->fragmentation = free_bytes ? weighted / (float)free_bytes : 0.0f;
+}
+
+int mem_stats_open(const char* path, mem_stats_format format) {
+    mem_stats_close();
+    g_stats_file = fopen(path, "w");
+    if (!g_stats_file) {
+        debug_log("failed to open memory stats file: %s\n", path);
+        return 0;
+    }
+    g_stats_format = format;
+    if (format == MEM_STATS_FORMAT_CSV) {
+        fprintf(g_stats_file,
+                "frame,scope,id,type,tag,backing,live,peak,capacity,largest_free,"
+                "fragmentation,frame_allocs,frame_frees\n");
+    }
+    return 1;
+}
+
+static void mem_stats_write(uint64_t frame, const char* scope, int32_t id,
+                            const char* type, const char* tag,
+                            const mem_stats* stats, int first) {
+    const char* backing = id < 0 ? "-" : g_backing_names[stats->backing];
+    if (g_stats_format == MEM_STATS_FORMAT_CSV) {
+        fprintf(g_stats_file, "%llu,%s,%d,%s,%s,%s,%zu,%zu,%zu,%zu,%.4f,%u,%u\n",
+                (unsigned long long)frame, scope, id, type, tag, backing,
+                stats->live, stats->peak, stats->capacity, stats->largest_free,
+                stats->fragmentation, stats->frame_allocs, stats->frame_frees);
+    } else {
+        fprintf(g_stats_file,
+                "%s{\"scope\":\"%s\",\"id\":%d,\"type\":\"%s\",\"tag\":\"%s\","
+                "\"backing\":\"%s\",\"live\":%zu,\"peak\":%zu,\"capacity\":%zu,"
+                "\"largest_free\":%zu,\"fragmentation\":%.4f,"
+                "\"frame_allocs\":%u,\"frame_frees\":%u}",
+                first ? "" : ",", scope, id, type, tag, backing, stats->live,
+                stats->peak, stats->capacity, stats->largest_free,
+                stats->fragmentation, stats->frame_allocs, stats->frame_frees);
+    }
+}
+
+void mem_stats_frame(uint64_t frame) {
+    if (g_stats_file) {
+        if (g_stats_format == MEM_STATS_FORMAT_JSON) {
+            fprintf(g_stats_file, "{\"frame\":%llu,\"stats\":[",
+                    (unsigned long long)frame);
+        }
+        int first = 1;
+        for (uint32_t i = 0; i < MEM_TAG_MAX_ENUM; i++) {
+            mem_stats stats;
+            mem_tag_stats(i, &stats);
+            mem_stats_write(frame, "tag", -1, "-", g_tag_names[i], &stats, first);
+            first = 0;
+        }
+        for (uint32_t i = 0; i < MEM_MAX_ALLOCATORS; i++) {
+            allocator* ator = g_allocators[i];
+            if (!ator) continue;
+            mem_stats stats;
+            mem_stats_get(ator, &stats);
+            mem_stats_write(frame, "allocator", i, g_type_names[ator->type],
+                            g_tag_names[ator->tag], &stats, 0);
+        }
+        if (g_stats_format == MEM_STATS_FORMAT_JSON) {
+            fprintf(g_stats_file, "]}\n");
+        }
+    }
+
+    for (uint32_t i = 0; i < MEM_MAX_ALLOCATORS; i++) {
+        if (!g_allocators[i]) continue;
+        g_frame_base_allocs[i] = g_allocators[i]->stats.frame_allocs;
+        g_frame_base_frees[i] = g_allocators[i]->stats.frame_frees;
+    }
+}
+
+void mem_stats_close(void) {
+    if (g_stats_file) {
+        fclose(g_stats_file);
+        g_stats_file = NULL;
+    }
+}
+
+//=========================================================
+//
+// trace
+//
+//=========================================================
+
+#define MEM_TRACE_BUFFER 4096  // records per write
+#define MEM_TRACE_NO_SLOT 0xff
+
+static allocfn* g_type_allocfns[ALLOCATOR_TYPE_MAX_ENUM] = {
+    &stack_allocfn,
+    &heap_allocfn,
+    &pool_allocfn,
+    &tlsf_allocfn,
+    &tcache_allocfn,
+};
+
+static FILE*                  g_trace_file;
+static uint64_t               g_trace_start;
+static atomic_flag            g_trace_lock = ATOMIC_FLAG_INIT;
+static mem_trace_record       g_trace_buffer[MEM_TRACE_BUFFER];
+static uint32_t               g_trace_count;
+static _Atomic uint32_t       g_trace_threads;
+static _Thread_local uint32_t t_trace_thread;  // 0 until the first record
+
+static void mem_trace_flush(void) {
+    fwrite(g_trace_buffer, sizeof(*g_trace_buffer), g_trace_count, g_trace_file);
+    g_trace_count = 0;
+}
+
+static void mem_trace_write(allocator* ator, mem_trace_op op, const void* ptr,
+                            size_t size, size_t align) {
+    if (!g_trace_file) return;
+    if (!t_trace_thread) {
+        t_trace_thread = atomic_fetch_add(&g_trace_threads, 1) + 1;
+    }
+    uint8_t slot = MEM_TRACE_NO_SLOT;
+    for (uint32_t i = 0; i < MEM_MAX_ALLOCATORS; i++) {
+        if (g_allocators[i] == ator) {
+            slot = (uint8_t)i;
+            break;
+        }
+    }
+    mem_trace_record record = {
+        .ptr = (uintptr_t)ptr,
+        .size = size,
+        .thread = (uint16_t)(t_trace_thread - 1),
+        .op = (uint8_t)op,
+        .allocator = slot,
+        .type = (uint8_t)ator->type,
+        .tag = (uint8_t)ator->tag,
+        .align_log2 = align ? (uint8_t)__builtin_ctzll(align) : 0,
+    };
+
+    while (atomic_flag_test_and_set_explicit(&g_trace_lock, memory_order_acquire)) {
+    }
+    // stamped under the lock so records stay in time order across threads
+    record.time_ns = os_time_nsec() - g_trace_start;
+    g_trace_buffer[g_trace_count++] = record;
+    if (g_trace_count == MEM_TRACE_BUFFER) {
+        mem_trace_flush();
+    }
+    atomic_flag_clear_explicit(&g_trace_lock, memory_order_release);
+}
+
+// forwards to the type's own vtable; swapped in while a trace is open so
+// untraced runs pay nothing
+static void* trace_alloc_impl(allocator* ator, size_t size, size_t align) {
+    void* ptr = g_type_allocfns[ator->type]->alloc(ator, size, align);
+    mem_trace_write(ator, MEM_TRACE_ALLOC, ptr, size, align);
+    return ptr;
+}
+
+static void trace_free_impl(allocator* ator, void* ptr) {
+    // recorded first, so a thread reusing the address is always traced after
+    mem_trace_write(ator, MEM_TRACE_FREE, ptr, 0, 0);
+    g_type_allocfns[ator->type]->free(ator, ptr);
+}
+
+static void trace_reset_impl(allocator* ator) {
+    mem_trace_write(ator, MEM_TRACE_RESET, NULL, 0, 0);
+    g_type_allocfns[ator->type]->reset(ator);
+}
+
+static void trace_get_info_impl(allocator* ator, size_t* used, size_t* total) {
+    g_type_allocfns[ator->type]->get_info(ator, used, total);
+}
+
+static size_t trace_largest_free_impl(allocator* ator) {
+    return g_type_allocfns[ator->type]->largest_free(ator);
+}
+
+static void trace_destroy_impl(allocator* ator) {
+    g_type_allocfns[ator->type]->destroy(ator);
+}
+
+static allocfn trace_allocfn = {
+    .alloc = trace_alloc_impl,
+    .free = trace_free_impl,
+    .reset = trace_reset_impl,
+    .get_info = trace_get_info_impl,
+    .largest_free = trace_largest_free_impl,
+    .destroy = trace_destroy_impl,
+};
+
+static void mem_trace_attach(allocator* ator) {
+    if (!g_trace_file) return;
+    ator->fn = &trace_allocfn;
+    mem_trace_write(ator, MEM_TRACE_CREATE, NULL, ator->stats.capacity, 0);
+}
+
+int mem_trace_open(const char* path) {
+    mem_trace_close();
+    FILE* file = fopen(path, "wb");
+    if (!file) {
+        debug_log("failed to open memory trace file: %s\n", path);
+        return 0;
+    }
+    mem_trace_header header = {
+        .magic = MEM_TRACE_MAGIC,
+        .version = MEM_TRACE_VERSION,
+        .record_size = sizeof(mem_trace_record),
+    };
+    fwrite(&header, sizeof(header), 1, file);
+    g_trace_start = os_time_nsec();
+    g_trace_count = 0;
+    g_trace_file = file;
+    for (uint32_t i = 0; i < MEM_MAX_ALLOCATORS; i++) {
+        if (g_allocators[i]) mem_trace_attach(g_allocators[i]);
+    }
+    return 1;
+}
+
+void mem_trace_close(void) {
+    if (!g_trace_file) return;
+    for (uint32_t i = 0; i < MEM_MAX_ALLOCATORS; i++) {
+        allocator* ator = g_allocators[i];
+        if (ator) ator->fn = g_type_allocfns[ator->type];
+    }
+    mem_trace_flush();
+    fclose(g_trace_file);
+    g_trace_file = NULL;
 }
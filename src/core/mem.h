@@ -3,22 +3,78 @@
 #include <stddef.h>
 #include <stdint.h>
 
-#define mkilo(bytes) (bytes) * 1024 
-#define mmega(bytes) (bytes) * 1024 * 1024
-#define mgiga(bytes) (bytes) * 1024 * 1024 * 1024
+#define mkilo(bytes) ((bytes) * 1024)
+#define mmega(bytes) ((bytes) * 1024 * 1024)
+#define mgiga(bytes) ((size_t)(bytes) * 1024 * 1024 * 1024)
 
 typedef enum  {
     ALLOCATOR_TYPE_STACK,
     ALLOCATOR_TYPE_HEAP,
+    ALLOCATOR_TYPE_POOL,  // size-class free lists, blocks up to POOL_MAX_BLOCK
+    ALLOCATOR_TYPE_TLSF,  // two-level segregated fit, O(1) general purpose heap
+    ALLOCATOR_TYPE_TCACHE,  // thread-safe, per-thread caches of pool classes
     ALLOCATOR_TYPE_MAX_ENUM,
 } allocator_type;
 
+#define POOL_MIN_BLOCK 16
+#define POOL_MAX_BLOCK 2048
+#define POOL_SPAN_SIZE mkilo(64)
+
+// threads that may use one thread cache allocator. slots are claimed on first
+// use and not given back when a thread exits, so it is meant for long-lived
+// workers. the large block heap takes 1 / TCACHE_LARGE_DIV of its size
+#define TCACHE_MAX_THREADS 64
+#define TCACHE_LARGE_DIV 4
+
 typedef enum {
     MEM_TAG_CORE = 0,
     MEM_TAG_RENDERER,
     MEM_TAG_MAX_ENUM
 } mem_tag;
 
+typedef enum {
+    ALLOCATOR_FLAG_NONE = 0,
+    // stack only: reserve `size` bytes of address space and commit pages on
+    // demand as the cursor advances
+    ALLOCATOR_FLAG_VIRTUAL = 0x01,
+    // with ALLOCATOR_FLAG_VIRTUAL: give committed pages back to the os on reset
+    ALLOCATOR_FLAG_DECOMMIT = 0x02,
+    // back the arena with 2MB pages: explicit hugetlb pages when the system
+    // has them reserved, transparent huge pages otherwise. aget_backing says
+    // which one was obtained
+    ALLOCATOR_FLAG_HUGE_PAGES = 0x04,
+} allocator_flags;
+
+typedef enum {
+    MEM_BACKING_SMALL_PAGES = 0,
+    MEM_BACKING_HUGE_EXPLICIT,     // MAP_HUGETLB, guaranteed 2MB pages
+    MEM_BACKING_HUGE_TRANSPARENT,  // MADV_HUGEPAGE, promoted by the kernel
+} mem_backing;
+
+#define MEM_MAX_ALLOCATORS 64
+
+typedef enum {
+    MEM_STATS_FORMAT_CSV = 0,
+    MEM_STATS_FORMAT_JSON,  // one json object per line
+} mem_stats_format;
+
+// an allocator's are kept up to date by every alloc/free, a tag's are summed
+// over its allocators when read
+typedef struct {
+    size_t   live;          // bytes handed out, including block overhead
+    size_t   peak;          // high-water mark of live
+    size_t   capacity;
+    size_t   largest_free;  // only filled in by mem_stats_get/mem_tag_stats
+    // share of free bytes a large request can't use, same as above: outside
+    // the largest block, or for pool and tcache, parked in size class lists.
+    // a tag's is its allocators' weighted by their free bytes
+    float    fragmentation;
+    mem_backing backing;    // mem_stats_get only
+    uint32_t frame_allocs;
+    uint32_t frame_frees;
+    uint64_t total_allocs;
+} mem_stats;
+
 typedef struct allocator allocator;
 
 typedef struct {
@@ -26,6 +82,7 @@ typedef struct {
     void (*free)(allocator* allocator, void* ptr);
     void (*reset)(allocator* allocator);
     void (*get_info)(allocator* allocator, size_t* used, size_t* total);
+    size_t (*largest_free)(allocator* allocator);
     void (*destroy)(allocator* allocator);
 } allocfn;
 
@@ -33,14 +90,87 @@ struct allocator {
     allocfn*       fn;
     allocator_type type;
     mem_tag        tag;
+    uint32_t       flags;
+    mem_backing    backing;
     void*          data;
+    mem_stats      stats;
 };
 
+// checkpoint into a stack allocator; markers must be released innermost first
+typedef struct {
+    size_t   cursor;
+    uint32_t depth;
+} amarker;
+
+// scratch scope: everything allocated between begin and end is released at end
+typedef struct {
+    allocator* ator;
+    amarker    marker;
+} atemp;
+
 #define aalloc(ator, size) ((ator)->fn->alloc((ator), (size), 8))
-#define aalloc_algn(ator, size, align) ((ator)->fn->alloc((ator), (size), (align))))
+#define aalloc_algn(ator, size, align) ((ator)->fn->alloc((ator), (size), (align)))
+#define aalloc_array(ator, type, count) \
+    ((type*)aalloc_algn((ator), sizeof(type) * (count), _Alignof(type)))
 #define afree(ator, ptr) ((ator)->fn->free((ator), (ptr)))
 #define areset(ator, size) ((ator)->fn->reset((ator)))
 #define aget_info(ator, used, total) ((ator)->fn->get_info((ator), (used), (total)))
-#define adestroy(ator) ((ator)->fn->destroy((ator)))
+#define aget_backing(ator) ((ator)->backing)
+#define adestroy(ator) (allocator_destroy((ator)))
 
 allocator* allocator_create(allocator_type type, mem_tag tag, size_t size);
+allocator* allocator_create_ex(allocator_type type, mem_tag tag, size_t size,
+                               uint32_t flags);
+void       allocator_destroy(allocator* ator);
+
+amarker allocator_mark(allocator* ator);
+void    allocator_rewind(allocator* ator, amarker marker);
+
+atemp atemp_begin(allocator* ator);
+void  atemp_end(atemp temp);
+
+void mem_stats_get(allocator* ator, mem_stats* stats);
+void mem_tag_stats(mem_tag tag, mem_stats* stats);
+
+// per-frame dump of every tag and live allocator, for sizing arenas offline
+int  mem_stats_open(const char* path, mem_stats_format format);
+void mem_stats_frame(uint64_t frame);
+void mem_stats_close(void);
+
+// binary trace of every allocator call, replayed offline by bench/memreplay.
+// open and close it while no other thread is using an allocator
+#define MEM_TRACE_MAGIC 0x5254304d  // "M0TR"
+#define MEM_TRACE_VERSION 1
+
+typedef enum {
+    MEM_TRACE_CREATE = 0,  // size: capacity
+    MEM_TRACE_DESTROY,
+    MEM_TRACE_ALLOC,       // ptr: 0 when the allocation failed
+    MEM_TRACE_FREE,
+    MEM_TRACE_RESET,
+    MEM_TRACE_MARK,        // ptr: stack address the marker points at
+    MEM_TRACE_REWIND,      // ptr: same as the matching mark
+} mem_trace_op;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t record_size;
+    uint32_t reserved;
+} mem_trace_header;
+
+typedef struct {
+    uint64_t time_ns;  // since mem_trace_open
+    uint64_t ptr;
+    uint64_t size;
+    uint16_t thread;     // in order of first traced call
+    uint8_t  op;
+    uint8_t  allocator;  // registry slot, unique among live allocators
+    uint8_t  type;
+    uint8_t  tag;
+    uint8_t  align_log2;
+    uint8_t  reserved;
+} mem_trace_record;
+
+int  mem_trace_open(const char* path);
+void mem_trace_close(void);
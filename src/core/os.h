@@ -43,8 +43,32 @@ dir_iter*   dir_open(const char* path);
 const char* dir_read(dir_iter* iter);
 void        dir_close(dir_iter* iter);
 
+// virtual memory: reserve address space, then commit/decommit page ranges
+void*  os_mem_reserve(size_t size);
+int    os_mem_commit(void* ptr, size_t size);
+int    os_mem_decommit(void* ptr, size_t size);
+void   os_mem_release(void* ptr, size_t size);
+size_t os_page_size(void);
+
+// 2MB pages for large arenas. explicit pages come from the hugetlb pool and
+// are guaranteed; transparent ones are only promoted by the kernel when it can
+#define OS_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+typedef enum {
+    OS_PAGES_SMALL = 0,
+    OS_PAGES_HUGE_EXPLICIT,
+    OS_PAGES_HUGE_TRANSPARENT,
+} os_pages;
+
+// both round size up to OS_HUGE_PAGE_SIZE; the mapping is huge page aligned
+// and zeroed, *pages says what backs it
+void*    os_mem_map_huge(size_t size, os_pages* pages);
+void     os_mem_unmap_huge(void* ptr, size_t size);
+os_pages os_mem_advise_huge(void* ptr, size_t size);  // for reserved ranges
+
 uint64_t os_time_msec(void);
 uint64_t os_time_usec(void);
+uint64_t os_time_nsec(void);  // monotonic
 void     os_sleep(uint64_t ms);
 char*    os_getenv(const char* name);
 int      os_setenv(const char* name, const char* value);
@@ -12,8 +12,10 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/time.h>
+#include <time.h>
 #include <unistd.h>
 
 #define ONE_THOUSAND 1000
@@ -231,6 +233,75 @@ void dir_close(dir_iter* iter) {
     free(iter);
 }
 
+void* os_mem_reserve(size_t size) {
+    void* ptr = mmap(NULL, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+                     -1, 0);
+    return ptr == MAP_FAILED ? NULL : ptr;
+}
+
+int os_mem_commit(void* ptr, size_t size) {
+    return mprotect(ptr, size, PROT_READ | PROT_WRITE) == 0;
+}
+
+int os_mem_decommit(void* ptr, size_t size) {
+    // drop the physical pages first so they no longer count towards rss
+    if (madvise(ptr, size, MADV_DONTNEED) != 0) return 0;
+    return mprotect(ptr, size, PROT_NONE) == 0;
+}
+
+void os_mem_release(void* ptr, size_t size) { munmap(ptr, size); }
+
+size_t os_page_size(void) { return (size_t)sysconf(_SC_PAGESIZE); }
+
+#define OS_HUGE_ROUND(size) \
+    (((size) + OS_HUGE_PAGE_SIZE - 1) & ~(size_t)(OS_HUGE_PAGE_SIZE - 1))
+
+// madvise succeeds with thp set to never, it just does nothing
+static int thp_enabled(void) {
+    FILE* file = fopen("/sys/kernel/mm/transparent_hugepage/enabled", "r");
+    if (!file) return 0;
+    char buffer[64] = {0};
+    size_t read = fread(buffer, 1, sizeof(buffer) - 1, file);
+    fclose(file);
+    return read && !strstr(buffer, "[never]");
+}
+
+os_pages os_mem_advise_huge(void* ptr, size_t size) {
+#ifdef MADV_HUGEPAGE
+    if (madvise(ptr, size, MADV_HUGEPAGE) == 0 && thp_enabled()) {
+        return OS_PAGES_HUGE_TRANSPARENT;
+    }
+#endif
+    return OS_PAGES_SMALL;
+}
+
+void* os_mem_map_huge(size_t size, os_pages* pages) {
+    size = OS_HUGE_ROUND(size);
+    int   prot = PROT_READ | PROT_WRITE;
+    int   flags = MAP_PRIVATE | MAP_ANONYMOUS;
+    void* ptr;
+#ifdef MAP_HUGETLB
+    // fails unless the admin reserved enough pages in vm.nr_hugepages
+    ptr = mmap(NULL, size, prot, flags | MAP_HUGETLB, -1, 0);
+    if (ptr != MAP_FAILED) {
+        *pages = OS_PAGES_HUGE_EXPLICIT;
+        return ptr;
+    }
+#endif
+    // over-map and trim so the range starts on a huge page boundary, thp can
+    // only back aligned 2MB ranges
+    ptr = mmap(NULL, size + OS_HUGE_PAGE_SIZE, prot, flags, -1, 0);
+    if (ptr == MAP_FAILED) return NULL;
+    uintptr_t start = (uintptr_t)ptr;
+    uintptr_t aligned = OS_HUGE_ROUND(start);
+    if (aligned > start) munmap(ptr, aligned - start);
+    munmap((void*)(aligned + size), start + OS_HUGE_PAGE_SIZE - aligned);
+    *pages = os_mem_advise_huge((void*)aligned, size);
+    return (void*)aligned;
+}
+
+void os_mem_unmap_huge(void* ptr, size_t size) { munmap(ptr, OS_HUGE_ROUND(size)); }
+
 char* os_getenv(const char* name) { return getenv(name); };
 
 int env_set(const char* name, const char* value) {
@@ -245,6 +316,12 @@ uint64_t os_time_usec(void) {
     return (uint64_t)tv.tv_sec * ONE_MILLION + (uint64_t)tv.tv_usec;
 }
 
+uint64_t os_time_nsec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * ONE_THOUSAND * ONE_MILLION + (uint64_t)ts.tv_nsec;
+}
+
 void os_sleep(uint64_t ms) { usleep(ms * 1000); }
 
 int os_getcwd(char* buffer, size_t size) { return getcwd(buffer, size) != NULL; }
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "os.h"
+
+// threads, futex based locks and cpu topology. the locks are a word or two of
+// plain memory, so they embed anywhere, need no destroy and initialise to
+// zero; waiting threads sleep in the kernel and the uncontended paths never
+// leave user space
+
+// atomics spelled the way the rest of the code reads, with the ordering in
+// the name. anything subtler than these goes to stdatomic directly
+typedef _Atomic uint32_t atom_u32;
+typedef _Atomic int32_t  atom_i32;
+typedef _Atomic uint64_t atom_u64;
+typedef _Atomic int64_t  atom_i64;
+typedef _Atomic(void*)   atom_ptr;
+
+#define atom_load_relaxed(p) atomic_load_explicit((p), memory_order_relaxed)
+#define atom_load_acquire(p) atomic_load_explicit((p), memory_order_acquire)
+#define atom_store_relaxed(p, v) \
+    atomic_store_explicit((p), (v), memory_order_relaxed)
+#define atom_store_release(p, v) \
+    atomic_store_explicit((p), (v), memory_order_release)
+#define atom_add_relaxed(p, v) \
+    atomic_fetch_add_explicit((p), (v), memory_order_relaxed)
+#define atom_add_acq_rel(p, v) \
+    atomic_fetch_add_explicit((p), (v), memory_order_acq_rel)
+#define atom_sub_relaxed(p, v) \
+    atomic_fetch_sub_explicit((p), (v), memory_order_relaxed)
+#define atom_sub_acq_rel(p, v) \
+    atomic_fetch_sub_explicit((p), (v), memory_order_acq_rel)
+#define atom_swap_acquire(p, v) \
+    atomic_exchange_explicit((p), (v), memory_order_acquire)
+#define atom_swap_acq_rel(p, v) \
+    atomic_exchange_explicit((p), (v), memory_order_acq_rel)
+// expected is a pointer and holds the current value on failure
+#define atom_cas_acq_rel(p, expected, v)                                    \
+    atomic_compare_exchange_strong_explicit((p), (expected), (v),          \
+                                            memory_order_acq_rel,          \
+                                            memory_order_relaxed)
+#define atom_cas_weak_acq_rel(p, expected, v)                               \
+    atomic_compare_exchange_weak_explicit((p), (expected), (v),            \
+                                          memory_order_acq_rel,            \
+                                          memory_order_relaxed)
+#define atom_fence_seq_cst() atomic_thread_fence(memory_order_seq_cst)
+
+// spin loop hint: lets the sibling hyperthread run and saves power
+#if defined(__x86_64__) || defined(__i386__)
+#define os_cpu_pause() __builtin_ia32_pause()
+#elif defined(__aarch64__)
+#define os_cpu_pause() __asm__ __volatile__("yield")
+#else
+#define os_cpu_pause() ((void)0)
+#endif
+
+#define OS_THREAD_NAME_MAX 16  // linux limit, terminator included
+#define OS_MAX_CPUS 256
+#define OS_WAIT_FOREVER UINT64_MAX
+
+typedef void* (*os_thread_fn)(void* arg);
+
+typedef struct {
+    uintptr_t handle;
+} os_thread;
+
+// name may be NULL; longer names are cut to OS_THREAD_NAME_MAX - 1. 0 on
+// success
+int      os_thread_create(os_thread* thread, os_thread_fn fn, void* arg,
+                          const char* name);
+void*    os_thread_join(os_thread* thread);
+void     os_thread_set_name(const char* name);  // calling thread
+uint32_t os_thread_id(void);                    // kernel thread id
+void     os_thread_yield(void);
+// runs the calling thread on cpu only, an os cpu number as in
+// os_cpu_info.cpus. 0 on success
+int      os_thread_pin(uint32_t cpu);
+int      os_thread_unpin(void);
+
+// sleeps while *addr == expected, until woken, timed out or spuriously. 0
+// when woken or the value differed, -1 on timeout
+int  os_futex_wait(atom_u32* addr, uint32_t expected, uint64_t timeout_ns);
+void os_futex_wake(atom_u32* addr, uint32_t count);
+void os_futex_wake_all(atom_u32* addr);
+
+// 0 unlocked, 1 locked, 2 locked with sleepers; after drepper, "futexes are
+// tricky". spins briefly before sleeping, not recursive
+typedef struct {
+    atom_u32 state;
+} os_mutex;
+
+void os_mutex_lock(os_mutex* mutex);
+int  os_mutex_trylock(os_mutex* mutex);  // 1 when taken
+void os_mutex_unlock(os_mutex* mutex);
+
+// manual reset: set releases every waiter and stays set until reset
+typedef struct {
+    atom_u32 state;
+} os_event;
+
+void os_event_set(os_event* event);
+void os_event_reset(os_event* event);
+int  os_event_is_set(const os_event* event);
+// 0 once set, -1 on timeout
+int  os_event_wait(os_event* event, uint64_t timeout_ns);
+
+// counting semaphore
+typedef struct {
+    atom_u32 count;
+    atom_u32 sleepers;
+} os_sema;
+
+void os_sema_post(os_sema* sema, uint32_t count);
+void os_sema_wait(os_sema* sema);
+int  os_sema_trywait(os_sema* sema);  // 1 when taken
+
+typedef struct {
+    uint32_t size;  // bytes
+    uint32_t line;
+    uint32_t shared;  // logical cpus sharing one instance
+} os_cache;
+
+// online logical cpus grouped by physical core, from sysfs. counts fall back
+// to one core per logical cpu when sysfs is unavailable
+typedef struct {
+    uint32_t logical_count;
+    uint32_t core_count;
+    uint32_t package_count;
+    uint32_t cpus[OS_MAX_CPUS];  // os cpu number of each logical cpu
+    uint16_t core[OS_MAX_CPUS];  // 0 .. core_count - 1, per logical cpu
+    uint8_t  smt[OS_MAX_CPUS];   // 0 for the first thread of its core
+    os_cache l1d;
+    os_cache l2;
+    os_cache l3;
+} os_cpu_info;
+
+int os_cpu_topology(os_cpu_info* info);  // 0 on success
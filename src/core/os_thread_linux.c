@@ -0,0 +1,323 @@
+#include "os_thread.h"
+
+#ifdef OS_LINUX
+
+#include <errno.h>
+#include <linux/futex.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#define OS_MUTEX_SPIN 100  // tries before a contended lock sleeps
+#define OS_MASK_WORDS (OS_MAX_CPUS / 64)
+
+typedef struct {
+    os_thread_fn fn;
+    void*        arg;
+    char         name[OS_THREAD_NAME_MAX];
+} os_thread_start;
+
+// names the thread from inside, which needs nothing beyond prctl
+static void* os_thread_main(void* data) {
+    os_thread_start start = *(os_thread_start*)data;
+    free(data);
+    if (start.name[0]) os_thread_set_name(start.name);
+    return start.fn(start.arg);
+}
+
+int os_thread_create(os_thread* thread, os_thread_fn fn, void* arg,
+                     const char* name) {
+    os_thread_start* start = malloc(sizeof(os_thread_start));
+    if (!start) return -1;
+    start->fn = fn;
+    start->arg = arg;
+    start->name[0] = '\0';
+    if (name) snprintf(start->name, sizeof(start->name), "%s", name);
+
+    pthread_t handle;
+    if (pthread_create(&handle, NULL, os_thread_main, start) != 0) {
+        free(start);
+        return -1;
+    }
+    thread->handle = (uintptr_t)handle;
+    return 0;
+}
+
+void* os_thread_join(os_thread* thread) {
+    void* result = NULL;
+    pthread_join((pthread_t)thread->handle, &result);
+    thread->handle = 0;
+    return result;
+}
+
+void os_thread_set_name(const char* name) {
+    char buffer[OS_THREAD_NAME_MAX];
+    snprintf(buffer, sizeof(buffer), "%s", name);
+    prctl(PR_SET_NAME, buffer, 0, 0, 0);
+}
+
+uint32_t os_thread_id(void) { return (uint32_t)syscall(SYS_gettid); }
+
+void os_thread_yield(void) { sched_yield(); }
+
+static int set_affinity(const uint64_t* mask) {
+    return syscall(SYS_sched_setaffinity, 0, sizeof(uint64_t) * OS_MASK_WORDS,
+                   mask) == 0 ? 0 : -1;
+}
+
+int os_thread_pin(uint32_t cpu) {
+    if (cpu >= OS_MAX_CPUS) return -1;
+    uint64_t mask[OS_MASK_WORDS] = {0};
+    mask[cpu / 64] = 1ull << (cpu % 64);
+    return set_affinity(mask);
+}
+
+// every cpu; the kernel drops the ones that aren't there
+int os_thread_unpin(void) {
+    uint64_t mask[OS_MASK_WORDS];
+    memset(mask, 0xff, sizeof(mask));
+    return set_affinity(mask);
+}
+
+int os_futex_wait(atom_u32* addr, uint32_t expected, uint64_t timeout_ns) {
+    struct timespec  timeout;
+    struct timespec* timeout_ptr = NULL;
+    if (timeout_ns != OS_WAIT_FOREVER) {
+        timeout.tv_sec = (time_t)(timeout_ns / 1000000000ull);
+        timeout.tv_nsec = (long)(timeout_ns % 1000000000ull);
+        timeout_ptr = &timeout;
+    }
+    long result = syscall(SYS_futex, (uint32_t*)addr, FUTEX_WAIT_PRIVATE,
+                          expected, timeout_ptr, NULL, 0);
+    return result != 0 && errno == ETIMEDOUT ? -1 : 0;
+}
+
+void os_futex_wake(atom_u32* addr, uint32_t count) {
+    syscall(SYS_futex, (uint32_t*)addr, FUTEX_WAKE_PRIVATE, count, NULL, NULL, 0);
+}
+
+void os_futex_wake_all(atom_u32* addr) { os_futex_wake(addr, INT32_MAX); }
+
+// the remaining wait after a wake that wasn't ours, OS_WAIT_FOREVER as is
+static uint64_t remaining(uint64_t deadline, uint64_t timeout_ns) {
+    if (timeout_ns == OS_WAIT_FOREVER) return OS_WAIT_FOREVER;
+    uint64_t now = os_time_nsec();
+    return now >= deadline ? 0 : deadline - now;
+}
+
+void os_mutex_lock(os_mutex* mutex) {
+    uint32_t c = 0;
+    if (atom_cas_acq_rel(&mutex->state, &c, 1)) return;
+    for (uint32_t i = 0; i < OS_MUTEX_SPIN && c == 1; i++) {
+        os_cpu_pause();
+        c = atom_load_relaxed(&mutex->state);
+        if (c == 0) {
+            if (atom_cas_acq_rel(&mutex->state, &c, 1)) return;
+        }
+    }
+    // from here on the lock is marked contended, so whoever holds it wakes us
+    if (c != 2) c = atom_swap_acquire(&mutex->state, 2);
+    while (c != 0) {
+        os_futex_wait(&mutex->state, 2, OS_WAIT_FOREVER);
+        c = atom_swap_acquire(&mutex->state, 2);
+    }
+}
+
+int os_mutex_trylock(os_mutex* mutex) {
+    uint32_t c = 0;
+    return atom_cas_acq_rel(&mutex->state, &c, 1);
+}
+
+void os_mutex_unlock(os_mutex* mutex) {
+    if (atom_sub_acq_rel(&mutex->state, 1) != 1) {
+        atom_store_release(&mutex->state, 0);
+        os_futex_wake(&mutex->state, 1);
+    }
+}
+
+// bit 0 set, bit 1 someone is asleep on it
+#define OS_EVENT_SET 1u
+#define OS_EVENT_SLEEPERS 2u
+
+void os_event_set(os_event* event) {
+    if (atom_swap_acq_rel(&event->state, OS_EVENT_SET) & OS_EVENT_SLEEPERS) {
+        os_futex_wake_all(&event->state);
+    }
+}
+
+void os_event_reset(os_event* event) {
+    uint32_t set = OS_EVENT_SET;
+    atom_cas_acq_rel(&event->state, &set, 0);
+}
+
+int os_event_is_set(const os_event* event) {
+    return (atom_load_acquire(&event->state) & OS_EVENT_SET) != 0;
+}
+
+int os_event_wait(os_event* event, uint64_t timeout_ns) {
+    uint64_t deadline = timeout_ns == OS_WAIT_FOREVER ? 0
+                                                      : os_time_nsec() + timeout_ns;
+    for (;;) {
+        uint32_t s = atom_load_acquire(&event->state);
+        if (s & OS_EVENT_SET) return 0;
+        if (!(s & OS_EVENT_SLEEPERS) &&
+            !atom_cas_acq_rel(&event->state, &s, s | OS_EVENT_SLEEPERS)) {
+            continue;
+        }
+        uint64_t wait = remaining(deadline, timeout_ns);
+        if (wait == 0) return -1;
+        os_futex_wait(&event->state, OS_EVENT_SLEEPERS, wait);
+    }
+}
+
+int os_sema_trywait(os_sema* sema) {
+    uint32_t c = atom_load_relaxed(&sema->count);
+    while (c > 0) {
+        if (atom_cas_weak_acq_rel(&sema->count, &c, c - 1)) return 1;
+    }
+    return 0;
+}
+
+// the sleeper count is bumped before the futex rechecks count, and post
+// reads it after adding, so one of the two always sees the other
+void os_sema_wait(os_sema* sema) {
+    while (!os_sema_trywait(sema)) {
+        atomic_fetch_add(&sema->sleepers, 1);
+        os_futex_wait(&sema->count, 0, OS_WAIT_FOREVER);
+        atomic_fetch_sub(&sema->sleepers, 1);
+    }
+}
+
+void os_sema_post(os_sema* sema, uint32_t count) {
+    atomic_fetch_add(&sema->count, count);
+    if (atomic_load(&sema->sleepers)) os_futex_wake(&sema->count, count);
+}
+
+// sysfs files hold a single line: a number, a size like "32K" or a cpu list
+// like "0-3,8-11"
+static int read_line(const char* path, char* buffer, size_t size) {
+    FILE* file = fopen(path, "r");
+    if (!file) return 0;
+    int ok = fgets(buffer, (int)size, file) != NULL;
+    fclose(file);
+    return ok;
+}
+
+static int read_u32(const char* path, uint32_t* value) {
+    char buffer[64];
+    if (!read_line(path, buffer, sizeof(buffer))) return 0;
+    char* end;
+    unsigned long v = strtoul(buffer, &end, 10);
+    if (end == buffer) return 0;
+    if (*end == 'K') v *= 1024;
+    if (*end == 'M') v *= 1024 * 1024;
+    *value = (uint32_t)v;
+    return 1;
+}
+
+// fills cpus with every cpu in a list, up to max, and returns how many
+static uint32_t parse_cpu_list(const char* list, uint32_t* cpus, uint32_t max) {
+    uint32_t count = 0;
+    while (*list >= '0' && *list <= '9') {
+        char*    end;
+        uint32_t first = (uint32_t)strtoul(list, &end, 10);
+        uint32_t last = first;
+        if (*end == '-') last = (uint32_t)strtoul(end + 1, &end, 10);
+        for (uint32_t c = first; c <= last; c++) {
+            if (cpus && count < max) cpus[count] = c;
+            count++;
+        }
+        list = *end == ',' ? end + 1 : end;
+    }
+    return count;
+}
+
+static void read_caches(os_cpu_info* info, uint32_t cpu) {
+    for (uint32_t i = 0;; i++) {
+        char path[OS_MAX_PATH];
+        char type[32];
+        char shared[256];
+        uint32_t level;
+        snprintf(path, sizeof(path),
+                 "/sys/devices/system/cpu/cpu%u/cache/index%u/level", cpu, i);
+        if (!read_u32(path, &level)) break;
+        snprintf(path, sizeof(path),
+                 "/sys/devices/system/cpu/cpu%u/cache/index%u/type", cpu, i);
+        if (!read_line(path, type, sizeof(type)) || type[0] == 'I') continue;
+
+        os_cache* cache = level == 1 ? &info->l1d
+                          : level == 2 ? &info->l2
+                          : level == 3 ? &info->l3
+                                       : NULL;
+        if (!cache) continue;
+        snprintf(path, sizeof(path),
+                 "/sys/devices/system/cpu/cpu%u/cache/index%u/size", cpu, i);
+        read_u32(path, &cache->size);
+        snprintf(path, sizeof(path),
+                 "/sys/devices/system/cpu/cpu%u/cache/index%u/coherency_line_size",
+                 cpu, i);
+        read_u32(path, &cache->line);
+        snprintf(path, sizeof(path),
+                 "/sys/devices/system/cpu/cpu%u/cache/index%u/shared_cpu_list", cpu,
+                 i);
+        if (read_line(path, shared, sizeof(shared))) {
+            cache->shared = parse_cpu_list(shared, NULL, 0);
+        }
+    }
+}
+
+int os_cpu_topology(os_cpu_info* info) {
+    memset(info, 0, sizeof(*info));
+    char list[1024];
+    if (read_line("/sys/devices/system/cpu/online", list, sizeof(list))) {
+        info->logical_count = parse_cpu_list(list, info->cpus, OS_MAX_CPUS);
+    }
+    if (info->logical_count == 0) {
+        long n = sysconf(_SC_NPROCESSORS_ONLN);
+        info->logical_count = n > 0 ? (uint32_t)n : 1;
+        for (uint32_t i = 0; i < info->logical_count && i < OS_MAX_CPUS; i++) {
+            info->cpus[i] = i;
+        }
+    }
+    if (info->logical_count > OS_MAX_CPUS) info->logical_count = OS_MAX_CPUS;
+
+    // a core is a (package, core id) pair; core ids repeat across packages
+    uint32_t core_keys[OS_MAX_CPUS];
+    uint8_t  core_threads[OS_MAX_CPUS] = {0};
+    uint32_t packages[OS_MAX_CPUS];
+    for (uint32_t i = 0; i < info->logical_count; i++) {
+        char     path[OS_MAX_PATH];
+        uint32_t core_id = i;
+        uint32_t package = 0;
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/topology/core_id",
+                 info->cpus[i]);
+        read_u32(path, &core_id);
+        snprintf(path, sizeof(path),
+                 "/sys/devices/system/cpu/cpu%u/topology/physical_package_id",
+                 info->cpus[i]);
+        read_u32(path, &package);
+
+        uint32_t p = 0;
+        while (p < info->package_count && packages[p] != package) p++;
+        if (p == info->package_count) packages[info->package_count++] = package;
+
+        uint32_t key = package << 16 | (core_id & 0xffff);
+        uint32_t c = 0;
+        while (c < info->core_count && core_keys[c] != key) c++;
+        if (c == info->core_count) core_keys[info->core_count++] = key;
+        info->core[i] = (uint16_t)c;
+        info->smt[i] = core_threads[c]++;
+    }
+
+    read_caches(info, info->cpus[0]);
+    if (info->l1d.line == 0) info->l1d.line = 64;
+    return 0;
+}
+
+#endif  // OS_LINUX
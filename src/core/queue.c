@@ -0,0 +1,144 @@
+#include "queue.h"
+
+#include <string.h>
+
+#include "../base.h"
+
+static uint64_t round_pow2(uint32_t n) {
+    uint64_t size = 2;
+    while (size < n) size <<= 1;
+    return size;
+}
+
+int spsc_init(spsc_queue* q, allocator* ator, uint32_t capacity, uint32_t stride) {
+    memset(q, 0, sizeof(*q));
+    uint64_t size = round_pow2(capacity);
+    q->items = aalloc_algn(ator, size * stride, QUEUE_LINE);
+    if (!q->items) {
+        debug_log("spsc_init: out of memory for %u items\n", capacity);
+        return -1;
+    }
+    q->mask = size - 1;
+    q->stride = stride;
+    q->ator = ator;
+    return 0;
+}
+
+void spsc_destroy(spsc_queue* q) {
+    if (q->items) afree(q->ator, q->items);
+    q->items = NULL;
+}
+
+int spsc_push(spsc_queue* q, const void* item) {
+    uint64_t tail = atom_load_relaxed(&q->tail);
+    if (tail - q->head_cache > q->mask) {
+        q->head_cache = atom_load_acquire(&q->head);
+        if (tail - q->head_cache > q->mask) return 0;
+    }
+    memcpy(q->items + (tail & q->mask) * q->stride, item, q->stride);
+    atom_store_release(&q->tail, tail + 1);
+    return 1;
+}
+
+int spsc_pop(spsc_queue* q, void* item) {
+    uint64_t head = atom_load_relaxed(&q->head);
+    if (head == q->tail_cache) {
+        q->tail_cache = atom_load_acquire(&q->tail);
+        if (head == q->tail_cache) return 0;
+    }
+    memcpy(item, q->items + (head & q->mask) * q->stride, q->stride);
+    atom_store_release(&q->head, head + 1);
+    return 1;
+}
+
+uint32_t spsc_count(spsc_queue* q) {
+    uint64_t head = atom_load_acquire(&q->head);
+    return (uint32_t)(atom_load_acquire(&q->tail) - head);
+}
+
+// a cell is free for the push at position pos when its sequence is pos, and
+// holds that push's item for the pop at pos when it is pos + 1. the pop hands
+// it to the push one lap later by setting pos + size
+typedef struct {
+    atom_u64 sequence;
+    uint8_t  item[];
+} mpmc_cell;
+
+#define mpmc_cell_at(q, pos) \
+    ((mpmc_cell*)((q)->cells + ((pos) & (q)->mask) * (q)->cell_size))
+
+int mpmc_init(mpmc_queue* q, allocator* ator, uint32_t capacity, uint32_t stride) {
+    memset(q, 0, sizeof(*q));
+    uint64_t size = round_pow2(capacity);
+    q->cell_size = (uint32_t)((sizeof(mpmc_cell) + stride + 7) & ~(size_t)7);
+    q->cells = aalloc_algn(ator, size * q->cell_size, QUEUE_LINE);
+    if (!q->cells) {
+        debug_log("mpmc_init: out of memory for %u items\n", capacity);
+        return -1;
+    }
+    q->mask = size - 1;
+    q->stride = stride;
+    q->ator = ator;
+    for (uint64_t i = 0; i < size; i++) {
+        atom_store_relaxed(&mpmc_cell_at(q, i)->sequence, i);
+    }
+    return 0;
+}
+
+void mpmc_destroy(mpmc_queue* q) {
+    if (q->cells) afree(q->ator, q->cells);
+    q->cells = NULL;
+}
+
+int mpmc_push(mpmc_queue* q, const void* item) {
+    uint64_t   pos = atom_load_relaxed(&q->tail);
+    mpmc_cell* cell;
+    for (;;) {
+        cell = mpmc_cell_at(q, pos);
+        int64_t diff = (int64_t)(atom_load_acquire(&cell->sequence) - pos);
+        if (diff == 0) {
+            // on failure pos is reloaded with the winner's tail
+            if (atomic_compare_exchange_weak_explicit(&q->tail, &pos, pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return 0;  // a lap behind: the pop for this cell hasn't happened
+        } else {
+            pos = atom_load_relaxed(&q->tail);
+        }
+    }
+    memcpy(cell->item, item, q->stride);
+    atom_store_release(&cell->sequence, pos + 1);
+    return 1;
+}
+
+int mpmc_pop(mpmc_queue* q, void* item) {
+    uint64_t   pos = atom_load_relaxed(&q->head);
+    mpmc_cell* cell;
+    for (;;) {
+        cell = mpmc_cell_at(q, pos);
+        int64_t diff = (int64_t)(atom_load_acquire(&cell->sequence) - (pos + 1));
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&q->head, &pos, pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return 0;  // its push hasn't happened
+        } else {
+            pos = atom_load_relaxed(&q->head);
+        }
+    }
+    memcpy(item, cell->item, q->stride);
+    atom_store_release(&cell->sequence, pos + q->mask + 1);
+    return 1;
+}
+
+uint32_t mpmc_count(mpmc_queue* q) {
+    uint64_t head = atom_load_acquire(&q->head);
+    uint64_t tail = atom_load_acquire(&q->tail);
+    return tail > head ? (uint32_t)(tail - head) : 0;
+}
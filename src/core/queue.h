@@ -0,0 +1,68 @@
+#pragma once
+
+#include <stdalign.h>
+#include <stdint.h>
+
+#include "mem.h"
+#include "os_thread.h"
+
+// bounded lock-free rings for handing items between threads. items are copied
+// in and out by value, stride bytes each; capacity is rounded up to a power of
+// two. push returns 0 when full and pop 0 when empty, neither ever blocks.
+// the producer and consumer ends live on their own cache lines
+#define QUEUE_LINE 64
+
+// one producer thread, one consumer thread. each side keeps a stale copy of
+// the other's index and only reloads it when the ring looks full or empty,
+// so a steady stream touches the shared line once per lap instead of once
+// per item
+typedef struct {
+    alignas(QUEUE_LINE) atom_u64 tail;  // producer
+    uint64_t head_cache;
+    alignas(QUEUE_LINE) atom_u64 head;  // consumer
+    uint64_t tail_cache;
+    alignas(QUEUE_LINE) uint8_t* items;
+    uint64_t   mask;
+    uint32_t   stride;
+    allocator* ator;
+} spsc_queue;
+
+int      spsc_init(spsc_queue* q, allocator* ator, uint32_t capacity,
+                   uint32_t stride);  // 0 on success
+void     spsc_destroy(spsc_queue* q);
+int      spsc_push(spsc_queue* q, const void* item);
+int      spsc_pop(spsc_queue* q, void* item);
+uint32_t spsc_count(spsc_queue* q);  // a snapshot, exact only when idle
+
+// any number of producers and consumers, after vyukov's bounded mpmc queue:
+// every cell carries a sequence number saying whose turn it is, so a push or
+// pop is one cas on its index plus the copy, and threads on opposite ends
+// never touch the same line unless the ring is nearly full or empty
+typedef struct {
+    alignas(QUEUE_LINE) atom_u64 tail;  // producers
+    alignas(QUEUE_LINE) atom_u64 head;  // consumers
+    alignas(QUEUE_LINE) uint8_t* cells;
+    uint64_t   mask;
+    uint32_t   stride;
+    uint32_t   cell_size;  // sequence number plus the item, 8 byte aligned
+    allocator* ator;
+} mpmc_queue;
+
+int      mpmc_init(mpmc_queue* q, allocator* ator, uint32_t capacity,
+                   uint32_t stride);  // 0 on success
+void     mpmc_destroy(mpmc_queue* q);
+int      mpmc_push(mpmc_queue* q, const void* item);
+int      mpmc_pop(mpmc_queue* q, void* item);
+uint32_t mpmc_count(mpmc_queue* q);
+
+// typed front ends: the item size comes from the type, and push and pop warn
+// when handed a pointer to anything else
+#define spsc_init_type(q, ator, type, capacity) \
+    spsc_init((q), (ator), (capacity), sizeof(type))
+#define spsc_push_type(q, type, item) spsc_push((q), 1 ? (item) : (const type*)0)
+#define spsc_pop_type(q, type, out) spsc_pop((q), 1 ? (out) : (type*)0)
+
+#define mpmc_init_type(q, ator, type, capacity) \
+    mpmc_init((q), (ator), (capacity), sizeof(type))
+#define mpmc_push_type(q, type, item) mpmc_push((q), 1 ? (item) : (const type*)0)
+#define mpmc_pop_type(q, type, out) mpmc_pop((q), 1 ? (out) : (type*)0)
@@ -2,9 +2,14 @@
 #include <stdalign.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "base.h"
 #include "camera.h"
+#include "core/ecs.h"
+#include "core/loop.h"
+#include "core/mem.h"
+#include "core/os.h"
 #include "core/os_event.h"
 #include "core/wnd.h"
 #include "math_types.h"
@@ -40,10 +45,18 @@ static float    slow_speed = 1.0f;
 static uint32_t is_running = 0;
 static uint32_t needs_resize = 0;
 static uint32_t fps_frame_count;
+static uint64_t frame_index;
 static uint32_t window_width = 1920;
 static uint32_t window_height = 720;
 static camera   cam;
 
+#define SIM_STEP (1.0 / 120.0)
+#define SIM_MAX_STEPS 8  // a frame longer than this many steps drops the rest
+#define MAX_ENTITIES (1 << 16)
+// culling runs a chunk at a time, and no chunk holds more positions than fit
+// in it whole
+#define CULL_MAX (ECS_CHUNK_SIZE / sizeof(vec3))
+
 static vertex vertices[] = {
     {-1.0f, -1.0f, -1.0f, 1.0f, 0.0f, 0.0f},  // 0
     {1.0f, -1.0f, -1.0f, 0.0f, 1.0f, 0.0f},   // 1
@@ -161,10 +174,57 @@ int main(void) {
 
     wnd_init();
     time_init();
-    uint32_t    window_api = wnd_backend_id();
+
+    // GAME0_MEM_STATS=<file.csv|file.json> dumps allocator telemetry every frame
+    const char* mem_stats_path = os_getenv("GAME0_MEM_STATS");
+    if (mem_stats_path) {
+        const char* ext = strrchr(mem_stats_path, '.');
+        mem_stats_format fmt = ext && strcmp(ext, ".json") == 0
+                                   ? MEM_STATS_FORMAT_JSON
+                                   : MEM_STATS_FORMAT_CSV;
+        mem_stats_open(mem_stats_path, fmt);
+    }
+    // GAME0_MEM_TRACE=<file> records every allocator call for bench/memreplay
+    const char* mem_trace_path = os_getenv("GAME0_MEM_TRACE");
+    if (mem_trace_path) {
+        mem_trace_open(mem_trace_path);
+    }
+    allocator* core_mem =
+        allocator_create(ALLOCATOR_TYPE_TLSF, MEM_TAG_CORE, mmega(16));
+    // game state lives in the ecs; for now a single cube at the origin
+    ecs_world world;
+    if (ecs_init(&world, core_mem, MAX_ENTITIES) != 0) {
+        debug_log("failed to create the ecs world\n");
+        return -1;
+    }
+    ecs_component position = ecs_component_type(&world, vec3);
+    ecs_spawn(&world, ecs_mask(position));
+    ecs_query cubes = {{position}, 1, 0};
+    vec3x8*   cull_centers =
+        aalloc_array(core_mem, vec3x8, mathf_pack_count(CULL_MAX));
+    vec3x8*   cull_extents =
+        aalloc_array(core_mem, vec3x8, mathf_pack_count(CULL_MAX));
+    uint32_t* cull_visible = aalloc_array(core_mem, uint32_t, CULL_MAX);
+    if (!cull_centers || !cull_extents || !cull_visible) {
+        debug_log("failed to allocate the culling buffers\n");
+        return -1;
+    }
+    // every cube spans -1..1 around its position
+    for (uint32_t p = 0; p < mathf_pack_count(CULL_MAX); p++) {
+        for (uint32_t l = 0; l < MATHF_LANES; l++) {
+            cull_extents[p].x[l] = 1.0f;
+            cull_extents[p].y[l] = 1.0f;
+            cull_extents[p].z[l] = 1.0f;
+        }
+    }
+    uint32_t window_api = wnd_backend_id();
+    // driver and validation layer host memory, tlsf since vulkan needs the
+    // alignment honoured
+    allocator* rhost =
+        allocator_create(ALLOCATOR_TYPE_TLSF, MEM_TAG_RENDERER, mmega(256));
     rdev_params rparams = {
         .wnd_api = window_api,
-        .allocator = 0,
+        .allocator = rhost,
         .scratch_allocator = 0,
     };
     rdev_init(&rparams);
@@ -249,18 +309,21 @@ int main(void) {
     cam = camera_create_fps((vec3){0, 0, 5}, 45.0f * PI / 180.0f,
                             (float)window_width / window_height, 0.1f, 100.0f);
 
-    time_p last_frame;
-    double delta_time = 0;
+    // cam is the simulated state, previous_cam the one a step before it
+    camera     previous_cam = cam;
+    frame_loop loop;
+    loop_init(&loop, SIM_STEP, SIM_MAX_STEPS);
+    last_time = time_now();
+    loop_advance(&loop, last_time);
 
     while (is_running) {
         wnd_dispatch_events();
 
-        time_p now = time_now();
+        time_p   now = time_now();
+        uint32_t steps = loop_advance(&loop, now);
         fps_frame_count++;
 
         elapsed = time_diff_sec(last_time, now);
-        delta_time = time_diff_sec(last_frame, now);
-        last_frame = now;
         if (elapsed >= 1.0) {
             char title[128] = {0};
             sprintf(title, "game_0 - %d fps", fps_frame_count);
@@ -277,31 +340,49 @@ int main(void) {
         // Update camera movement speed
         cam.move_speed = speed;
 
-        // Process movement
-        if (w_pressed) camera_move_forward(&cam, delta_time);
-        if (s_pressed) camera_move_backward(&cam, delta_time);
-        if (a_pressed) camera_move_left(&cam, delta_time);
-        if (d_pressed) camera_move_right(&cam, delta_time);
-        if (q_pressed) camera_move_up(&cam, delta_time);
-        if (e_pressed) camera_move_down(&cam, delta_time);
+        // Process movement in fixed steps
+        for (uint32_t i = 0; i < steps; i++) {
+            previous_cam = cam;
+            if (w_pressed) camera_move_forward(&cam, loop.step);
+            if (s_pressed) camera_move_backward(&cam, loop.step);
+            if (a_pressed) camera_move_left(&cam, loop.step);
+            if (d_pressed) camera_move_right(&cam, loop.step);
+            if (q_pressed) camera_move_up(&cam, loop.step);
+            if (e_pressed) camera_move_down(&cam, loop.step);
+        }
+        // mouse look follows the display rate rather than the simulation
+        camera_update(&cam);
+        camera view_cam = camera_interpolate(&previous_cam, &cam, loop.alpha);
         if (needs_resize) {
             rdev_resize_swapchain(window_width, window_height);
             needs_resize = 0;
         }
 
-        mat4 model = mat4_identity();
-        mat4 mvp = camera_mvp_matrix(&cam, &model);
+        frustum view_frustum = camera_frustum(&view_cam);
 
         rcmd* cmd = rdev_begin();
         rcmd_begin_pass(cmd, swapchain_pass);
         rcmd_bind_pipe(cmd, pipeline);
-        rcmd_push_constants(cmd, pipeline, RSHADER_STAGE_VERTEX, 0, sizeof(mat4),
-                            &mvp);
         rcmd_bind_vertex_buffer(cmd, vertex_buffer);
         rcmd_bind_index_buffer(cmd, index_buffer);
-        rcmd_draw_indexed(cmd, index_count, 1, 0, 0, 0);
+        ecs_iter it = ecs_query_iter(&world, &cubes);
+        while (ecs_iter_next(&it)) {
+            const vec3* pos = it.columns[0];
+            v3x8_pack(pos, it.count, cull_centers);
+            uint32_t visible = frustum_cull_aabbs(&view_frustum, cull_centers,
+                                                  cull_extents, it.count,
+                                                  cull_visible);
+            for (uint32_t i = 0; i < visible; i++) {
+                mat4 model = mat4_translation(pos[cull_visible[i]]);
+                mat4 mvp = camera_mvp_matrix(&view_cam, &model);
+                rcmd_push_constants(cmd, pipeline, RSHADER_STAGE_VERTEX, 0,
+                                    sizeof(mat4), &mvp);
+                rcmd_draw_indexed(cmd, index_count, 1, 0, 0, 0);
+            }
+        }
         rcmd_end_pass(cmd, swapchain_pass);
         rdev_end(cmd);
+        mem_stats_frame(frame_index++);
     }
     // todo: need to wait device idle
     rdev_destroy_pipeline(pipeline);
@@ -309,7 +390,15 @@ int main(void) {
     rdev_destroy_buffer(vertex_buffer);
     rdev_destroy_swapchain();
     rdev_terminate();
+    adestroy(rhost);
+    afree(core_mem, cull_visible);
+    afree(core_mem, cull_extents);
+    afree(core_mem, cull_centers);
+    ecs_destroy(&world);
+    adestroy(core_mem);
     wnd_terminate();
+    mem_trace_close();
+    mem_stats_close();
     debug_log("Terminated successfully!\n");
     return 0;
 }
@@ -21,3 +21,57 @@ typedef struct {
 typedef struct {
     float m[16];  // column major
 } mat4;
+
+// rotation quaternion, x y z vector part and w scalar part
+typedef struct {
+    float x;
+    float y;
+    float z;
+    float w;
+} quat;
+
+// affine 3x4: column major like mat4 with the bottom row 0 0 0 1 implied,
+// m[9..11] holds the translation
+typedef struct {
+    float m[12];
+} affine;
+
+// translation, rotation, scale; applied as T * R * S
+typedef struct {
+    vec3 translation;
+    quat rotation;
+    vec3 scale;
+} trs;
+
+// wide soa packs: MATHF_LANES elements stored component by component so a
+// kernel loads eight x's at once. pack arrays are padded to a whole number of
+// packs; 32 byte alignment is not required but avoids split loads
+#define MATHF_LANES 8
+
+typedef struct {
+    float x[MATHF_LANES];
+    float y[MATHF_LANES];
+    float z[MATHF_LANES];
+} vec3x8;
+
+typedef struct {
+    float x[MATHF_LANES];
+    float y[MATHF_LANES];
+    float z[MATHF_LANES];
+    float w[MATHF_LANES];
+} vec4x8;
+
+typedef enum {
+    FRUSTUM_PLANE_LEFT = 0,
+    FRUSTUM_PLANE_RIGHT,
+    FRUSTUM_PLANE_BOTTOM,
+    FRUSTUM_PLANE_TOP,
+    FRUSTUM_PLANE_NEAR,
+    FRUSTUM_PLANE_FAR,
+    FRUSTUM_PLANE_COUNT,
+} frustum_plane;
+
+// world space planes (n, d) with dot(n, p) + d >= 0 on the inside, unit n
+typedef struct {
+    vec4 planes[FRUSTUM_PLANE_COUNT];
+} frustum;
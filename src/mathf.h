@@ -1,54 +1,197 @@
 #pragma once 
+#include <stdint.h>
+
 #include "math_types.h"
 
+// simd backend, picked at compile time from the target flags: sse2 is the x64
+// baseline, -mavx widens mat4_mul to two columns per op, anything else (or
+// -DMATHF_SCALAR) uses the plain c reference. every backend returns the same
+// bits as the reference as long as mul+add isn't contracted into fma, so
+// builds with -mfma / -march=native should also pass -ffp-contract=off
+#if !defined(MATHF_SCALAR) && (defined(__SSE2__) || defined(_M_X64))
+#define MATHF_SIMD_SSE2 1
+#if defined(__AVX__)
+#define MATHF_SIMD_AVX 1
+#define MATHF_BACKEND "avx"
+#else
+#define MATHF_BACKEND "sse2"
+#endif
+#else
+#define MATHF_BACKEND "scalar"
+#endif
+
+// -DMATHF_INLINE compiles the whole library as static inline definitions in
+// every unit that includes this header, so v3_add and friends inline across
+// translation units without lto. the small ops are forced inline; the batch
+// kernels are left to the compiler. without it mathf.c is an ordinary unit
+#ifdef MATHF_INLINE
+#define MATHF_API static inline __attribute__((always_inline))
+#define MATHF_KERNEL static inline
+#else
+#define MATHF_API
+#define MATHF_KERNEL
+#endif  // MATHF_INLINE
+
 #define PI 3.14159265358979323846
 #define HALF_PI PI / 2
 #define TWO_PI PI * 2
 
-float deg2rad(float degrees);
-float rad2deg(float radians);
-
-vec2  v2_add(vec2 a, vec2 b);
-vec2  v2_sub(vec2 a, vec2 b);
-vec2  v2_mul(vec2 a, vec2 b);
-vec2  v2_scale(vec2 v, float s);
-vec2  v2_div(vec2 v, float s);
-vec2  v2_normalize(vec2 v);
-vec2  v2_lerp(vec2 a, vec2 b, float t);
-float v2_dot(vec2 a, vec2 b);
-float v2_length(vec2 v);
-
-vec3  v3_zero();
-vec3  v3_one();
-vec3  v3_left();
-vec3  v3_right();
-vec3  v3_up();
-vec3  v3_add(vec3 a, vec3 b);
-vec3  v3_sub(vec3 a, vec3 b);
-vec3  v3_mul(vec3 a, vec3 b);
-vec3  v3_scale(vec3 v, float s);
-vec3  v3_div(vec3 v, float s);
-vec3  v3_cross(vec3 a, vec3 b);
-vec3  v3_normalize(vec3 v);
-vec3  v3_lerp(vec3 a, vec3 b, float t);
-float v3_length(vec3 v);
-float v3_dot(vec3 a, vec3 b);
-
-vec4  v4_add(vec4 a, vec4 b);
-vec4  v4_sub(vec4 a, vec4 b);
-vec4  v4_mul(vec4 a, vec4 b);
-vec4  v4_scale(vec4 v, float s);
-vec4  v4_div(vec4 v, float s);
-vec4  v4_normalize(vec4 v);
-vec4  v4_lerp(vec4 a, vec4 b, float t);
-float v4_dot(vec4 a, vec4 b);
-float v4_length(vec4 v);
-
-mat4 mat4_identity(void);
-mat4 mat4_translation(vec3 translation);
-mat4 mat4_rotation_x(float radians);
-mat4 mat4_rotation_y(float radians);
-mat4 mat4_rotation_z(float radians);
-mat4 mat4_perspective(float fov_radians, float aspect, float near_z, float far_z);
-mat4 mat4_look_at(vec3 eye, vec3 center, vec3 up);
-mat4 mat4_mul(mat4 a, mat4 b);
+MATHF_API float deg2rad(float degrees);
+MATHF_API float rad2deg(float radians);
+
+MATHF_API vec2  v2_add(vec2 a, vec2 b);
+MATHF_API vec2  v2_sub(vec2 a, vec2 b);
+MATHF_API vec2  v2_mul(vec2 a, vec2 b);
+MATHF_API vec2  v2_scale(vec2 v, float s);
+MATHF_API vec2  v2_div(vec2 v, float s);
+MATHF_API vec2  v2_normalize(vec2 v);
+MATHF_API vec2  v2_lerp(vec2 a, vec2 b, float t);
+MATHF_API float v2_dot(vec2 a, vec2 b);
+MATHF_API float v2_length(vec2 v);
+
+MATHF_API vec3  v3_zero();
+MATHF_API vec3  v3_one();
+MATHF_API vec3  v3_left();
+MATHF_API vec3  v3_right();
+MATHF_API vec3  v3_up();
+MATHF_API vec3  v3_add(vec3 a, vec3 b);
+MATHF_API vec3  v3_sub(vec3 a, vec3 b);
+MATHF_API vec3  v3_mul(vec3 a, vec3 b);
+MATHF_API vec3  v3_scale(vec3 v, float s);
+MATHF_API vec3  v3_div(vec3 v, float s);
+MATHF_API vec3  v3_cross(vec3 a, vec3 b);
+MATHF_API vec3  v3_normalize(vec3 v);
+MATHF_API vec3  v3_lerp(vec3 a, vec3 b, float t);
+MATHF_API float v3_length(vec3 v);
+MATHF_API float v3_dot(vec3 a, vec3 b);
+
+MATHF_API vec4  v4_add(vec4 a, vec4 b);
+MATHF_API vec4  v4_sub(vec4 a, vec4 b);
+MATHF_API vec4  v4_mul(vec4 a, vec4 b);
+MATHF_API vec4  v4_scale(vec4 v, float s);
+MATHF_API vec4  v4_div(vec4 v, float s);
+MATHF_API vec4  v4_normalize(vec4 v);
+MATHF_API vec4  v4_lerp(vec4 a, vec4 b, float t);
+MATHF_API float v4_dot(vec4 a, vec4 b);
+MATHF_API float v4_length(vec4 v);
+
+MATHF_API mat4 mat4_identity(void);
+MATHF_API mat4 mat4_translation(vec3 translation);
+MATHF_API mat4 mat4_rotation_x(float radians);
+MATHF_API mat4 mat4_rotation_y(float radians);
+MATHF_API mat4 mat4_rotation_z(float radians);
+MATHF_API mat4 mat4_perspective(float fov_radians, float aspect, float near_z,
+                                float far_z);
+MATHF_API mat4 mat4_look_at(vec3 eye, vec3 center, vec3 up);
+// same clip conventions as mat4_perspective: +z into the screen, depth 0..1
+MATHF_API mat4 mat4_orthographic(float left, float right, float bottom, float top,
+                                 float near_z, float far_z);
+MATHF_API mat4 mat4_mul(mat4 a, mat4 b);
+// skip the projective row: both inputs must have a bottom row of 0 0 0 1
+MATHF_API mat4 mat4_mul_affine(mat4 a, mat4 b);
+MATHF_API mat4 mat4_inverse_affine(mat4 m);
+
+MATHF_API quat  quat_identity(void);
+MATHF_API quat  quat_from_axis_angle(vec3 axis, float radians);  // unit axis
+MATHF_API quat  quat_mul(quat a, quat b);  // rotates by b, then by a
+MATHF_API quat  quat_conjugate(quat q);
+MATHF_API quat  quat_normalize(quat q);
+MATHF_API float quat_dot(quat a, quat b);
+MATHF_API vec3  quat_rotate(quat q, vec3 v);
+// both take the shortest arc; nlerp is cheaper and fine for small steps
+MATHF_API quat quat_nlerp(quat a, quat b, float t);
+MATHF_API quat quat_slerp(quat a, quat b, float t);
+MATHF_API mat4 quat_to_mat4(quat q);
+
+MATHF_API affine affine_identity(void);
+MATHF_API affine affine_mul(affine a, affine b);
+// general inverse, handles scale and shear; singular input returns identity
+MATHF_API affine affine_inverse(affine m);
+MATHF_API vec3   affine_transform_point(affine m, vec3 p);
+MATHF_API vec3   affine_transform_dir(affine m, vec3 d);
+MATHF_API mat4   affine_to_mat4(affine m);
+MATHF_API affine mat4_to_affine(mat4 m);  // drops the bottom row
+
+MATHF_API trs    trs_identity(void);
+MATHF_API affine trs_to_affine(trs t);
+MATHF_API mat4   trs_to_mat4(trs t);
+// parent * child; exact while the parent's scale is uniform, otherwise the
+// shear a non uniform parent would put on a rotated child is dropped
+MATHF_API trs trs_mul(trs parent, trs child);
+// lerps translation and scale, slerps rotation
+MATHF_API trs trs_lerp(trs a, trs b, float t);
+
+// out[i] = a * b[i]; out may alias a or b
+MATHF_KERNEL void mat4_mul_batch(const mat4* a, const mat4* b, mat4* out,
+                                 uint32_t count);
+
+// packs needed for count elements
+#define mathf_pack_count(count) (((count) + MATHF_LANES - 1) / MATHF_LANES)
+
+// aos <-> soa; pack zero fills the lanes past count in the last pack
+MATHF_KERNEL void v3x8_pack(const vec3* src, uint32_t count, vec3x8* dst);
+MATHF_KERNEL void v3x8_unpack(const vec3x8* src, uint32_t count, vec3* dst);
+MATHF_KERNEL void v4x8_unpack(const vec4x8* src, uint32_t count, vec4* dst);
+
+// dst = m * (src, 1), the full clip space result including w
+MATHF_KERNEL void v3x8_transform_points(const mat4* m, const vec3x8* src,
+                                        vec4x8* dst, uint32_t pack_count);
+// zero length lanes come out as zero, like v3_normalize; src may equal dst
+MATHF_KERNEL void v3x8_normalize(const vec3x8* src, vec3x8* dst,
+                                 uint32_t pack_count);
+
+MATHF_API frustum frustum_from_mat4(mat4 view_proj);
+// 1 when the volume touches the frustum; conservative near the corners
+MATHF_API int frustum_test_sphere(const frustum* f, vec3 center, float radius);
+MATHF_API int frustum_test_aabb(const frustum* f, vec3 center, vec3 extent);
+
+// batched culling over packed bounds: writes the indices of the volumes that
+// pass frustum_test_* to visible in ascending order and returns how many.
+// visible needs room for count indices; radii is padded like the packs
+MATHF_KERNEL uint32_t frustum_cull_spheres(const frustum* f, const vec3x8* centers,
+                                           const float* radii, uint32_t count,
+                                           uint32_t* visible);
+MATHF_KERNEL uint32_t frustum_cull_aabbs(const frustum* f, const vec3x8* centers,
+                                         const vec3x8* extents, uint32_t count,
+                                         uint32_t* visible);
+
+// the same tests against up to 32 frusta in one pass over the bounds: bit v of
+// masks[i] is set when volume i passes against frusta[v]; frusta past the
+// first FRUSTUM_MASK_MAX are ignored. masks gets count entries, the padding
+// lanes are not written
+#define FRUSTUM_MASK_MAX 32
+MATHF_KERNEL void frustum_mask_spheres(const frustum* frusta, uint32_t frusta_count,
+                                       const vec3x8* centers, const float* radii,
+                                       uint32_t count, uint32_t* masks);
+MATHF_KERNEL void frustum_mask_aabbs(const frustum* frusta, uint32_t frusta_count,
+                                     const vec3x8* centers, const vec3x8* extents,
+                                     uint32_t count, uint32_t* masks);
+
+// fast approximations, measured against a double reference by
+// `mathbench exhaustive` over every float in the stated domain (atan2 over
+// every finite y with x = +-1, which reaches every ratio it evaluates):
+//   fast_sin/cos/sincos  |x| <= 8192, abs error <= FAST_SINCOS_MAX_ERR
+//   fast_rsqrt           positive normal x, rel error <= FAST_RSQRT_MAX_REL_ERR
+//                        (1/sqrtf on the scalar backend)
+//   fast_atan2           finite y, x, abs error <= FAST_ATAN2_MAX_ERR;
+//                        atan2(+-0, -0) gives +-0 where libm gives +-pi
+// the batch forms return the same bits as the scalar ones
+#define FAST_SINCOS_MAX_ERR 8e-8f
+#define FAST_RSQRT_MAX_REL_ERR 3e-7f
+#define FAST_ATAN2_MAX_ERR 3e-7f
+
+MATHF_API float fast_sin(float x);
+MATHF_API float fast_cos(float x);
+MATHF_API void  fast_sincos(float x, float* s, float* c);
+MATHF_API float fast_rsqrt(float x);
+MATHF_API float fast_atan2(float y, float x);
+
+MATHF_KERNEL void fast_sincos_batch(const float* x, float* s, float* c,
+                                    uint32_t count);
+MATHF_KERNEL void fast_rsqrt_batch(const float* x, float* out, uint32_t count);
+MATHF_KERNEL void fast_atan2_batch(const float* y, const float* x, float* out,
+                                   uint32_t count);
+
+#ifdef MATHF_INLINE
+#include "mathf_impl.h"
+#endif  // MATHF_INLINE
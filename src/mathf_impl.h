@@ -0,0 +1,1272 @@
+// mathf definitions, compiled once by mathf.c or, with MATHF_INLINE, pulled
+// into every includer by mathf.h. the public definitions carry no storage
+// class and take it from the MATHF_API declarations in mathf.h: extern for the
+// .c build, static inline (forced) for the header build. only include through
+// mathf.h / mathf.c
+#pragma once
+
+#include <math.h>
+
+#if MATHF_SIMD_AVX
+#include <immintrin.h>
+#elif MATHF_SIMD_SSE2
+#include <emmintrin.h>
+#endif
+
+float deg2rad(float degrees) { return degrees * (PI / 180.0f); }
+float rad2deg(float radians) { return radians * (180.0f / PI); }
+
+vec2  v2_add(vec2 a, vec2 b) { return (vec2){a.x + b.x, a.y + b.y}; }
+vec2  v2_sub(vec2 a, vec2 b) { return (vec2){a.x - b.x, a.y - b.y}; }
+vec2  v2_mul(vec2 a, vec2 b) { return (vec2){a.x * b.x, a.y * b.y}; }
+vec2  v2_scale(vec2 v, float s) { return (vec2){v.x * s, v.y * s}; }
+vec2  v2_div(vec2 v, float s) { return (vec2){v.x / s, v.y / s}; }
+float v2_dot(vec2 a, vec2 b) { return a.x * b.x + a.y * b.y; }
+float v2_length(vec2 v) { return sqrtf(v2_dot(v, v)); }
+vec2  v2_normalize(vec2 v) {
+    float len = v2_length(v);
+    return (len != 0.0f) ? v2_div(v, len) : (vec2){0.0f, 0.0f};
+}
+vec2 v2_lerp(vec2 a, vec2 b, float t) {
+    return (vec2){a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t};
+}
+
+vec3  v3_zero() { return (vec3){0.0f, 0.0f, 0.0f}; }
+vec3  v3_one() { return (vec3){1.0f, 1.0f, 1.0f}; }
+vec3  v3_left() { return (vec3){-1.0f, 0.0f, 0.0f}; }
+vec3  v3_right() { return (vec3){1.0f, 0.0f, 0.0f}; }
+vec3  v3_up() { return (vec3){0.0f, 1.0f, 0.0f}; }
+vec3  v3_add(vec3 a, vec3 b) { return (vec3){a.x + b.x, a.y + b.y, a.z + b.z}; }
+vec3  v3_sub(vec3 a, vec3 b) { return (vec3){a.x - b.x, a.y - b.y, a.z - b.z}; }
+vec3  v3_mul(vec3 a, vec3 b) { return (vec3){a.x * b.x, a.y * b.y, a.z * b.z}; }
+vec3  v3_scale(vec3 v, float s) { return (vec3){v.x * s, v.y * s, v.z * s}; }
+vec3  v3_div(vec3 v, float s) { return (vec3){v.x / s, v.y / s, v.z / s}; }
+float v3_dot(vec3 a, vec3 b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+vec3  v3_cross(vec3 a, vec3 b) {
+    return (vec3){a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z,
+                   a.x * b.y - a.y * b.x};
+}
+float v3_length(vec3 v) { return sqrtf(v3_dot(v, v)); }
+vec3  v3_normalize(vec3 v) {
+    float len = v3_length(v);
+    return (len != 0.0f) ? v3_div(v, len) : (vec3){0.0f, 0.0f, 0.0f};
+}
+vec3 v3_lerp(vec3 a, vec3 b, float t) {
+    return (vec3){a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t,
+                  a.z + (b.z - a.z) * t};
+}
+
+// Vec4 implementations
+//
+// the *_scalar versions are the reference every simd path has to match bit for
+// bit: same operations, same order, no reassociation
+static inline vec4 v4_add_scalar(vec4 a, vec4 b) {
+    return (vec4){a.x + b.x, a.y + b.y, a.z + b.z, a.w + b.w};
+}
+static inline vec4 v4_sub_scalar(vec4 a, vec4 b) {
+    return (vec4){a.x - b.x, a.y - b.y, a.z - b.z, a.w - b.w};
+}
+static inline vec4 v4_mul_scalar(vec4 a, vec4 b) {
+    return (vec4){a.x * b.x, a.y * b.y, a.z * b.z, a.w * b.w};
+}
+static inline vec4 v4_scale_scalar(vec4 v, float s) {
+    return (vec4){v.x * s, v.y * s, v.z * s, v.w * s};
+}
+static inline vec4 v4_div_scalar(vec4 v, float s) {
+    return (vec4){v.x / s, v.y / s, v.z / s, v.w / s};
+}
+static inline float v4_dot_scalar(vec4 a, vec4 b) {
+    return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+}
+static inline float v4_length_scalar(vec4 v) { return sqrtf(v4_dot_scalar(v, v)); }
+static inline vec4  v4_normalize_scalar(vec4 v) {
+    float len = v4_length_scalar(v);
+    return (len != 0.0f) ? v4_div_scalar(v, len) : (vec4){0.0f, 0.0f, 0.0f, 0.0f};
+}
+static inline vec4 v4_lerp_scalar(vec4 a, vec4 b, float t) {
+    return (vec4){a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t,
+                  a.z + (b.z - a.z) * t, a.w + (b.w - a.w) * t};
+}
+
+#if MATHF_SIMD_SSE2
+// the only isa specific pieces the vec4/mat4 paths use; a neon backend fills in
+// these and the transpose in mat4_look_at
+static inline __m128 f4_load(vec4 v) { return _mm_loadu_ps(&v.x); }
+static inline vec4   f4_store(__m128 m) {
+    vec4 r;
+    _mm_storeu_ps(&r.x, m);
+    return r;
+}
+static inline __m128 f4_splat(float s) { return _mm_set1_ps(s); }
+
+// x + y + z, w ignored
+static inline float f4_hsum3(__m128 v) {
+    __m128 s = _mm_add_ss(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1)));
+    s = _mm_add_ss(s, _mm_movehl_ps(v, v));
+    return _mm_cvtss_f32(s);
+}
+
+static inline __m128 f4_cross3(__m128 a, __m128 b) {
+    __m128 a_yzx = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+    __m128 a_zxy = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 1, 0, 2));
+    __m128 b_yzx = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+    __m128 b_zxy = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 1, 0, 2));
+    return _mm_sub_ps(_mm_mul_ps(a_yzx, b_zxy), _mm_mul_ps(a_zxy, b_yzx));
+}
+
+static inline __m128 f4_normalize3(__m128 v) {
+    float len = sqrtf(f4_hsum3(_mm_mul_ps(v, v)));
+    return (len != 0.0f) ? _mm_div_ps(v, f4_splat(len)) : _mm_setzero_ps();
+}
+
+vec4 v4_add(vec4 a, vec4 b) { return f4_store(_mm_add_ps(f4_load(a), f4_load(b))); }
+vec4 v4_sub(vec4 a, vec4 b) { return f4_store(_mm_sub_ps(f4_load(a), f4_load(b))); }
+vec4 v4_mul(vec4 a, vec4 b) { return f4_store(_mm_mul_ps(f4_load(a), f4_load(b))); }
+vec4 v4_scale(vec4 v, float s) {
+    return f4_store(_mm_mul_ps(f4_load(v), f4_splat(s)));
+}
+vec4 v4_div(vec4 v, float s) {
+    return f4_store(_mm_div_ps(f4_load(v), f4_splat(s)));
+}
+// a by-value vec4 arrives split over two registers, so a single horizontal
+// sum costs more to gather into one vector than it saves; the batched
+// kernels are where dot products pay off
+float v4_dot(vec4 a, vec4 b) { return v4_dot_scalar(a, b); }
+float v4_length(vec4 v) { return v4_length_scalar(v); }
+vec4  v4_normalize(vec4 v) {
+    float len = v4_length_scalar(v);
+    return (len != 0.0f) ? f4_store(_mm_div_ps(f4_load(v), f4_splat(len)))
+                         : (vec4){0.0f, 0.0f, 0.0f, 0.0f};
+}
+vec4 v4_lerp(vec4 a, vec4 b, float t) {
+    __m128 ma = f4_load(a);
+    __m128 d = _mm_mul_ps(_mm_sub_ps(f4_load(b), ma), f4_splat(t));
+    return f4_store(_mm_add_ps(ma, d));
+}
+#else
+vec4  v4_add(vec4 a, vec4 b) { return v4_add_scalar(a, b); }
+vec4  v4_sub(vec4 a, vec4 b) { return v4_sub_scalar(a, b); }
+vec4  v4_mul(vec4 a, vec4 b) { return v4_mul_scalar(a, b); }
+vec4  v4_scale(vec4 v, float s) { return v4_scale_scalar(v, s); }
+vec4  v4_div(vec4 v, float s) { return v4_div_scalar(v, s); }
+float v4_dot(vec4 a, vec4 b) { return v4_dot_scalar(a, b); }
+float v4_length(vec4 v) { return v4_length_scalar(v); }
+vec4  v4_normalize(vec4 v) { return v4_normalize_scalar(v); }
+vec4  v4_lerp(vec4 a, vec4 b, float t) { return v4_lerp_scalar(a, b, t); }
+#endif  // MATHF_SIMD_SSE2
+
+mat4 mat4_identity(void) {
+    mat4 result = {0};
+    result.m[0] = result.m[5] = result.m[10] = result.m[15] = 1.0f;
+    return result;
+}
+
+mat4 mat4_translation(vec3 translation) {
+    mat4 result = mat4_identity();
+    result.m[12] = translation.x;
+    result.m[13] = translation.y;
+    result.m[14] = translation.z;
+    return result;
+}
+
+mat4 mat4_rotation_x(float radians) {
+    float c = cosf(radians), s = sinf(radians);
+    mat4  result = mat4_identity();
+    result.m[5] = c;
+    result.m[6] = s;
+    result.m[9] = -s;
+    result.m[10] = c;
+    return result;
+}
+
+mat4 mat4_rotation_y(float radians) {
+    float c = cosf(radians), s = sinf(radians);
+    mat4  result = mat4_identity();
+    result.m[0] = c;
+    result.m[2] = -s;
+    result.m[8] = s;
+    result.m[10] = c;
+    return result;
+}
+
+mat4 mat4_rotation_z(float radians) {
+    float c = cosf(radians), s = sinf(radians);
+    mat4  result = mat4_identity();
+    result.m[0] = c;
+    result.m[1] = s;
+    result.m[4] = -s;
+    result.m[5] = c;
+    return result;
+}
+
+mat4 mat4_orthographic(float left, float right, float bottom, float top,
+                       float near_z, float far_z) {
+    mat4 result = mat4_identity();
+    result.m[0] = 2.0f / (right - left);
+    result.m[5] = 2.0f / (top - bottom);
+    result.m[10] = 1.0f / (far_z - near_z);
+    result.m[12] = -(right + left) / (right - left);
+    result.m[13] = -(top + bottom) / (top - bottom);
+    result.m[14] = -near_z / (far_z - near_z);
+    return result;
+}
+
+static inline mat4 mat4_perspective_scalar(float fov_radians, float aspect,
+                                           float near, float far) {
+    float tanHalfFovy = tanf(fov_radians / 2.0f);
+    mat4 result = {0};
+
+    result.m[0]  = 1.0f / (aspect * tanHalfFovy);  // [0][0]
+    result.m[5]  = 1.0f / tanHalfFovy;             // [1][1]
+    result.m[10] = far / (far - near);             // [2][2]
+    result.m[11] = 1.0f;                           // [2][3]
+    result.m[14] = -(far * near) / (far - near);   // [3][2]
+
+    return result;
+}
+
+static inline mat4 mat4_look_at_scalar(vec3 eye, vec3 center, vec3 up) {
+    // Forward vector points *towards* positive Z axis (center - eye)
+    vec3 f = v3_normalize(v3_sub(center, eye));  // forward (looking direction)
+    vec3 s = v3_normalize(v3_cross(f, up));      // right
+    vec3 u = v3_cross(s, f);                      // recalculated up vector
+
+    mat4 result = mat4_identity();
+
+    // Column-major order matching your projection
+    result.m[0] = s.x;
+    result.m[1] = u.x;
+    result.m[2] = f.x;      // Forward vector *positive* here
+    result.m[3] = 0.0f;
+
+    result.m[4] = s.y;
+    result.m[5] = u.y;
+    result.m[6] = f.y;
+    result.m[7] = 0.0f;
+
+    result.m[8] = s.z;
+    result.m[9] = u.z;
+    result.m[10] = f.z;
+    result.m[11] = 0.0f;
+
+    // Translation (dot products)
+    result.m[12] = -v3_dot(s, eye);
+    result.m[13] = -v3_dot(u, eye);
+    result.m[14] = -v3_dot(f, eye);
+    result.m[15] = 1.0f;
+
+    return result;
+}
+
+// starts the sum from the first product rather than 0.0f so a -0 product
+// keeps its sign, the same as the simd paths
+static inline mat4 mat4_mul_scalar(mat4 a, mat4 b) {
+    mat4 result;
+    for (int col = 0; col < 4; ++col) {
+        for (int row = 0; row < 4; ++row) {
+            float sum = a.m[row] * b.m[col * 4];
+            for (int i = 1; i < 4; ++i) {
+                sum += a.m[i * 4 + row] * b.m[col * 4 + i];
+            }
+            result.m[col * 4 + row] = sum;
+        }
+    }
+    return result;
+}
+
+#if MATHF_SIMD_SSE2
+mat4 mat4_perspective(float fov_radians, float aspect, float near, float far) {
+    float  tanHalfFovy = tanf(fov_radians / 2.0f);
+    __m128 num = _mm_setr_ps(1.0f, 1.0f, far, -(far * near));
+    __m128 den = _mm_setr_ps(aspect * tanHalfFovy, tanHalfFovy, far - near,
+                             far - near);
+    __m128 q = _mm_div_ps(num, den);  // [0][0], [1][1], [2][2], [3][2]
+    __m128 zero = _mm_setzero_ps();
+    __m128 lane1 = _mm_castsi128_ps(_mm_setr_epi32(0, -1, 0, 0));
+    __m128 lane2 = _mm_castsi128_ps(_mm_setr_epi32(0, 0, -1, 0));
+
+    mat4 result;
+    _mm_storeu_ps(&result.m[0], _mm_move_ss(zero, q));
+    _mm_storeu_ps(&result.m[4], _mm_and_ps(q, lane1));
+    _mm_storeu_ps(&result.m[8],
+                  _mm_or_ps(_mm_and_ps(q, lane2), _mm_setr_ps(0, 0, 0, 1.0f)));
+    _mm_storeu_ps(&result.m[12],
+                  _mm_and_ps(_mm_shuffle_ps(q, q, _MM_SHUFFLE(0, 3, 0, 0)), lane2));
+    return result;
+}
+
+mat4 mat4_look_at(vec3 eye, vec3 center, vec3 up) {
+    __m128 e = _mm_setr_ps(eye.x, eye.y, eye.z, 0.0f);
+    __m128 c = _mm_setr_ps(center.x, center.y, center.z, 0.0f);
+    __m128 w = _mm_setr_ps(up.x, up.y, up.z, 0.0f);
+    __m128 f = f4_normalize3(_mm_sub_ps(c, e));
+    __m128 s = f4_normalize3(f4_cross3(f, w));
+    __m128 u = f4_cross3(s, f);
+    float  ts = -f4_hsum3(_mm_mul_ps(s, e));
+    float  tu = -f4_hsum3(_mm_mul_ps(u, e));
+    float  tf = -f4_hsum3(_mm_mul_ps(f, e));
+
+    // rows s, u, f become the first three columns, their w lanes are zero
+    __m128 z = _mm_setzero_ps();
+    _MM_TRANSPOSE4_PS(s, u, f, z);
+
+    mat4 result;
+    _mm_storeu_ps(&result.m[0], s);
+    _mm_storeu_ps(&result.m[4], u);
+    _mm_storeu_ps(&result.m[8], f);
+    _mm_storeu_ps(&result.m[12], _mm_setr_ps(ts, tu, tf, 1.0f));
+    return result;
+}
+
+// each result column is a linear combination of a's columns weighted by one
+// column of b, accumulated in the same order as the scalar loop
+#if MATHF_SIMD_AVX
+// a's columns repeated in both halves so one op covers two result columns
+typedef struct {
+    __m256 c[4];
+} mat4_cols;
+
+static inline mat4_cols mat4_load_cols(const mat4* a) {
+    mat4_cols cols;
+    for (int i = 0; i < 4; ++i) {
+        __m128 c = _mm_loadu_ps(&a->m[i * 4]);
+        cols.c[i] = _mm256_broadcast_ps(&c);
+    }
+    return cols;
+}
+
+static inline void mat4_mul_cols(const mat4_cols* a, const float* b, float* out) {
+    for (int col = 0; col < 4; col += 2) {
+        // two 16 byte loads: by-value matrices are usually written with 16
+        // byte stores, and a 32 byte load across two of them can't be forwarded
+        __m256 bb = _mm256_insertf128_ps(
+            _mm256_castps128_ps256(_mm_loadu_ps(&b[col * 4])),
+            _mm_loadu_ps(&b[col * 4 + 4]), 1);
+        __m256 b0 = _mm256_shuffle_ps(bb, bb, 0x00);
+        __m256 b1 = _mm256_shuffle_ps(bb, bb, 0x55);
+        __m256 b2 = _mm256_shuffle_ps(bb, bb, 0xaa);
+        __m256 b3 = _mm256_shuffle_ps(bb, bb, 0xff);
+        __m256 r = _mm256_mul_ps(a->c[0], b0);
+        r = _mm256_add_ps(r, _mm256_mul_ps(a->c[1], b1));
+        r = _mm256_add_ps(r, _mm256_mul_ps(a->c[2], b2));
+        r = _mm256_add_ps(r, _mm256_mul_ps(a->c[3], b3));
+        _mm256_storeu_ps(&out[col * 4], r);
+    }
+}
+#else
+typedef struct {
+    __m128 c[4];
+} mat4_cols;
+
+static inline mat4_cols mat4_load_cols(const mat4* a) {
+    mat4_cols cols;
+    for (int i = 0; i < 4; ++i) {
+        cols.c[i] = _mm_loadu_ps(&a->m[i * 4]);
+    }
+    return cols;
+}
+
+static inline void mat4_mul_cols(const mat4_cols* a, const float* b, float* out) {
+    for (int col = 0; col < 4; ++col) {
+        const float* bc = &b[col * 4];
+        __m128       r = _mm_mul_ps(a->c[0], f4_splat(bc[0]));
+        r = _mm_add_ps(r, _mm_mul_ps(a->c[1], f4_splat(bc[1])));
+        r = _mm_add_ps(r, _mm_mul_ps(a->c[2], f4_splat(bc[2])));
+        r = _mm_add_ps(r, _mm_mul_ps(a->c[3], f4_splat(bc[3])));
+        _mm_storeu_ps(&out[col * 4], r);
+    }
+}
+#endif  // MATHF_SIMD_AVX
+
+mat4 mat4_mul(mat4 a, mat4 b) {
+    mat4_cols cols = mat4_load_cols(&a);
+    mat4      result;
+    mat4_mul_cols(&cols, b.m, result.m);
+    return result;
+}
+
+void mat4_mul_batch(const mat4* a, const mat4* b, mat4* out, uint32_t count) {
+    // a is loaded once up front and each b column is read before the matching
+    // out column is written, so out may alias either
+    mat4_cols cols = mat4_load_cols(a);
+    for (uint32_t i = 0; i < count; ++i) {
+        mat4_mul_cols(&cols, b[i].m, out[i].m);
+    }
+}
+#else
+mat4 mat4_perspective(float fov_radians, float aspect, float near, float far) {
+    return mat4_perspective_scalar(fov_radians, aspect, near, far);
+}
+
+mat4 mat4_look_at(vec3 eye, vec3 center, vec3 up) {
+    return mat4_look_at_scalar(eye, center, up);
+}
+
+mat4 mat4_mul(mat4 a, mat4 b) { return mat4_mul_scalar(a, b); }
+
+void mat4_mul_batch(const mat4* a, const mat4* b, mat4* out, uint32_t count) {
+    mat4 ma = *a;
+    for (uint32_t i = 0; i < count; ++i) {
+        out[i] = mat4_mul_scalar(ma, b[i]);
+    }
+}
+#endif  // MATHF_SIMD_SSE2
+
+// Affine 3x4
+//
+// the affine products skip the bottom row entirely: 36 multiplies against
+// mat4_mul's 64, and the inverse is a 3x3 cofactor inverse plus a translation
+affine affine_identity(void) {
+    return (affine){{1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f,
+                     0.0f, 0.0f}};
+}
+
+affine affine_mul(affine a, affine b) {
+    affine r;
+    for (int col = 0; col < 4; ++col) {
+        const float* bc = &b.m[col * 3];
+        for (int row = 0; row < 3; ++row) {
+            r.m[col * 3 + row] =
+                a.m[row] * bc[0] + a.m[3 + row] * bc[1] + a.m[6 + row] * bc[2];
+        }
+    }
+    // translation column carries an implied 1
+    r.m[9] += a.m[9];
+    r.m[10] += a.m[10];
+    r.m[11] += a.m[11];
+    return r;
+}
+
+affine affine_inverse(affine m) {
+    vec3  c0 = {m.m[0], m.m[1], m.m[2]};
+    vec3  c1 = {m.m[3], m.m[4], m.m[5]};
+    vec3  c2 = {m.m[6], m.m[7], m.m[8]};
+    vec3  r0 = v3_cross(c1, c2);  // rows of the adjugate
+    vec3  r1 = v3_cross(c2, c0);
+    vec3  r2 = v3_cross(c0, c1);
+    float det = v3_dot(c0, r0);
+    if (det == 0.0f) return affine_identity();
+
+    float inv_det = 1.0f / det;
+    r0 = v3_scale(r0, inv_det);
+    r1 = v3_scale(r1, inv_det);
+    r2 = v3_scale(r2, inv_det);
+    vec3 t = {m.m[9], m.m[10], m.m[11]};
+    return (affine){{r0.x, r1.x, r2.x, r0.y, r1.y, r2.y, r0.z, r1.z, r2.z,
+                     -v3_dot(r0, t), -v3_dot(r1, t), -v3_dot(r2, t)}};
+}
+
+vec3 affine_transform_point(affine m, vec3 p) {
+    return (vec3){m.m[0] * p.x + m.m[3] * p.y + m.m[6] * p.z + m.m[9],
+                  m.m[1] * p.x + m.m[4] * p.y + m.m[7] * p.z + m.m[10],
+                  m.m[2] * p.x + m.m[5] * p.y + m.m[8] * p.z + m.m[11]};
+}
+
+vec3 affine_transform_dir(affine m, vec3 d) {
+    return (vec3){m.m[0] * d.x + m.m[3] * d.y + m.m[6] * d.z,
+                  m.m[1] * d.x + m.m[4] * d.y + m.m[7] * d.z,
+                  m.m[2] * d.x + m.m[5] * d.y + m.m[8] * d.z};
+}
+
+mat4 affine_to_mat4(affine m) {
+    mat4 r;
+    for (int col = 0; col < 4; ++col) {
+        r.m[col * 4 + 0] = m.m[col * 3 + 0];
+        r.m[col * 4 + 1] = m.m[col * 3 + 1];
+        r.m[col * 4 + 2] = m.m[col * 3 + 2];
+        r.m[col * 4 + 3] = col == 3 ? 1.0f : 0.0f;
+    }
+    return r;
+}
+
+affine mat4_to_affine(mat4 m) {
+    affine r;
+    for (int col = 0; col < 4; ++col) {
+        r.m[col * 3 + 0] = m.m[col * 4 + 0];
+        r.m[col * 3 + 1] = m.m[col * 4 + 1];
+        r.m[col * 3 + 2] = m.m[col * 4 + 2];
+    }
+    return r;
+}
+
+mat4 mat4_mul_affine(mat4 a, mat4 b) {
+    return affine_to_mat4(affine_mul(mat4_to_affine(a), mat4_to_affine(b)));
+}
+
+mat4 mat4_inverse_affine(mat4 m) {
+    return affine_to_mat4(affine_inverse(mat4_to_affine(m)));
+}
+
+// Quaternions
+quat quat_identity(void) { return (quat){0.0f, 0.0f, 0.0f, 1.0f}; }
+
+quat quat_from_axis_angle(vec3 axis, float radians) {
+    float s = sinf(radians * 0.5f);
+    return (quat){axis.x * s, axis.y * s, axis.z * s, cosf(radians * 0.5f)};
+}
+
+quat quat_mul(quat a, quat b) {
+    return (quat){
+        a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+        a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+        a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w,
+        a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z,
+    };
+}
+
+quat quat_conjugate(quat q) { return (quat){-q.x, -q.y, -q.z, q.w}; }
+
+float quat_dot(quat a, quat b) {
+    return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+}
+
+quat quat_normalize(quat q) {
+    float len = sqrtf(quat_dot(q, q));
+    if (len == 0.0f) return quat_identity();
+    float inv = 1.0f / len;
+    return (quat){q.x * inv, q.y * inv, q.z * inv, q.w * inv};
+}
+
+// v + 2w(u x v) + 2u x (u x v), folded into two crosses
+vec3 quat_rotate(quat q, vec3 v) {
+    vec3 u = {q.x, q.y, q.z};
+    vec3 t = v3_scale(v3_cross(u, v), 2.0f);
+    return v3_add(v3_add(v, v3_scale(t, q.w)), v3_cross(u, t));
+}
+
+quat quat_nlerp(quat a, quat b, float t) {
+    // q and -q are the same rotation; flip b onto a's hemisphere
+    float s = quat_dot(a, b) < 0.0f ? -t : t;
+    float k = 1.0f - t;
+    return quat_normalize((quat){a.x * k + b.x * s, a.y * k + b.y * s,
+                                 a.z * k + b.z * s, a.w * k + b.w * s});
+}
+
+quat quat_slerp(quat a, quat b, float t) {
+    float d = quat_dot(a, b);
+    if (d < 0.0f) {
+        b = (quat){-b.x, -b.y, -b.z, -b.w};
+        d = -d;
+    }
+    // nearly parallel: sin(theta) goes to zero and nlerp is indistinguishable
+    if (d > 0.9995f) return quat_nlerp(a, b, t);
+
+    float theta = acosf(d);
+    float inv_sin = 1.0f / sinf(theta);
+    float ka = sinf((1.0f - t) * theta) * inv_sin;
+    float kb = sinf(t * theta) * inv_sin;
+    return (quat){a.x * ka + b.x * kb, a.y * ka + b.y * kb, a.z * ka + b.z * kb,
+                  a.w * ka + b.w * kb};
+}
+
+// rotation columns scaled per axis; shared by quat_to_mat4 and the trs paths
+static inline void quat_basis(quat q, vec3 scale, vec3* c0, vec3* c1, vec3* c2) {
+    float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+    float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+    float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+    *c0 = (vec3){(1.0f - 2.0f * (yy + zz)) * scale.x, 2.0f * (xy + wz) * scale.x,
+                 2.0f * (xz - wy) * scale.x};
+    *c1 = (vec3){2.0f * (xy - wz) * scale.y, (1.0f - 2.0f * (xx + zz)) * scale.y,
+                 2.0f * (yz + wx) * scale.y};
+    *c2 = (vec3){2.0f * (xz + wy) * scale.z, 2.0f * (yz - wx) * scale.z,
+                 (1.0f - 2.0f * (xx + yy)) * scale.z};
+}
+
+mat4 quat_to_mat4(quat q) {
+    trs t = {{0.0f, 0.0f, 0.0f}, q, {1.0f, 1.0f, 1.0f}};
+    return trs_to_mat4(t);
+}
+
+// Transforms
+trs trs_identity(void) {
+    return (trs){{0.0f, 0.0f, 0.0f}, quat_identity(), {1.0f, 1.0f, 1.0f}};
+}
+
+affine trs_to_affine(trs t) {
+    vec3 c0, c1, c2;
+    quat_basis(t.rotation, t.scale, &c0, &c1, &c2);
+    return (affine){{c0.x, c0.y, c0.z, c1.x, c1.y, c1.z, c2.x, c2.y, c2.z,
+                     t.translation.x, t.translation.y, t.translation.z}};
+}
+
+mat4 trs_to_mat4(trs t) {
+    vec3 c0, c1, c2;
+    quat_basis(t.rotation, t.scale, &c0, &c1, &c2);
+    return (mat4){{c0.x, c0.y, c0.z, 0.0f, c1.x, c1.y, c1.z, 0.0f, c2.x, c2.y,
+                   c2.z, 0.0f, t.translation.x, t.translation.y,
+                   t.translation.z, 1.0f}};
+}
+
+trs trs_mul(trs parent, trs child) {
+    vec3 scaled = v3_mul(parent.scale, child.translation);
+    return (trs){
+        v3_add(parent.translation, quat_rotate(parent.rotation, scaled)),
+        quat_mul(parent.rotation, child.rotation),
+        v3_mul(parent.scale, child.scale),
+    };
+}
+
+trs trs_lerp(trs a, trs b, float t) {
+    return (trs){
+        v3_lerp(a.translation, b.translation, t),
+        quat_slerp(a.rotation, b.rotation, t),
+        v3_lerp(a.scale, b.scale, t),
+    };
+}
+
+// Wide soa packs
+//
+// the f8_* helpers are one eight lane register on avx, a pair of sse halves
+// on sse2 and a plain array otherwise; the kernels below are written once
+// against them. lanewise ops only, so every backend gives the same bits
+#if MATHF_SIMD_AVX
+typedef __m256 f8;
+
+static inline f8   f8_load(const float* p) { return _mm256_loadu_ps(p); }
+static inline void f8_store(float* p, f8 v) { _mm256_storeu_ps(p, v); }
+static inline f8   f8_splat(float s) { return _mm256_set1_ps(s); }
+static inline f8   f8_add(f8 a, f8 b) { return _mm256_add_ps(a, b); }
+static inline f8   f8_mul(f8 a, f8 b) { return _mm256_mul_ps(a, b); }
+static inline f8   f8_div(f8 a, f8 b) { return _mm256_div_ps(a, b); }
+static inline f8   f8_sqrt(f8 a) { return _mm256_sqrt_ps(a); }
+// a where m != 0 (nan counts as non zero, like the scalar test), else +0
+static inline f8 f8_select_nonzero(f8 a, f8 m) {
+    return _mm256_and_ps(a, _mm256_cmp_ps(m, _mm256_setzero_ps(), _CMP_NEQ_UQ));
+}
+// bit l set where lane l < 0 (nan compares false)
+static inline uint32_t f8_lt_zero(f8 a) {
+    f8 lt = _mm256_cmp_ps(a, _mm256_setzero_ps(), _CMP_LT_OQ);
+    return (uint32_t)_mm256_movemask_ps(lt);
+}
+// lane masks and bit ops, only the simd backends provide these
+static inline f8 f8_sub(f8 a, f8 b) { return _mm256_sub_ps(a, b); }
+static inline f8 f8_rsqrt(f8 a) { return _mm256_rsqrt_ps(a); }
+static inline f8 f8_and(f8 a, f8 b) { return _mm256_and_ps(a, b); }
+static inline f8 f8_andnot(f8 a, f8 b) { return _mm256_andnot_ps(a, b); }
+static inline f8 f8_or(f8 a, f8 b) { return _mm256_or_ps(a, b); }
+static inline f8 f8_xor(f8 a, f8 b) { return _mm256_xor_ps(a, b); }
+static inline f8 f8_gt(f8 a, f8 b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+static inline f8 f8_lt(f8 a, f8 b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+static inline f8 f8_eq(f8 a, f8 b) { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+static inline f8 f8_neq(f8 a, f8 b) { return _mm256_cmp_ps(a, b, _CMP_NEQ_UQ); }
+#elif MATHF_SIMD_SSE2
+typedef struct {
+    __m128 lo, hi;
+} f8;
+
+static inline f8 f8_load(const float* p) {
+    return (f8){_mm_loadu_ps(p), _mm_loadu_ps(p + 4)};
+}
+static inline void f8_store(float* p, f8 v) {
+    _mm_storeu_ps(p, v.lo);
+    _mm_storeu_ps(p + 4, v.hi);
+}
+static inline f8 f8_splat(float s) { return (f8){_mm_set1_ps(s), _mm_set1_ps(s)}; }
+static inline f8 f8_add(f8 a, f8 b) {
+    return (f8){_mm_add_ps(a.lo, b.lo), _mm_add_ps(a.hi, b.hi)};
+}
+static inline f8 f8_mul(f8 a, f8 b) {
+    return (f8){_mm_mul_ps(a.lo, b.lo), _mm_mul_ps(a.hi, b.hi)};
+}
+static inline f8 f8_div(f8 a, f8 b) {
+    return (f8){_mm_div_ps(a.lo, b.lo), _mm_div_ps(a.hi, b.hi)};
+}
+static inline f8 f8_sqrt(f8 a) {
+    return (f8){_mm_sqrt_ps(a.lo), _mm_sqrt_ps(a.hi)};
+}
+static inline f8 f8_select_nonzero(f8 a, f8 m) {
+    __m128 zero = _mm_setzero_ps();
+    return (f8){_mm_and_ps(a.lo, _mm_cmpneq_ps(m.lo, zero)),
+                _mm_and_ps(a.hi, _mm_cmpneq_ps(m.hi, zero))};
+}
+static inline uint32_t f8_lt_zero(f8 a) {
+    __m128 zero = _mm_setzero_ps();
+    return (uint32_t)(_mm_movemask_ps(_mm_cmplt_ps(a.lo, zero)) |
+                      _mm_movemask_ps(_mm_cmplt_ps(a.hi, zero)) << 4);
+}
+// lane masks and bit ops, only the simd backends provide these
+#define F8_PAIR(name, op)                            \
+    static inline f8 name(f8 a, f8 b) {              \
+        return (f8){op(a.lo, b.lo), op(a.hi, b.hi)}; \
+    }
+F8_PAIR(f8_sub, _mm_sub_ps)
+F8_PAIR(f8_and, _mm_and_ps)
+F8_PAIR(f8_andnot, _mm_andnot_ps)
+F8_PAIR(f8_or, _mm_or_ps)
+F8_PAIR(f8_xor, _mm_xor_ps)
+F8_PAIR(f8_gt, _mm_cmpgt_ps)
+F8_PAIR(f8_lt, _mm_cmplt_ps)
+F8_PAIR(f8_eq, _mm_cmpeq_ps)
+F8_PAIR(f8_neq, _mm_cmpneq_ps)
+#undef F8_PAIR
+static inline f8 f8_rsqrt(f8 a) {
+    return (f8){_mm_rsqrt_ps(a.lo), _mm_rsqrt_ps(a.hi)};
+}
+#else
+typedef struct {
+    float v[MATHF_LANES];
+} f8;
+
+static inline f8 f8_load(const float* p) {
+    f8 r;
+    for (int i = 0; i < MATHF_LANES; ++i) r.v[i] = p[i];
+    return r;
+}
+static inline void f8_store(float* p, f8 a) {
+    for (int i = 0; i < MATHF_LANES; ++i) p[i] = a.v[i];
+}
+static inline f8 f8_splat(float s) {
+    f8 r;
+    for (int i = 0; i < MATHF_LANES; ++i) r.v[i] = s;
+    return r;
+}
+static inline f8 f8_add(f8 a, f8 b) {
+    for (int i = 0; i < MATHF_LANES; ++i) a.v[i] += b.v[i];
+    return a;
+}
+static inline f8 f8_mul(f8 a, f8 b) {
+    for (int i = 0; i < MATHF_LANES; ++i) a.v[i] *= b.v[i];
+    return a;
+}
+static inline f8 f8_div(f8 a, f8 b) {
+    for (int i = 0; i < MATHF_LANES; ++i) a.v[i] /= b.v[i];
+    return a;
+}
+static inline f8 f8_sqrt(f8 a) {
+    for (int i = 0; i < MATHF_LANES; ++i) a.v[i] = sqrtf(a.v[i]);
+    return a;
+}
+static inline f8 f8_select_nonzero(f8 a, f8 m) {
+    for (int i = 0; i < MATHF_LANES; ++i) a.v[i] = m.v[i] != 0.0f ? a.v[i] : 0.0f;
+    return a;
+}
+static inline uint32_t f8_lt_zero(f8 a) {
+    uint32_t mask = 0;
+    for (int i = 0; i < MATHF_LANES; ++i) mask |= (uint32_t)(a.v[i] < 0.0f) << i;
+    return mask;
+}
+#endif  // MATHF_SIMD_AVX
+
+void v3x8_pack(const vec3* src, uint32_t count, vec3x8* dst) {
+    for (uint32_t i = 0; i < count; i += MATHF_LANES) {
+        vec3x8*  pack = &dst[i / MATHF_LANES];
+        uint32_t n = count - i < MATHF_LANES ? count - i : MATHF_LANES;
+        for (uint32_t l = 0; l < MATHF_LANES; ++l) {
+            vec3 v = l < n ? src[i + l] : (vec3){0.0f, 0.0f, 0.0f};
+            pack->x[l] = v.x;
+            pack->y[l] = v.y;
+            pack->z[l] = v.z;
+        }
+    }
+}
+
+void v3x8_unpack(const vec3x8* src, uint32_t count, vec3* dst) {
+    for (uint32_t i = 0; i < count; ++i) {
+        const vec3x8* pack = &src[i / MATHF_LANES];
+        uint32_t      l = i % MATHF_LANES;
+        dst[i] = (vec3){pack->x[l], pack->y[l], pack->z[l]};
+    }
+}
+
+void v4x8_unpack(const vec4x8* src, uint32_t count, vec4* dst) {
+    for (uint32_t i = 0; i < count; ++i) {
+        const vec4x8* pack = &src[i / MATHF_LANES];
+        uint32_t      l = i % MATHF_LANES;
+        dst[i] = (vec4){pack->x[l], pack->y[l], pack->z[l], pack->w[l]};
+    }
+}
+
+void v3x8_transform_points(const mat4* m, const vec3x8* src, vec4x8* dst,
+                           uint32_t pack_count) {
+    // one splat per matrix element, hoisted out of the loop
+    f8 c[16];
+    for (int i = 0; i < 16; ++i) c[i] = f8_splat(m->m[i]);
+
+    for (uint32_t p = 0; p < pack_count; ++p) {
+        f8 x = f8_load(src[p].x);
+        f8 y = f8_load(src[p].y);
+        f8 z = f8_load(src[p].z);
+        float* out[4] = {dst[p].x, dst[p].y, dst[p].z, dst[p].w};
+        for (int row = 0; row < 4; ++row) {
+            f8 r = f8_mul(c[row], x);
+            r = f8_add(r, f8_mul(c[4 + row], y));
+            r = f8_add(r, f8_mul(c[8 + row], z));
+            r = f8_add(r, c[12 + row]);
+            f8_store(out[row], r);
+        }
+    }
+}
+
+void v3x8_normalize(const vec3x8* src, vec3x8* dst, uint32_t pack_count) {
+    for (uint32_t p = 0; p < pack_count; ++p) {
+        f8 x = f8_load(src[p].x);
+        f8 y = f8_load(src[p].y);
+        f8 z = f8_load(src[p].z);
+        f8 len = f8_mul(x, x);
+        len = f8_add(len, f8_mul(y, y));
+        len = f8_add(len, f8_mul(z, z));
+        len = f8_sqrt(len);
+        f8_store(dst[p].x, f8_select_nonzero(f8_div(x, len), len));
+        f8_store(dst[p].y, f8_select_nonzero(f8_div(y, len), len));
+        f8_store(dst[p].z, f8_select_nonzero(f8_div(z, len), len));
+    }
+}
+
+// Frustum
+//
+// planes straight out of the view projection rows (gribb/hartmann), for the
+// [0, 1] clip depth mat4_perspective produces. each plane is normalized so
+// sphere radii compare against true distances
+frustum frustum_from_mat4(mat4 view_proj) {
+    const float* m = view_proj.m;
+    vec4         r0 = {m[0], m[4], m[8], m[12]};
+    vec4         r1 = {m[1], m[5], m[9], m[13]};
+    vec4         r2 = {m[2], m[6], m[10], m[14]};
+    vec4         r3 = {m[3], m[7], m[11], m[15]};
+
+    frustum f;
+    f.planes[FRUSTUM_PLANE_LEFT] = v4_add(r3, r0);
+    f.planes[FRUSTUM_PLANE_RIGHT] = v4_sub(r3, r0);
+    f.planes[FRUSTUM_PLANE_BOTTOM] = v4_add(r3, r1);
+    f.planes[FRUSTUM_PLANE_TOP] = v4_sub(r3, r1);
+    f.planes[FRUSTUM_PLANE_NEAR] = r2;
+    f.planes[FRUSTUM_PLANE_FAR] = v4_sub(r3, r2);
+    for (int i = 0; i < FRUSTUM_PLANE_COUNT; ++i) {
+        vec4  p = f.planes[i];
+        float len = sqrtf(p.x * p.x + p.y * p.y + p.z * p.z);
+        if (len != 0.0f) f.planes[i] = v4_scale(p, 1.0f / len);
+    }
+    return f;
+}
+
+int frustum_test_sphere(const frustum* f, vec3 center, float radius) {
+    for (int i = 0; i < FRUSTUM_PLANE_COUNT; ++i) {
+        vec4  p = f->planes[i];
+        float dist = p.x * center.x + p.y * center.y + p.z * center.z + p.w;
+        if (dist + radius < 0.0f) return 0;
+    }
+    return 1;
+}
+
+// the box's projected radius onto the plane normal is sum(|n| * extent)
+int frustum_test_aabb(const frustum* f, vec3 center, vec3 extent) {
+    for (int i = 0; i < FRUSTUM_PLANE_COUNT; ++i) {
+        vec4  p = f->planes[i];
+        float dist = p.x * center.x + p.y * center.y + p.z * center.z + p.w;
+        float r = fabsf(p.x) * extent.x + fabsf(p.y) * extent.y +
+                  fabsf(p.z) * extent.z;
+        if (dist + r < 0.0f) return 0;
+    }
+    return 1;
+}
+
+// appends pack p's surviving lanes to visible in ascending order
+static inline uint32_t frustum_emit(uint32_t outside, uint32_t p, uint32_t count,
+                                    uint32_t* visible, uint32_t n) {
+    uint32_t base = p * MATHF_LANES;
+    uint32_t live = count - base < MATHF_LANES ? (1u << (count - base)) - 1 : 0xff;
+    uint32_t keep = ~outside & live;
+    while (keep) {
+        visible[n++] = base + (uint32_t)__builtin_ctz(keep);
+        keep &= keep - 1;
+    }
+    return n;
+}
+
+uint32_t frustum_cull_spheres(const frustum* f, const vec3x8* centers,
+                              const float* radii, uint32_t count,
+                              uint32_t* visible) {
+    f8 px[FRUSTUM_PLANE_COUNT], py[FRUSTUM_PLANE_COUNT];
+    f8 pz[FRUSTUM_PLANE_COUNT], pw[FRUSTUM_PLANE_COUNT];
+    for (int i = 0; i < FRUSTUM_PLANE_COUNT; ++i) {
+        px[i] = f8_splat(f->planes[i].x);
+        py[i] = f8_splat(f->planes[i].y);
+        pz[i] = f8_splat(f->planes[i].z);
+        pw[i] = f8_splat(f->planes[i].w);
+    }
+
+    uint32_t n = 0;
+    for (uint32_t p = 0; p < mathf_pack_count(count); ++p) {
+        f8       x = f8_load(centers[p].x);
+        f8       y = f8_load(centers[p].y);
+        f8       z = f8_load(centers[p].z);
+        f8       r = f8_load(&radii[p * MATHF_LANES]);
+        uint32_t outside = 0;
+        for (int i = 0; i < FRUSTUM_PLANE_COUNT; ++i) {
+            f8 d = f8_mul(px[i], x);
+            d = f8_add(d, f8_mul(py[i], y));
+            d = f8_add(d, f8_mul(pz[i], z));
+            d = f8_add(d, pw[i]);
+            outside |= f8_lt_zero(f8_add(d, r));
+        }
+        n = frustum_emit(outside, p, count, visible, n);
+    }
+    return n;
+}
+
+uint32_t frustum_cull_aabbs(const frustum* f, const vec3x8* centers,
+                            const vec3x8* extents, uint32_t count,
+                            uint32_t* visible) {
+    f8 px[FRUSTUM_PLANE_COUNT], py[FRUSTUM_PLANE_COUNT];
+    f8 pz[FRUSTUM_PLANE_COUNT], pw[FRUSTUM_PLANE_COUNT];
+    f8 ax[FRUSTUM_PLANE_COUNT], ay[FRUSTUM_PLANE_COUNT], az[FRUSTUM_PLANE_COUNT];
+    for (int i = 0; i < FRUSTUM_PLANE_COUNT; ++i) {
+        vec4 pl = f->planes[i];
+        px[i] = f8_splat(pl.x);
+        py[i] = f8_splat(pl.y);
+        pz[i] = f8_splat(pl.z);
+        pw[i] = f8_splat(pl.w);
+        ax[i] = f8_splat(fabsf(pl.x));
+        ay[i] = f8_splat(fabsf(pl.y));
+        az[i] = f8_splat(fabsf(pl.z));
+    }
+
+    uint32_t n = 0;
+    for (uint32_t p = 0; p < mathf_pack_count(count); ++p) {
+        f8       x = f8_load(centers[p].x);
+        f8       y = f8_load(centers[p].y);
+        f8       z = f8_load(centers[p].z);
+        f8       ex = f8_load(extents[p].x);
+        f8       ey = f8_load(extents[p].y);
+        f8       ez = f8_load(extents[p].z);
+        uint32_t outside = 0;
+        for (int i = 0; i < FRUSTUM_PLANE_COUNT; ++i) {
+            f8 d = f8_mul(px[i], x);
+            d = f8_add(d, f8_mul(py[i], y));
+            d = f8_add(d, f8_mul(pz[i], z));
+            d = f8_add(d, pw[i]);
+            f8 r = f8_mul(ax[i], ex);
+            r = f8_add(r, f8_mul(ay[i], ey));
+            r = f8_add(r, f8_mul(az[i], ez));
+            outside |= f8_lt_zero(f8_add(d, r));
+        }
+        n = frustum_emit(outside, p, count, visible, n);
+    }
+    return n;
+}
+
+// the mask kernels run frustum by frustum over blocks of packs small enough to
+// stay in l1, so each frustum's planes are splatted once per block instead of
+// once per pack. results gather as one byte per lane: bit v & 7 of byte l in
+// acc[v >> 3] is lane l against frustum v
+#define FRUSTUM_MASK_BLOCK 32
+
+// bit l of bits to bit 0 of byte l
+static inline uint64_t frustum_spread(uint32_t bits) {
+    uint64_t x = bits & 0xff;
+    x = (x | x << 28) & 0x0000000f0000000fULL;
+    x = (x | x << 14) & 0x0003000300030003ULL;
+    x = (x | x << 7) & 0x0101010101010101ULL;
+    return x;
+}
+
+// transposes pack p's bytes back into per object masks, the padding dropped
+static inline void frustum_store_masks(const uint64_t* acc, uint32_t p,
+                                       uint32_t count, uint32_t* masks) {
+    uint32_t base = p * MATHF_LANES;
+    uint32_t lanes = count - base < MATHF_LANES ? count - base : MATHF_LANES;
+    for (uint32_t l = 0; l < lanes; ++l) {
+        uint32_t m = 0;
+        for (uint32_t g = 0; g < FRUSTUM_MASK_MAX / 8; ++g) {
+            m |= (uint32_t)(acc[g] >> (l * 8) & 0xff) << (g * 8);
+        }
+        masks[base + l] = m;
+    }
+}
+
+void frustum_mask_spheres(const frustum* frusta, uint32_t frusta_count,
+                          const vec3x8* centers, const float* radii,
+                          uint32_t count, uint32_t* masks) {
+    const uint32_t packs = mathf_pack_count(count);
+    if (frusta_count > FRUSTUM_MASK_MAX) frusta_count = FRUSTUM_MASK_MAX;
+    for (uint32_t first = 0; first < packs; first += FRUSTUM_MASK_BLOCK) {
+        uint32_t block = packs - first < FRUSTUM_MASK_BLOCK ? packs - first
+                                                            : FRUSTUM_MASK_BLOCK;
+        uint64_t acc[FRUSTUM_MASK_BLOCK][FRUSTUM_MASK_MAX / 8] = {{0}};
+        for (uint32_t v = 0; v < frusta_count; ++v) {
+            f8 px[FRUSTUM_PLANE_COUNT], py[FRUSTUM_PLANE_COUNT];
+            f8 pz[FRUSTUM_PLANE_COUNT], pw[FRUSTUM_PLANE_COUNT];
+            for (int i = 0; i < FRUSTUM_PLANE_COUNT; ++i) {
+                px[i] = f8_splat(frusta[v].planes[i].x);
+                py[i] = f8_splat(frusta[v].planes[i].y);
+                pz[i] = f8_splat(frusta[v].planes[i].z);
+                pw[i] = f8_splat(frusta[v].planes[i].w);
+            }
+            for (uint32_t b = 0; b < block; ++b) {
+                uint32_t p = first + b;
+                f8       x = f8_load(centers[p].x);
+                f8       y = f8_load(centers[p].y);
+                f8       z = f8_load(centers[p].z);
+                f8       r = f8_load(&radii[p * MATHF_LANES]);
+                uint32_t outside = 0;
+                for (int i = 0; i < FRUSTUM_PLANE_COUNT; ++i) {
+                    f8 d = f8_mul(px[i], x);
+                    d = f8_add(d, f8_mul(py[i], y));
+                    d = f8_add(d, f8_mul(pz[i], z));
+                    d = f8_add(d, pw[i]);
+                    outside |= f8_lt_zero(f8_add(d, r));
+                }
+                acc[b][v >> 3] |= frustum_spread(~outside) << (v & 7);
+            }
+        }
+        for (uint32_t b = 0; b < block; ++b) {
+            frustum_store_masks(acc[b], first + b, count, masks);
+        }
+    }
+}
+
+void frustum_mask_aabbs(const frustum* frusta, uint32_t frusta_count,
+                        const vec3x8* centers, const vec3x8* extents,
+                        uint32_t count, uint32_t* masks) {
+    const uint32_t packs = mathf_pack_count(count);
+    if (frusta_count > FRUSTUM_MASK_MAX) frusta_count = FRUSTUM_MASK_MAX;
+    for (uint32_t first = 0; first < packs; first += FRUSTUM_MASK_BLOCK) {
+        uint32_t block = packs - first < FRUSTUM_MASK_BLOCK ? packs - first
+                                                            : FRUSTUM_MASK_BLOCK;
+        uint64_t acc[FRUSTUM_MASK_BLOCK][FRUSTUM_MASK_MAX / 8] = {{0}};
+        for (uint32_t v = 0; v < frusta_count; ++v) {
+            f8 px[FRUSTUM_PLANE_COUNT], py[FRUSTUM_PLANE_COUNT];
+            f8 pz[FRUSTUM_PLANE_COUNT], pw[FRUSTUM_PLANE_COUNT];
+            f8 ax[FRUSTUM_PLANE_COUNT], ay[FRUSTUM_PLANE_COUNT];
+            f8 az[FRUSTUM_PLANE_COUNT];
+            for (int i = 0; i < FRUSTUM_PLANE_COUNT; ++i) {
+                vec4 pl = frusta[v].planes[i];
+                px[i] = f8_splat(pl.x);
+                py[i] = f8_splat(pl.y);
+                pz[i] = f8_splat(pl.z);
+                pw[i] = f8_splat(pl.w);
+                ax[i] = f8_splat(fabsf(pl.x));
+                ay[i] = f8_splat(fabsf(pl.y));
+                az[i] = f8_splat(fabsf(pl.z));
+            }
+            for (uint32_t b = 0; b < block; ++b) {
+                uint32_t p = first + b;
+                f8       x = f8_load(centers[p].x);
+                f8       y = f8_load(centers[p].y);
+                f8       z = f8_load(centers[p].z);
+                f8       ex = f8_load(extents[p].x);
+                f8       ey = f8_load(extents[p].y);
+                f8       ez = f8_load(extents[p].z);
+                uint32_t outside = 0;
+                for (int i = 0; i < FRUSTUM_PLANE_COUNT; ++i) {
+                    f8 d = f8_mul(px[i], x);
+                    d = f8_add(d, f8_mul(py[i], y));
+                    d = f8_add(d, f8_mul(pz[i], z));
+                    d = f8_add(d, pw[i]);
+                    f8 r = f8_mul(ax[i], ex);
+                    r = f8_add(r, f8_mul(ay[i], ey));
+                    r = f8_add(r, f8_mul(az[i], ez));
+                    outside |= f8_lt_zero(f8_add(d, r));
+                }
+                acc[b][v >> 3] |= frustum_spread(~outside) << (v & 7);
+            }
+        }
+        for (uint32_t b = 0; b < block; ++b) {
+            frustum_store_masks(acc[b], first + b, count, masks);
+        }
+    }
+}
+
+// Fast approximations
+//
+// sin/cos: cody-waite reduction by pi/2 into [-pi/4, pi/4] and the cephes
+// single precision polynomials. the quadrant comes out of k with float ops
+// only (avx has no 256 bit integer ops), so the batch kernels give the same
+// bits as the scalar versions
+#define FAST_TWO_OVER_PI 0.636619772367581343f
+#define FAST_PIO2_1 1.5703125f  // pi/2 in three parts, k * part exact
+#define FAST_PIO2_2 4.837512969970703125e-4f
+#define FAST_PIO2_3 7.54978995489188216e-8f
+#define FAST_ROUND_MAGIC 12582912.0f  // 1.5 * 2^23: (v + m) - m rounds v
+#define FAST_PI 3.14159265358979323846f
+#define FAST_HALF_PI 1.57079632679489661923f
+#define FAST_QUARTER_PI 0.785398163397448309616f
+#define FAST_TAN_PI_8 0.414213562373095048802f
+
+static inline float fast_sin_poly(float r, float z) {
+    return ((-1.9515295891e-4f * z + 8.3321608736e-3f) * z - 1.6666654611e-1f) *
+               z * r +
+           r;
+}
+
+static inline float fast_cos_poly(float z) {
+    float y =
+        ((2.443315711809948e-5f * z - 1.388731625493765e-3f) * z +
+         4.166664568298827e-2f) *
+        z * z;
+    y -= 0.5f * z;
+    return y + 1.0f;
+}
+
+// atan on [-tan(pi/8), tan(pi/8)]
+static inline float fast_atan_poly(float t, float z) {
+    return (((8.05374449538e-2f * z - 1.38776856032e-1f) * z + 1.99777106478e-1f) *
+                z -
+            3.33329491539e-1f) *
+               z * t +
+           t;
+}
+
+void fast_sincos(float x, float* s, float* c) {
+    float k = (x * FAST_TWO_OVER_PI + FAST_ROUND_MAGIC) - FAST_ROUND_MAGIC;
+    float r = ((x - k * FAST_PIO2_1) - k * FAST_PIO2_2) - k * FAST_PIO2_3;
+    float z = r * r;
+    float ps = fast_sin_poly(r, z);
+    float pc = fast_cos_poly(z);
+
+    switch ((int32_t)k & 3) {
+        case 0: *s = ps, *c = pc; break;
+        case 1: *s = pc, *c = -ps; break;
+        case 2: *s = -ps, *c = -pc; break;
+        default: *s = -pc, *c = ps; break;
+    }
+}
+
+float fast_sin(float x) {
+    float s, c;
+    fast_sincos(x, &s, &c);
+    return s;
+}
+
+float fast_cos(float x) {
+    float s, c;
+    fast_sincos(x, &s, &c);
+    return c;
+}
+
+float fast_rsqrt(float x) {
+#if MATHF_SIMD_SSE2
+    float y = _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(x)));
+    float h = 0.5f * x;
+    return y * (1.5f - h * y * y);
+#else
+    return 1.0f / sqrtf(x);
+#endif  // MATHF_SIMD_SSE2
+}
+
+float fast_atan2(float y, float x) {
+    float ax = fabsf(x), ay = fabsf(y);
+    float mx = ax > ay ? ax : ay;
+    float mn = ax > ay ? ay : ax;
+    float a = mx != 0.0f ? mn / mx : 0.0f;
+
+    float t = a, base = 0.0f;
+    if (a > FAST_TAN_PI_8) {
+        t = (a - 1.0f) / (a + 1.0f);
+        base = FAST_QUARTER_PI;
+    }
+    float p = fast_atan_poly(t, t * t) + base;
+    if (ay > ax) p = FAST_HALF_PI - p;
+    if (x < 0.0f) p = FAST_PI - p;
+    return copysignf(p, y);
+}
+
+#if MATHF_SIMD_SSE2
+static inline f8 f8_select(f8 mask, f8 a, f8 b) {
+    return f8_or(f8_and(mask, a), f8_andnot(mask, b));
+}
+
+static inline f8 f8_round(f8 v) {
+    f8 magic = f8_splat(FAST_ROUND_MAGIC);
+    return f8_sub(f8_add(v, magic), magic);
+}
+
+static inline void f8_sincos(f8 x, f8* s, f8* c) {
+    f8 k = f8_round(f8_mul(x, f8_splat(FAST_TWO_OVER_PI)));
+    f8 r = f8_sub(x, f8_mul(k, f8_splat(FAST_PIO2_1)));
+    r = f8_sub(r, f8_mul(k, f8_splat(FAST_PIO2_2)));
+    r = f8_sub(r, f8_mul(k, f8_splat(FAST_PIO2_3)));
+    f8 z = f8_mul(r, r);
+
+    f8 ps = f8_mul(f8_splat(-1.9515295891e-4f), z);
+    ps = f8_mul(f8_add(ps, f8_splat(8.3321608736e-3f)), z);
+    ps = f8_mul(f8_mul(f8_sub(ps, f8_splat(1.6666654611e-1f)), z), r);
+    ps = f8_add(ps, r);
+
+    f8 pc = f8_mul(f8_splat(2.443315711809948e-5f), z);
+    pc = f8_mul(f8_sub(pc, f8_splat(1.388731625493765e-3f)), z);
+    pc = f8_mul(f8_mul(f8_add(pc, f8_splat(4.166664568298827e-2f)), z), z);
+    pc = f8_sub(pc, f8_mul(f8_splat(0.5f), z));
+    pc = f8_add(pc, f8_splat(1.0f));
+
+    // k mod 4 as the fraction of k / 4: 0, .25, .5 or .75. the -0.375 makes
+    // the rounding a floor for those four cases
+    f8 q = f8_mul(k, f8_splat(0.25f));
+    f8 frac = f8_sub(q, f8_round(f8_sub(q, f8_splat(0.375f))));
+    f8 odd = f8_or(f8_eq(frac, f8_splat(0.25f)), f8_eq(frac, f8_splat(0.75f)));
+    f8 sin_neg = f8_gt(frac, f8_splat(0.375f));
+    f8 cos_neg =
+        f8_and(f8_gt(frac, f8_splat(0.125f)), f8_lt(frac, f8_splat(0.625f)));
+    f8 sign = f8_splat(-0.0f);
+    *s = f8_xor(f8_select(odd, pc, ps), f8_and(sin_neg, sign));
+    *c = f8_xor(f8_select(odd, ps, pc), f8_and(cos_neg, sign));
+}
+
+void fast_sincos_batch(const float* x, float* s, float* c, uint32_t count) {
+    uint32_t i = 0;
+    for (; i + MATHF_LANES <= count; i += MATHF_LANES) {
+        f8 vs, vc;
+        f8_sincos(f8_load(&x[i]), &vs, &vc);
+        f8_store(&s[i], vs);
+        f8_store(&c[i], vc);
+    }
+    for (; i < count; ++i) fast_sincos(x[i], &s[i], &c[i]);
+}
+
+void fast_rsqrt_batch(const float* x, float* out, uint32_t count) {
+    uint32_t i = 0;
+    for (; i + MATHF_LANES <= count; i += MATHF_LANES) {
+        f8 v = f8_load(&x[i]);
+        f8 y = f8_rsqrt(v);
+        f8 h = f8_mul(f8_splat(0.5f), v);
+        f8 n = f8_sub(f8_splat(1.5f), f8_mul(f8_mul(h, y), y));
+        f8_store(&out[i], f8_mul(y, n));
+    }
+    for (; i < count; ++i) out[i] = fast_rsqrt(x[i]);
+}
+
+void fast_atan2_batch(const float* y, const float* x, float* out, uint32_t count) {
+    f8       sign = f8_splat(-0.0f);
+    f8       zero = f8_splat(0.0f);
+    uint32_t i = 0;
+    for (; i + MATHF_LANES <= count; i += MATHF_LANES) {
+        f8 vy = f8_load(&y[i]);
+        f8 vx = f8_load(&x[i]);
+        f8 ax = f8_andnot(sign, vx);
+        f8 ay = f8_andnot(sign, vy);
+        f8 x_wins = f8_gt(ax, ay);
+        f8 mx = f8_select(x_wins, ax, ay);
+        f8 mn = f8_select(x_wins, ay, ax);
+        f8 a = f8_and(f8_div(mn, mx), f8_neq(mx, zero));
+
+        f8 one = f8_splat(1.0f);
+        f8 big = f8_gt(a, f8_splat(FAST_TAN_PI_8));
+        f8 t = f8_select(big, f8_div(f8_sub(a, one), f8_add(a, one)), a);
+        f8 base = f8_and(big, f8_splat(FAST_QUARTER_PI));
+        f8 z = f8_mul(t, t);
+
+        f8 p = f8_mul(f8_splat(8.05374449538e-2f), z);
+        p = f8_mul(f8_sub(p, f8_splat(1.38776856032e-1f)), z);
+        p = f8_mul(f8_add(p, f8_splat(1.99777106478e-1f)), z);
+        p = f8_mul(f8_mul(f8_sub(p, f8_splat(3.33329491539e-1f)), z), t);
+        p = f8_add(f8_add(p, t), base);
+
+        p = f8_select(f8_gt(ay, ax), f8_sub(f8_splat(FAST_HALF_PI), p), p);
+        p = f8_select(f8_lt(vx, zero), f8_sub(f8_splat(FAST_PI), p), p);
+        f8_store(&out[i], f8_or(p, f8_and(vy, sign)));
+    }
+    for (; i < count; ++i) out[i] = fast_atan2(y[i], x[i]);
+}
+#else
+void fast_sincos_batch(const float* x, float* s, float* c, uint32_t count) {
+    for (uint32_t i = 0; i < count; ++i) fast_sincos(x[i], &s[i], &c[i]);
+}
+
+void fast_rsqrt_batch(const float* x, float* out, uint32_t count) {
+    for (uint32_t i = 0; i < count; ++i) out[i] = fast_rsqrt(x[i]);
+}
+
+void fast_atan2_batch(const float* y, const float* x, float* out, uint32_t count) {
+    for (uint32_t i = 0; i < count; ++i) out[i] = fast_atan2(y[i], x[i]);
+}
+#endif  // MATHF_SIMD_SSE2
@@ -17,6 +17,17 @@ void rdev_init(rdev_params* params) {
     debug_log("initializing rdev...\n");
     VkResult result = VK_SUCCESS;
     vk.window_api = params->wnd_api;
+    vk.scratch = params->scratch_allocator;
+    if (!vk.scratch) {
+        vk.scratch = allocator_create_ex(ALLOCATOR_TYPE_STACK, MEM_TAG_RENDERER,
+                                         VSCRATCH_SIZE, ALLOCATOR_FLAG_VIRTUAL);
+        vk.owns_scratch = 1;
+    }
+    debug_assert(vk.scratch && vk.scratch->type == ALLOCATOR_TYPE_STACK);
+    if (params->allocator) {
+        result = vcreate_host_allocator(&vk, params->allocator);
+        debug_assert(result == VK_SUCCESS);
+    }
     vcreate_instance(&vk);
 
 #ifdef _DEBUG
@@ -64,6 +75,12 @@ void rdev_terminate() {
     vdestroy_dbg_msgr(&vk, dbg_msgr);
 #endif  //_DEBUG
     vkDestroyInstance(vk.instance, vk.allocator);
+    vdestroy_host_allocator(&vk);
+    if (vk.owns_scratch) {
+        adestroy(vk.scratch);
+    }
+    vk.scratch = NULL;
+    vk.owns_scratch = 0;
 }
 
 void rdev_create_swapchain(void* wnd_native, uint32_t w, uint32_t h) {
@@ -80,7 +97,8 @@ void rdev_create_swapchain(void* wnd_native, uint32_t w, uint32_t h) {
         } break;
     }
     debug_assert(result == VK_SUCCESS);
-    VkSurfaceFormatKHR fmt = vutl_find_surface_format(vk.dev.physical, vk.surface);
+    VkSurfaceFormatKHR fmt =
+        vutl_find_surface_format(vk.dev.physical, vk.surface, vk.scratch);
     VkFormat           depth_fmt = vutl_find_depth_format(vk.dev.physical);
     if (depth_fmt == VK_FORMAT_UNDEFINED) {
         debug_log("failed to find depth format!\n");
@@ -88,7 +106,8 @@ void rdev_create_swapchain(void* wnd_native, uint32_t w, uint32_t h) {
         return;
     }
 
-    VkPresentModeKHR present = vutl_find_present_mode(vk.dev.physical, vk.surface);
+    VkPresentModeKHR present =
+        vutl_find_present_mode(vk.dev.physical, vk.surface, vk.scratch);
     vk.swapchain.surface_fmt = fmt;
     vk.swapchain.depth_fmt = depth_fmt;
     vk.swapchain.present_mode = present;
@@ -139,7 +158,12 @@ rpipe_id rdev_create_pipeline(rpipe_params* params) {
     vpipe* pipe = &vk.pipes[0];  // only using a single pipeline for now
 
     uint32_t shader_count = params->shader_stage_count;
-    vshader  shaders[shader_count];
+    atemp    temp = atemp_begin(vk.scratch);
+    vshader* shaders = aalloc_array(vk.scratch, vshader, shader_count);
+    if (!shaders) {
+        atemp_end(temp);
+        return RDEV_INVALID_ID;
+    }
     for (uint32_t i = 0; i < params->shader_stage_count; i++) {
         shaders[i].type = params->shader_stages[i].type;
         shaders[i].code = params->shader_stages[i].code;
@@ -147,12 +171,16 @@ rpipe_id rdev_create_pipeline(rpipe_params* params) {
     }
     VkResult result;
     result = vcreate_shader_modules(&vk, shaders, shader_count);
-    if (result != VK_SUCCESS) return RDEV_INVALID_ID;
+    if (result != VK_SUCCESS) {
+        atemp_end(temp);
+        return RDEV_INVALID_ID;
+    }
 
     result = vcreate_pipeline(&vk, pipe, params, shaders);
+    vdestroy_shader_modules(&vk, shaders, params->shader_stage_count);
+    atemp_end(temp);
     if (result != VK_SUCCESS) return RDEV_INVALID_ID;
 
-    vdestroy_shader_modules(&vk, shaders, params->shader_stage_count);
     debug_log("graphics pipeline created!\n");
     // todo:
     return 0;
@@ -263,6 +291,10 @@ rcmd* rdev_begin() {
     vkWaitForFences(vk.dev.handle, 1, &vk.inflight_fences[vk.current_frame],
                     VK_TRUE, UINT64_MAX);
     vkResetFences(vk.dev.handle, 1, &vk.inflight_fences[vk.current_frame]);
+    vreset_host_frame(&vk);
+    if (vk.owns_scratch) {
+        areset(vk.scratch, 0);
+    }
     VkResult result =
         vkAcquireNextImageKHR(vk.dev.handle, vk.swapchain.handle, UINT64_MAX,
                               vk.image_available_semaphores[vk.current_frame],
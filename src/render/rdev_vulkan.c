@@ -1,5 +1,6 @@
 #include "rdev_vulkan.h"
 
+#include <stdalign.h>
 #include <stdint.h>
 #include <string.h>
 
@@ -15,6 +16,162 @@
 #define VULKAN_VALIDATION_LAYER "VK_LAYER_KHRONOS_validation"
 #define VULKAN_ENABLEMENT_COUNT 256
 
+//=========================================================
+//
+// host memory
+//
+//=========================================================
+
+// sits right before every pointer handed to the driver, vkFree gives us
+// neither the size nor the scope back
+typedef struct {
+    allocator* owner;
+    size_t     size;
+    uint32_t   offset;  // from the owner's block to the driver's pointer
+    uint32_t   scope;
+} vhost_header;
+
+static void vhost_lock(vhost_allocator* h) {
+    while (atomic_flag_test_and_set_explicit(&h->lock, memory_order_acquire)) {
+    }
+}
+
+static void vhost_unlock(vhost_allocator* h) {
+    atomic_flag_clear_explicit(&h->lock, memory_order_release);
+}
+
+static void* vhost_alloc_locked(vhost_allocator* h, size_t size, size_t align,
+                                VkSystemAllocationScope scope) {
+    if (align < alignof(vhost_header)) align = alignof(vhost_header);
+    size_t offset = (sizeof(vhost_header) + align - 1) & ~(align - 1);
+
+    // command scoped memory never outlives the call that asked for it, so it
+    // is bumped out of the frame arena and never individually freed
+    allocator* owner = h->general;
+    uint8_t*   block = NULL;
+    if (scope == VK_SYSTEM_ALLOCATION_SCOPE_COMMAND) {
+        block = aalloc_algn(h->frame, offset + size, align);
+        if (block) owner = h->frame;
+    }
+    if (!block) {
+        block = aalloc_algn(h->general, offset + size, align);
+    }
+    if (!block) {
+        debug_log("vulkan host allocation of %zu bytes failed (scope %d)\n", size,
+                  scope);
+        return NULL;
+    }
+    debug_assert(((uintptr_t)block & (align - 1)) == 0);
+
+    uint8_t*      ptr = block + offset;
+    vhost_header* header = (vhost_header*)ptr - 1;
+    header->owner = owner;
+    header->size = size;
+    header->offset = (uint32_t)offset;
+    header->scope = scope;
+
+    h->scope_live[scope] += size;
+    if (h->scope_live[scope] > h->scope_peak[scope]) {
+        h->scope_peak[scope] = h->scope_live[scope];
+    }
+    return ptr;
+}
+
+static void vhost_free_locked(vhost_allocator* h, void* ptr) {
+    vhost_header* header = (vhost_header*)ptr - 1;
+    h->scope_live[header->scope] -= header->size;
+    if (header->owner != h->frame) {
+        afree(header->owner, (uint8_t*)ptr - header->offset);
+    }
+}
+
+static void* VKAPI_PTR vhost_alloc(void* user, size_t size, size_t align,
+                                   VkSystemAllocationScope scope) {
+    vhost_allocator* h = (vhost_allocator*)user;
+    vhost_lock(h);
+    void* ptr = vhost_alloc_locked(h, size, align, scope);
+    vhost_unlock(h);
+    return ptr;
+}
+
+static void* VKAPI_PTR vhost_realloc(void* user, void* original, size_t size,
+                                     size_t align, VkSystemAllocationScope scope) {
+    vhost_allocator* h = (vhost_allocator*)user;
+    vhost_lock(h);
+    void* ptr = NULL;
+    if (!original) {
+        ptr = vhost_alloc_locked(h, size, align, scope);
+    } else if (!size) {
+        vhost_free_locked(h, original);
+    } else {
+        ptr = vhost_alloc_locked(h, size, align, scope);
+        if (ptr) {
+            size_t old_size = ((vhost_header*)original - 1)->size;
+            memcpy(ptr, original, old_size < size ? old_size : size);
+            vhost_free_locked(h, original);
+        }
+    }
+    vhost_unlock(h);
+    return ptr;
+}
+
+static void VKAPI_PTR vhost_free(void* user, void* ptr) {
+    if (!ptr) return;
+    vhost_allocator* h = (vhost_allocator*)user;
+    vhost_lock(h);
+    vhost_free_locked(h, ptr);
+    vhost_unlock(h);
+}
+
+// `general` has to honour the alignment argument (tlsf, pool); the heap
+// allocator does not
+VkResult vcreate_host_allocator(vstate* v, allocator* general) {
+    vhost_allocator* h = &v->host;
+    h->general = general;
+    h->frame = allocator_create(ALLOCATOR_TYPE_STACK, MEM_TAG_RENDERER,
+                                VHOST_FRAME_ARENA_SIZE);
+    if (!h->frame) return VK_ERROR_OUT_OF_HOST_MEMORY;
+    atomic_flag_clear(&h->lock);
+    for (uint32_t i = 0; i < VHOST_SCOPE_COUNT; i++) {
+        h->scope_live[i] = 0;
+        h->scope_peak[i] = 0;
+    }
+    v->host_callbacks = (VkAllocationCallbacks){
+        .pUserData = h,
+        .pfnAllocation = vhost_alloc,
+        .pfnReallocation = vhost_realloc,
+        .pfnFree = vhost_free,
+    };
+    v->allocator = &v->host_callbacks;
+    return VK_SUCCESS;
+}
+
+void vdestroy_host_allocator(vstate* v) {
+    vhost_allocator* h = &v->host;
+    if (!h->frame) return;
+#ifdef _DEBUG
+    static const char* scope_names[VHOST_SCOPE_COUNT] = {
+        "command", "object", "cache", "device", "instance",
+    };
+    for (uint32_t i = 0; i < VHOST_SCOPE_COUNT; i++) {
+        debug_log("vulkan host memory %-8s live %zu peak %zu\n", scope_names[i],
+                  h->scope_live[i], h->scope_peak[i]);
+    }
+#endif  // _DEBUG
+    adestroy(h->frame);
+    h->frame = NULL;
+    h->general = NULL;
+    v->allocator = NULL;
+}
+
+void vreset_host_frame(vstate* v) {
+    vhost_allocator* h = &v->host;
+    if (!h->frame) return;
+    vhost_lock(h);
+    areset(h->frame, 0);
+    vhost_unlock(h);
+}
+
 //=========================================================
 //
 // context
@@ -82,23 +239,33 @@ VkResult vcreate_device(vstate* v) {
 
     // physical device
     {
-        VkPhysicalDevice devices[pdev_count];
-        device_info      infos[pdev_count];
+        atemp             temp = atemp_begin(v->scratch);
+        VkPhysicalDevice* devices =
+            aalloc_array(v->scratch, VkPhysicalDevice, pdev_count);
+        device_info* infos = aalloc_array(v->scratch, device_info, pdev_count);
+        if (!devices || !infos) {
+            atemp_end(temp);
+            return VK_ERROR_OUT_OF_HOST_MEMORY;
+        }
         result = vkEnumeratePhysicalDevices(v->instance, &pdev_count, devices);
-        if (result != VK_SUCCESS) return result;
+        if (result != VK_SUCCESS) {
+            atemp_end(temp);
+            return result;
+        }
         const char* extensions[] = {
             VK_KHR_SWAPCHAIN_EXTENSION_NAME,
         };
         uint32_t extension_count = sizeof(extensions) / sizeof(*extensions);
         for (uint32_t i = 0; i < pdev_count; i++) {
             infos[i].device = devices[i];
-            infos[i].families = vutl_find_queue_families(devices[i], v->window_api);
+            infos[i].families =
+                vutl_find_queue_families(devices[i], v->window_api, v->scratch);
             vkGetPhysicalDeviceProperties(devices[i], &infos[i].properties);
             vkGetPhysicalDeviceFeatures(devices[i], &infos[i].features);
             vkGetPhysicalDeviceMemoryProperties(devices[i], &infos[i].mem_props);
 
-            infos[i].extension_support =
-                vutl_extensions_supported(devices[i], extensions, extension_count);
+            infos[i].extension_support = vutl_extensions_supported(
+                devices[i], extensions, extension_count, v->scratch);
         }
 
         int32_t best_score = -1;
@@ -112,6 +279,7 @@ VkResult vcreate_device(vstate* v) {
             }
         }
         if (best_index < 0 && best_score < 0) {
+            atemp_end(temp);
             return VK_ERROR_INITIALIZATION_FAILED;
         }
         v->dev.physical = devices[best_index];
@@ -126,6 +294,7 @@ VkResult vcreate_device(vstate* v) {
                   infos[best_index].families.graphics,
                   infos[best_index].families.compute,
                   infos[best_index].families.transfer);
+        atemp_end(temp);
     }
 
     // logical device
@@ -141,8 +310,7 @@ VkResult vcreate_device(vstate* v) {
         };
 
         // graphics/compute/transfer
-        const uint32_t max_queue_families = 3;
-        uint32_t       unique_families_count = 1;
+        uint32_t unique_families_count = 1;
         if (v->dev.compute_family != v->dev.graphics_family) {
             families[unique_families_count++] = v->dev.compute_family;
         }
@@ -152,7 +320,7 @@ VkResult vcreate_device(vstate* v) {
         }
 
         const float             queue_priority[] = {1.0f};
-        VkDeviceQueueCreateInfo queue_infos[max_queue_families];
+        VkDeviceQueueCreateInfo queue_infos[sizeof(families) / sizeof(*families)];
         for (uint32_t i = 0; i < unique_families_count; i++) {
             queue_infos[i].sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
             queue_infos[i].pNext = NULL;
@@ -532,9 +700,23 @@ void vdestroy_swapchainpass(vstate* v, vswapchain* sc) {
 VkResult vcreate_pipeline(vstate* v, vpipe* pipe, rpipe_params* params,
                           vshader* modules) {
     VkResult result;
+    atemp    temp = atemp_begin(v->scratch);
 
     //  =============== pipline layout
-    VkPushConstantRange push_constant_ranges[params->push_constant_count];
+    VkPushConstantRange* push_constant_ranges =
+        aalloc_array(v->scratch, VkPushConstantRange, params->push_constant_count);
+    VkPipelineShaderStageCreateInfo* shader_stages = aalloc_array(
+        v->scratch, VkPipelineShaderStageCreateInfo, params->shader_stage_count);
+    VkVertexInputBindingDescription* vertex_bindings = aalloc_array(
+        v->scratch, VkVertexInputBindingDescription, params->vertex_binding_count);
+    VkVertexInputAttributeDescription* vertex_attributes =
+        aalloc_array(v->scratch, VkVertexInputAttributeDescription,
+                     params->vertex_attribute_count);
+    if (!push_constant_ranges || !shader_stages || !vertex_bindings ||
+        !vertex_attributes) {
+        atemp_end(temp);
+        return VK_ERROR_OUT_OF_HOST_MEMORY;
+    }
     for (uint32_t i = 0; i < params->push_constant_count; i++) {
         push_constant_ranges[i].stageFlags = vutl_to_vulkan_shader_stage_flags(
             params->push_constants[i].stage_flags);
@@ -552,11 +734,13 @@ VkResult vcreate_pipeline(vstate* v, vpipe* pipe, rpipe_params* params,
     result = vkCreatePipelineLayout(v->dev.handle, &layout_info, v->allocator,
                                     &pipe->layout);
     VCHECK(result);
-    if (result != VK_SUCCESS) return result;
+    if (result != VK_SUCCESS) {
+        atemp_end(temp);
+        return result;
+    }
 
     //  =============== graphics pipline
 
-    VkPipelineShaderStageCreateInfo shader_stages[params->shader_stage_count];
     for (uint32_t i = 0; i < params->shader_stage_count; i++) {
         shader_stages[i].sType =
             VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
@@ -568,15 +752,12 @@ VkResult vcreate_pipeline(vstate* v, vpipe* pipe, rpipe_params* params,
         shader_stages[i].pSpecializationInfo = 0;
     }
 
-    VkVertexInputBindingDescription vertex_bindings[params->vertex_binding_count];
     for (uint32_t i = 0; i < params->vertex_binding_count; i++) {
         vertex_bindings[i].binding = params->vertex_bindings[i].binding;
         vertex_bindings[i].stride = params->vertex_bindings[i].stride;
         vertex_bindings[i].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
     }
 
-    VkVertexInputAttributeDescription
-        vertex_attributes[params->vertex_attribute_count];
     for (uint32_t i = 0; i < params->vertex_attribute_count; i++) {
         vertex_attributes[i].binding = params->vertex_attributes[i].binding;
         vertex_attributes[i].location = params->vertex_attributes[i].location;
@@ -681,6 +862,7 @@ VkResult vcreate_pipeline(vstate* v, vpipe* pipe, rpipe_params* params,
     result = vkCreateGraphicsPipelines(v->dev.handle, VK_NULL_HANDLE, 1,
                                        &pipeline_info, v->allocator, &pipe->handle);
     VCHECK(result);
+    atemp_end(temp);
     return result;
 }
 
@@ -690,15 +872,14 @@ void vdestroy_pipeline(vstate* v, vpipe* pipe) {
 }
 
 VkResult vcreate_shader_modules(vstate* v, vshader* shaders, uint32_t count) {
-    VkShaderModuleCreateInfo infos[count];
-    VkResult                 result;
+    VkResult result = VK_SUCCESS;
     for (uint32_t i = 0; i < count; i++) {
-        infos[i].sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-        infos[i].codeSize = shaders[i].code_size;
-        infos[i].pCode = shaders[i].code;
-        infos[i].flags = 0;
-        infos[i].pNext = 0;
-        result = vkCreateShaderModule(v->dev.handle, &infos[i], v->allocator,
+        VkShaderModuleCreateInfo info = {
+            .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+            .codeSize = shaders[i].code_size,
+            .pCode = shaders[i].code,
+        };
+        result = vkCreateShaderModule(v->dev.handle, &info, v->allocator,
                                       &shaders[i].handle);
         VCHECK(result);
         if (result != VK_SUCCESS) return result;
@@ -983,8 +1164,14 @@ VkResult vcreate_dbg_msgr(vstate* v, VkDebugUtilsMessengerEXT* m) {
     uint32_t ext_count = 0;
     int32_t  debug_extension_present = 0;
     vkEnumerateInstanceExtensionProperties(NULL, &ext_count, NULL);
-    VkExtensionProperties extensions[ext_count];
-    vkEnumerateInstanceExtensionProperties(NULL, &ext_count, extensions);
+    atemp                  temp = atemp_begin(v->scratch);
+    VkExtensionProperties* extensions =
+        aalloc_array(v->scratch, VkExtensionProperties, ext_count);
+    if (extensions) {
+        vkEnumerateInstanceExtensionProperties(NULL, &ext_count, extensions);
+    } else {
+        ext_count = 0;
+    }
     const char* dbg_ext_name = VK_EXT_DEBUG_UTILS_EXTENSION_NAME;
     for (size_t i = 0; i < ext_count; i++) {
         if (!strcmp(extensions[i].extensionName, dbg_ext_name)) {
@@ -992,6 +1179,7 @@ VkResult vcreate_dbg_msgr(vstate* v, VkDebugUtilsMessengerEXT* m) {
             break;
         }
     }
+    atemp_end(temp);
     if (!debug_extension_present) {
         return VK_FALSE;
     }
@@ -1010,7 +1198,7 @@ VkResult vcreate_dbg_msgr(vstate* v, VkDebugUtilsMessengerEXT* m) {
         debug_log("Failed to load debug messanger creation function!\n");
         return VK_FALSE;
     }
-    VkResult result = create_debug_msgr(v->instance, &dbg_ci, 0, m);
+    VkResult result = create_debug_msgr(v->instance, &dbg_ci, v->allocator, m);
     VCHECK(result);
     return result;
 }
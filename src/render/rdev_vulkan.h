@@ -1,4 +1,5 @@
 #pragma once
+#include <stdatomic.h>
 #include <vulkan/vulkan.h>
 
 #include "rtypes.h"
@@ -7,6 +8,9 @@
 #define VBUF_MAX_COUNT 128
 #define VPASS_MAX_COUNT 16
 #define VPIPE_MAX_COUNT 16
+#define VHOST_SCOPE_COUNT 5  // VK_SYSTEM_ALLOCATION_SCOPE_COMMAND..INSTANCE
+#define VHOST_FRAME_ARENA_SIZE mmega(1)
+#define VSCRATCH_SIZE mmega(64)  // reserved, committed on demand
 
 #define VCHECK(x) debug_assert((x) == VK_SUCCESS);
 #define VCLAMP(x, min, max) (x < min ? min : x > max ? max : x)
@@ -84,8 +88,21 @@ typedef struct {
     uint32_t           image_count;
 } vswapchain;
 
+// backs VkAllocationCallbacks with engine allocators
 typedef struct {
-    VkAllocationCallbacks* allocator;
+    allocator*  general;  // object, cache, device and instance scopes
+    allocator*  frame;    // command scope, reset every frame
+    atomic_flag lock;     // drivers may allocate from their own threads
+    size_t      scope_live[VHOST_SCOPE_COUNT];
+    size_t      scope_peak[VHOST_SCOPE_COUNT];
+} vhost_allocator;
+
+typedef struct {
+    VkAllocationCallbacks* allocator;  // NULL or &host_callbacks
+    VkAllocationCallbacks  host_callbacks;
+    vhost_allocator        host;
+    allocator*             scratch;
+    uint32_t               owns_scratch;
     VkInstance             instance;
     VkSurfaceKHR           surface;
     vswapchain             swapchain;
@@ -107,6 +124,10 @@ typedef struct {
 //
 //=========================================================
 
+VkResult vcreate_host_allocator(vstate* v, allocator* general);
+void     vdestroy_host_allocator(vstate* v);
+void     vreset_host_frame(vstate* v);
+
 VkResult vcreate_instance(vstate* rdev);
 
 VkResult vcreate_device(vstate* rdev);
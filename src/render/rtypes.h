@@ -15,7 +15,10 @@ typedef enum {
 
 typedef struct {
     rdev_wnd   wnd_api;
+    // stack allocator for transient cpu memory, rdev only takes temp scopes
+    // out of it. when NULL rdev owns one and resets it every frame
     allocator* scratch_allocator;
+    // backs vulkan host allocations, must honour alignment. NULL uses libc
     allocator* allocator;
 } rdev_params;
 
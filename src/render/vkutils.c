@@ -23,13 +23,20 @@ VkBool32 vutl_present_supported_win32(VkPhysicalDevice d, uint32_t family) {
 }
 
 VkBool32 vutl_extensions_supported(VkPhysicalDevice d, const char** extensions,
-                                       uint32_t count) {
+                                   uint32_t count, allocator* scratch) {
     uint32_t ext_count = 0;
     vkEnumerateDeviceExtensionProperties(d, NULL, &ext_count, NULL);
-    VkExtensionProperties props[ext_count];
+    atemp                  temp = atemp_begin(scratch);
+    VkExtensionProperties* props =
+        aalloc_array(scratch, VkExtensionProperties, ext_count);
+    if (!props) {
+        atemp_end(temp);
+        return VK_FALSE;
+    }
 
     vkEnumerateDeviceExtensionProperties(d, NULL, &ext_count, props);
-    for (uint32_t i = 0; i < count; i++) {
+    VkBool32 supported = VK_TRUE;
+    for (uint32_t i = 0; i < count && supported; i++) {
         uint32_t found = 0;
         for (uint32_t j = 0; j < ext_count; j++) {
             if (!strcmp(extensions[i], props[j].extensionName)) {
@@ -38,14 +45,15 @@ VkBool32 vutl_extensions_supported(VkPhysicalDevice d, const char** extensions,
             }
         }
         if (!found) {
-            return VK_FALSE;
+            supported = VK_FALSE;
         }
     }
-
-    return VK_TRUE;
+    atemp_end(temp);
+    return supported;
 }
 
-queue_families vutl_find_queue_families(VkPhysicalDevice d, rdev_wnd window_api) {
+queue_families vutl_find_queue_families(VkPhysicalDevice d, rdev_wnd window_api,
+                                        allocator* scratch) {
     queue_families qf = {
         .graphics = UINT32_MAX,
         .compute = UINT32_MAX,
@@ -54,7 +62,13 @@ queue_families vutl_find_queue_families(VkPhysicalDevice d, rdev_wnd window_api)
 
     uint32_t queue_family_count = 0;
     vkGetPhysicalDeviceQueueFamilyProperties(d, &queue_family_count, NULL);
-    VkQueueFamilyProperties props[queue_family_count];
+    atemp                    temp = atemp_begin(scratch);
+    VkQueueFamilyProperties* props =
+        aalloc_array(scratch, VkQueueFamilyProperties, queue_family_count);
+    if (!props) {
+        atemp_end(temp);
+        return qf;
+    }
     vkGetPhysicalDeviceQueueFamilyProperties(d, &queue_family_count, props);
 
     for (uint32_t i = 0; i < queue_family_count; i++) {
@@ -112,6 +126,7 @@ queue_families vutl_find_queue_families(VkPhysicalDevice d, rdev_wnd window_api)
             }
         }
     }
+    atemp_end(temp);
     return qf;
 }
 
@@ -161,8 +176,8 @@ int32_t vutl_rate_device(device_info* info) {
     return score;
 }
 
-VkSurfaceFormatKHR vutl_find_surface_format(VkPhysicalDevice d,
-                                             VkSurfaceKHR     surf) {
+VkSurfaceFormatKHR vutl_find_surface_format(VkPhysicalDevice d, VkSurfaceKHR surf,
+                                            allocator* scratch) {
     const VkFormat desired_fmts[] = {
         VK_FORMAT_B8G8R8A8_UNORM,
         VK_FORMAT_R8G8B8A8_UNORM,
@@ -173,7 +188,13 @@ VkSurfaceFormatKHR vutl_find_surface_format(VkPhysicalDevice d,
 
     uint32_t count;
     vkGetPhysicalDeviceSurfaceFormatsKHR(d, surf, &count, NULL);
-    VkSurfaceFormatKHR formats[128];
+    atemp               temp = atemp_begin(scratch);
+    VkSurfaceFormatKHR* formats = aalloc_array(scratch, VkSurfaceFormatKHR, count);
+    VkSurfaceFormatKHR  result = {desired_fmts[0], color_space};
+    if (!formats || !count) {
+        atemp_end(temp);
+        return result;
+    }
     vkGetPhysicalDeviceSurfaceFormatsKHR(d, surf, &count, formats);
     const uint32_t desired_count = sizeof(desired_fmts) / sizeof(*desired_fmts);
 
@@ -181,12 +202,16 @@ VkSurfaceFormatKHR vutl_find_surface_format(VkPhysicalDevice d,
         for (size_t j = 0; j < count; j++) {
             if (formats[j].format == desired_fmts[i] &&
                 formats[j].colorSpace == color_space) {
-                return formats[j];
+                result = formats[j];
+                atemp_end(temp);
+                return result;
             }
         }
     }
     debug_log("desired image format not found, using available!\n");
-    return formats[0];
+    result = formats[0];
+    atemp_end(temp);
+    return result;
 }
 
 VkFormat vutl_find_depth_format(VkPhysicalDevice d) {
@@ -207,18 +232,28 @@ VkFormat vutl_find_depth_format(VkPhysicalDevice d) {
     return VK_FORMAT_UNDEFINED;
 }
 
-VkPresentModeKHR vutl_find_present_mode(VkPhysicalDevice d, VkSurfaceKHR surf) {
+VkPresentModeKHR vutl_find_present_mode(VkPhysicalDevice d, VkSurfaceKHR surf,
+                                        allocator* scratch) {
     uint32_t supported_count = 0;
     vkGetPhysicalDeviceSurfacePresentModesKHR(d, surf, &supported_count, NULL);
-    VkPresentModeKHR supported[supported_count];
+    atemp             temp = atemp_begin(scratch);
+    VkPresentModeKHR* supported =
+        aalloc_array(scratch, VkPresentModeKHR, supported_count);
+    if (!supported) {
+        atemp_end(temp);
+        return VK_PRESENT_MODE_FIFO_KHR;
+    }
     vkGetPhysicalDeviceSurfacePresentModesKHR(d, surf, &supported_count, supported);
     VkPresentModeKHR requested = VK_PRESENT_MODE_MAILBOX_KHR;
+    VkPresentModeKHR result = VK_PRESENT_MODE_FIFO_KHR;
     for (size_t i = 0; i < supported_count; i++) {
         if (requested == supported[i]) {
-            return supported[i];
+            result = supported[i];
+            break;
         }
     }
-    return VK_PRESENT_MODE_FIFO_KHR;
+    atemp_end(temp);
+    return result;
 }
 
 int32_t vutl_find_memory_type(VkPhysicalDevice d, uint32_t bits, uint32_t flags) {
@@ -25,17 +25,20 @@ VkBool32 vutl_present_supported_xcb(VkPhysicalDevice d, uint32_t family);
 VkBool32 vutl_present_supported_win32(VkPhysicalDevice d, uint32_t family);
 
 VkBool32 vutl_extensions_supported(VkPhysicalDevice d, const char** extensions,
-                                   uint32_t count);
+                                   uint32_t count, allocator* scratch);
 
 int32_t vutl_rate_device(device_info* info);
 
-queue_families vutl_find_queue_families(VkPhysicalDevice d, rdev_wnd window_api);
+queue_families vutl_find_queue_families(VkPhysicalDevice d, rdev_wnd window_api,
+                                        allocator* scratch);
 
-VkSurfaceFormatKHR vutl_find_surface_format(VkPhysicalDevice d, VkSurfaceKHR surf);
+VkSurfaceFormatKHR vutl_find_surface_format(VkPhysicalDevice d, VkSurfaceKHR surf,
+                                            allocator* scratch);
 
 VkFormat vutl_find_depth_format(VkPhysicalDevice d);
 
-VkPresentModeKHR vutl_find_present_mode(VkPhysicalDevice d, VkSurfaceKHR surf);
+VkPresentModeKHR vutl_find_present_mode(VkPhysicalDevice d, VkSurfaceKHR surf,
+                                        allocator* scratch);
 
 int32_t vutl_find_memory_type(VkPhysicalDevice d, uint32_t bits, uint32_t flags);
 